@@ -0,0 +1,311 @@
+#include "mm/bench.hpp"
+#include "mm/memory.hpp"
+#include "mm/iterator.hpp"
+#include "mm/string.hpp"
+#include "mm/span.hpp"
+#include "mm/views.hpp"
+#include "mm/deque.hpp"
+#include "mm/intrusive.hpp"
+#include "mm/timer_wheel.hpp"
+#include "mm/dynamic_bitset.hpp"
+
+namespace {
+	constexpr mm::size_t array_size = 1024;
+
+	struct payload {
+		mm::u64 value;
+		payload() : value(1) {}
+	};
+
+	int values[array_size];
+
+	void shared_ptr_copy_destroy(mm::u64 n) {
+		mm::shared_ptr<payload> ptr = mm::make_shared<payload>();
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			mm::shared_ptr<payload> copy(ptr);
+			mm::do_not_optimize(copy);
+		}
+	}
+
+	void shared_ptr_make_destroy(mm::u64 n) {
+		for (mm::u64 i = 0; i < n; ++i) {
+			mm::shared_ptr<payload> ptr = mm::make_shared<payload>();
+			mm::do_not_optimize(ptr);
+		}
+	}
+
+	void local_shared_ptr_copy_destroy(mm::u64 n) {
+		mm::local_shared_ptr<payload> ptr = mm::make_local_shared<payload>();
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			mm::local_shared_ptr<payload> copy(ptr);
+			mm::do_not_optimize(copy);
+		}
+	}
+
+	void unique_ptr_move(mm::u64 n) {
+		mm::unique_ptr<payload> a = mm::make_unique<payload>();
+		mm::unique_ptr<payload> b;
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			b = mm::move(a);
+			mm::do_not_optimize(b);
+			a = mm::move(b);
+			mm::do_not_optimize(a);
+		}
+	}
+
+	void default_allocator_allocate_free(mm::u64 n) {
+		mm::default_allocator<payload> alloc;
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			payload* p = alloc.allocate(1);
+			mm::do_not_optimize(p);
+			alloc.deallocate(p,1);
+		}
+	}
+
+	void allocator_traits_allocate_free(mm::u64 n) {
+		using traits = mm::allocator_traits<mm::default_allocator<payload>>;
+		mm::default_allocator<payload> alloc;
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			payload* p = traits::allocate(alloc,16);
+			mm::do_not_optimize(p);
+			traits::deallocate(alloc,p,16);
+		}
+	}
+
+	// n counts elements visited rather than passes over the array
+	void raw_pointer_loop(mm::u64 n) {
+		int sum = 0;
+
+		for (mm::u64 passes = n / array_size + 1; passes > 0; --passes) {
+			for (int* it = values; it != values + array_size; ++it) {
+				sum += *it;
+			}
+
+			mm::do_not_optimize(sum);
+		}
+	}
+
+	void reverse_iterator_loop(mm::u64 n) {
+		int sum = 0;
+
+		for (mm::u64 passes = n / array_size + 1; passes > 0; --passes) {
+			mm::reverse_iterator<int*> first(values + array_size);
+			mm::reverse_iterator<int*> last(values);
+
+			for (; first != last; ++first) {
+				sum += *first;
+			}
+
+			mm::do_not_optimize(sum);
+		}
+	}
+
+	void move_iterator_loop(mm::u64 n) {
+		int sum = 0;
+
+		for (mm::u64 passes = n / array_size + 1; passes > 0; --passes) {
+			mm::move_iterator<int*> first(values);
+			mm::move_iterator<int*> last(values + array_size);
+
+			for (; first != last; ++first) {
+				sum += *first;
+			}
+
+			mm::do_not_optimize(sum);
+		}
+	}
+
+	void advance_distance(mm::u64 n) {
+		for (mm::u64 i = 0; i < n; ++i) {
+			int* it = values;
+			mm::advance(it,static_cast<mm::ptrdiff_t>(i % array_size));
+			mm::ptrdiff_t d = mm::distance(values,it);
+			mm::do_not_optimize(d);
+		}
+	}
+
+	int copy_target[array_size];
+
+	void copy_contiguous(mm::u64 n) {
+		mm::span<const int> source(values);
+
+		for (mm::u64 passes = n / array_size + 1; passes > 0; --passes) {
+			mm::copy(source.begin(),source.end(),copy_target);
+			mm::clobber_memory();
+		}
+	}
+
+	void copy_reverse_iterator(mm::u64 n) {
+		for (mm::u64 passes = n / array_size + 1; passes > 0; --passes) {
+			mm::copy(mm::make_reverse_iterator(values + array_size),mm::make_reverse_iterator(values),copy_target);
+			mm::clobber_memory();
+		}
+	}
+
+	struct is_even {
+		bool operator()(int v) const { return (v & 1) == 0; }
+	};
+
+	struct square {
+		int operator()(int v) const { return v * v; }
+	};
+
+	void views_filter_transform(mm::u64 n) {
+		for (mm::u64 passes = n / array_size + 1; passes > 0; --passes) {
+			int sum = 0;
+
+			for (int v : values | mm::views::filter(is_even()) | mm::views::transform(square())) {
+				sum += v;
+			}
+
+			mm::do_not_optimize(sum);
+		}
+	}
+
+	// fixed size window sliding across block boundaries, emptied blocks are
+	// reused from the cache
+	void deque_sliding_window(mm::u64 n) {
+		mm::deque<payload> window;
+
+		for (mm::size_t i = 0; i < 64; ++i) {
+			window.emplace_back();
+		}
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			window.emplace_back();
+			window.pop_front();
+			mm::do_not_optimize(window.front());
+		}
+	}
+
+	struct lru_entry {
+		mm::list_hook hook;
+		mm::u64 value;
+	};
+
+	lru_entry lru_entries[array_size];
+
+	void intrusive_list_lru_touch(mm::u64 n) {
+		mm::intrusive_list<lru_entry,mm::member_hook<lru_entry,mm::list_hook,&lru_entry::hook>> lru;
+
+		for (lru_entry& entry : lru_entries) {
+			lru.push_back(entry);
+		}
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			lru.push_back(lru_entries[(i * 7) % array_size]);
+			mm::do_not_optimize(lru.front());
+		}
+	}
+
+	struct idle_timeout {
+		mm::timer timer;
+		mm::u64 fired;
+
+		idle_timeout() : timer(*this), fired(0) {}
+
+		void operator()(mm::timer&) {
+			++fired;
+		}
+	};
+
+	idle_timeout idle_timeouts[array_size];
+
+	// every connection sees traffic and pushes its idle timeout back
+	void timer_wheel_reschedule(mm::u64 n) {
+		mm::timer_wheel<> wheel;
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			wheel.schedule(idle_timeouts[i % array_size].timer,1000 + (i & 255));
+
+			if ((i % array_size) == 0) {
+				wheel.tick();
+			}
+		}
+
+		mm::do_not_optimize(wheel);
+	}
+
+	// live &= allocated over 1m ids, then count what is left
+	void dynamic_bitset_and_count(mm::u64 n) {
+		mm::dynamic_bitset<> live(1 << 20,true);
+		mm::dynamic_bitset<> allocated(1 << 20);
+
+		for (mm::size_t i = 0; i < allocated.size(); i += 3) {
+			allocated.set(i);
+		}
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			live &= allocated;
+			mm::do_not_optimize(live.count());
+		}
+	}
+
+	void string_copy_short(mm::u64 n) {
+		mm::string key("session_id");
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			mm::string copy(key);
+			mm::do_not_optimize(copy);
+		}
+	}
+
+	void string_copy_long(mm::u64 n) {
+		mm::string key("a key that is too long to be stored inline");
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			mm::string copy(key);
+			mm::do_not_optimize(copy);
+		}
+	}
+
+	void string_view_find(mm::u64 n) {
+		mm::string_view line("GET /index.html HTTP/1.1");
+
+		for (mm::u64 i = 0; i < n; ++i) {
+			mm::do_not_optimize(line);
+			mm::size_t pos = line.find("HTTP");
+			mm::do_not_optimize(pos);
+		}
+	}
+}
+
+int main(int argc,const char* argv[]) {
+	mm::bench_runner runner;
+
+	if (!runner.parse(argc,argv)) {
+		return EXIT_FAILURE;
+	}
+
+	for (mm::size_t i = 0; i < array_size; ++i) {
+		values[i] = static_cast<int>(i);
+	}
+
+	runner.run("shared_ptr/copy_destroy",&shared_ptr_copy_destroy);
+	runner.run("shared_ptr/make_destroy",&shared_ptr_make_destroy);
+	runner.run("local_shared_ptr/copy_destroy",&local_shared_ptr_copy_destroy);
+	runner.run("unique_ptr/move",&unique_ptr_move);
+	runner.run("default_allocator/allocate_free",&default_allocator_allocate_free);
+	runner.run("allocator_traits/allocate_free",&allocator_traits_allocate_free);
+	runner.run("iterator/raw_pointer",&raw_pointer_loop);
+	runner.run("iterator/reverse_iterator",&reverse_iterator_loop);
+	runner.run("iterator/move_iterator",&move_iterator_loop);
+	runner.run("iterator/advance_distance",&advance_distance);
+	runner.run("copy/contiguous",&copy_contiguous);
+	runner.run("copy/reverse_iterator",&copy_reverse_iterator);
+	runner.run("views/filter_transform",&views_filter_transform);
+	runner.run("deque/sliding_window",&deque_sliding_window);
+	runner.run("intrusive_list/lru_touch",&intrusive_list_lru_touch);
+	runner.run("timer_wheel/reschedule",&timer_wheel_reschedule);
+	runner.run("dynamic_bitset/and_count",&dynamic_bitset_and_count);
+	runner.run("string/copy_short",&string_copy_short);
+	runner.run("string/copy_long",&string_copy_long);
+	runner.run("string_view/find",&string_view_find);
+
+	return runner.finish();
+}
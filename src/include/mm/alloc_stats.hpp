@@ -0,0 +1,226 @@
+#ifndef MM_ALLOC_STATS_HPP
+#define MM_ALLOC_STATS_HPP
+#include "mm/common.hpp"
+
+// allocation counters, compiled in with TRACK_ALLOCATIONS (implied by DEBUG).
+// without it every hook is an empty inline function and the stats stay zero.
+// uses the __atomic builtins directly since common.hpp pulls this header in
+// before anything else is declared
+
+#if defined(TRACK_ALLOCATIONS) || defined(SAMPLE_ALLOCATIONS)
+#define HOOK_ALLOCATIONS
+#endif
+
+namespace mm {
+	// bucket i counts allocations of [2^(i-1),2^i) bytes, the last one everything larger
+	constexpr mm::size_t alloc_bucket_count = 40;
+
+	struct alloc_bucket_stats {
+		mm::u64 allocations;
+		mm::u64 frees;
+		mm::u64 bytes_live;
+		mm::u64 peak_bytes;
+	};
+
+	// the fields are read one at a time, so a snapshot taken under load is not an exact cut
+	struct alloc_stats {
+		mm::u64 allocations;
+		mm::u64 frees;
+		mm::u64 bytes_live;
+		mm::u64 peak_bytes;
+		alloc_bucket_stats buckets[alloc_bucket_count];
+	};
+
+	enum alloc_source {
+		ALLOC_SOURCE_NEW,
+		ALLOC_SOURCE_DEFAULT_ALLOCATOR,
+		ALLOC_SOURCE_ALIGNED_ALLOCATOR,
+		ALLOC_SOURCE_MMAP_ALLOCATOR,
+		ALLOC_SOURCE_NUMA_RESOURCE,
+		ALLOC_SOURCE_COUNT
+	};
+
+	namespace detail {
+		inline mm::size_t alloc_bucket(mm::size_t bytes) {
+			mm::size_t bucket = bytes ? 64 - __builtin_clzll(static_cast<unsigned long long>(bytes)) : 0;
+			return bucket < alloc_bucket_count ? bucket : alloc_bucket_count - 1;
+		}
+
+		inline void alloc_stats_raise_peak(mm::u64* peak,mm::u64 value) {
+			mm::u64 current = __atomic_load_n(peak,__ATOMIC_RELAXED);
+
+			while (value > current && !__atomic_compare_exchange_n(peak,&current,value,true,__ATOMIC_RELAXED,__ATOMIC_RELAXED)) {}
+		}
+	}
+
+	// trivially constructible so global instances are zero initialised before
+	// any constructor, including one that calls operator new, can run. other
+	// instances have to be value initialised (mm::alloc_counters counters {};)
+	class alloc_counters {
+	private:
+		mm::alloc_stats m_stats;
+
+	public:
+		void on_allocate(mm::size_t bytes) {
+			mm::alloc_bucket_stats& bucket = m_stats.buckets[detail::alloc_bucket(bytes)];
+
+			__atomic_fetch_add(&m_stats.allocations,1,__ATOMIC_RELAXED);
+			__atomic_fetch_add(&bucket.allocations,1,__ATOMIC_RELAXED);
+			detail::alloc_stats_raise_peak(&m_stats.peak_bytes,__atomic_add_fetch(&m_stats.bytes_live,bytes,__ATOMIC_RELAXED));
+			detail::alloc_stats_raise_peak(&bucket.peak_bytes,__atomic_add_fetch(&bucket.bytes_live,bytes,__ATOMIC_RELAXED));
+		}
+
+		void on_deallocate(mm::size_t bytes) {
+			mm::alloc_bucket_stats& bucket = m_stats.buckets[detail::alloc_bucket(bytes)];
+
+			__atomic_fetch_add(&m_stats.frees,1,__ATOMIC_RELAXED);
+			__atomic_fetch_add(&bucket.frees,1,__ATOMIC_RELAXED);
+			__atomic_fetch_sub(&m_stats.bytes_live,bytes,__ATOMIC_RELAXED);
+			__atomic_fetch_sub(&bucket.bytes_live,bytes,__ATOMIC_RELAXED);
+		}
+
+		mm::alloc_stats snapshot() const {
+			mm::alloc_stats stats;
+
+			stats.allocations = __atomic_load_n(&m_stats.allocations,__ATOMIC_RELAXED);
+			stats.frees = __atomic_load_n(&m_stats.frees,__ATOMIC_RELAXED);
+			stats.bytes_live = __atomic_load_n(&m_stats.bytes_live,__ATOMIC_RELAXED);
+			stats.peak_bytes = __atomic_load_n(&m_stats.peak_bytes,__ATOMIC_RELAXED);
+
+			for (mm::size_t i = 0; i < alloc_bucket_count; ++i) {
+				const mm::alloc_bucket_stats& from = m_stats.buckets[i];
+				mm::alloc_bucket_stats& to = stats.buckets[i];
+
+				to.allocations = __atomic_load_n(&from.allocations,__ATOMIC_RELAXED);
+				to.frees = __atomic_load_n(&from.frees,__ATOMIC_RELAXED);
+				to.bytes_live = __atomic_load_n(&from.bytes_live,__ATOMIC_RELAXED);
+				to.peak_bytes = __atomic_load_n(&from.peak_bytes,__ATOMIC_RELAXED);
+			}
+
+			return stats;
+		}
+
+		void reset() {
+			__atomic_store_n(&m_stats.allocations,0,__ATOMIC_RELAXED);
+			__atomic_store_n(&m_stats.frees,0,__ATOMIC_RELAXED);
+			__atomic_store_n(&m_stats.bytes_live,0,__ATOMIC_RELAXED);
+			__atomic_store_n(&m_stats.peak_bytes,0,__ATOMIC_RELAXED);
+
+			for (mm::alloc_bucket_stats& bucket : m_stats.buckets) {
+				__atomic_store_n(&bucket.allocations,0,__ATOMIC_RELAXED);
+				__atomic_store_n(&bucket.frees,0,__ATOMIC_RELAXED);
+				__atomic_store_n(&bucket.bytes_live,0,__ATOMIC_RELAXED);
+				__atomic_store_n(&bucket.peak_bytes,0,__ATOMIC_RELAXED);
+			}
+		}
+	};
+
+	// zero initialised like any static, so it needs no guard
+	inline mm::alloc_counters& alloc_source_counters(mm::alloc_source source) {
+		static mm::alloc_counters counters[ALLOC_SOURCE_COUNT];
+		return counters[source];
+	}
+
+	inline mm::alloc_stats allocation_stats(mm::alloc_source source) {
+		return mm::alloc_source_counters(source).snapshot();
+	}
+
+	namespace detail {
+		// defined in heap_profiler.hpp, which common.hpp includes with SAMPLE_ALLOCATIONS
+		inline void* heap_profile_allocate(mm::size_t bytes);
+		inline void heap_profile_free(void* sample,mm::size_t bytes);
+
+		#ifdef TRACK_ALLOCATIONS
+		inline void track_allocate(mm::alloc_counters* counters,mm::size_t bytes) {
+			if (counters) {
+				counters->on_allocate(bytes);
+			}
+		}
+
+		inline void track_deallocate(mm::alloc_counters* counters,mm::size_t bytes) {
+			if (counters) {
+				counters->on_deallocate(bytes);
+			}
+		}
+		#else
+		inline void track_allocate(mm::alloc_counters*,mm::size_t) {}
+		inline void track_deallocate(mm::alloc_counters*,mm::size_t) {}
+		#endif
+
+		#ifdef HOOK_ALLOCATIONS
+		// operator delete is not told the size, so hooked blocks carry it in a
+		// header that keeps the 16 byte alignment malloc guarantees, along with
+		// the heap profile bucket when the allocation was sampled
+		struct tracked_header {
+			mm::size_t size;
+			void* sample;
+		};
+
+		static_assert(sizeof(tracked_header) == 16,"tracked_header must preserve malloc alignment");
+
+		inline void* tracked_malloc(mm::size_t bytes,mm::alloc_source source) {
+			if (bytes > mm::size_t(-1) - sizeof(tracked_header)) {
+				return nullptr;
+			}
+
+			tracked_header* header = static_cast<tracked_header*>(malloc(bytes + sizeof(tracked_header)));
+
+			if (!header) {
+				return nullptr;
+			}
+
+			header->size = bytes;
+			header->sample = nullptr;
+
+			#ifdef TRACK_ALLOCATIONS
+			mm::alloc_source_counters(source).on_allocate(bytes);
+			#endif
+
+			#ifdef SAMPLE_ALLOCATIONS
+			header->sample = detail::heap_profile_allocate(bytes);
+			#endif
+
+			return header + 1;
+		}
+
+		inline void tracked_free(void* ptr,mm::alloc_source source) {
+			if (!ptr) {
+				return;
+			}
+
+			tracked_header* header = static_cast<tracked_header*>(ptr) - 1;
+
+			#ifdef TRACK_ALLOCATIONS
+			mm::alloc_source_counters(source).on_deallocate(header->size);
+			#endif
+
+			#ifdef SAMPLE_ALLOCATIONS
+			if (header->sample) {
+				detail::heap_profile_free(header->sample,header->size);
+			}
+			#endif
+
+			free(header);
+		}
+		#else
+		inline void* tracked_malloc(mm::size_t bytes,mm::alloc_source) {
+			return malloc(bytes);
+		}
+
+		inline void tracked_free(void* ptr,mm::alloc_source) {
+			free(ptr);
+		}
+		#endif
+	}
+}
+
+// defined here rather than in common.hpp so they follow tracked_malloc
+// whichever of the two headers a translation unit includes first
+void* operator new(mm::size_t bytes) { return mm::detail::tracked_malloc(bytes,mm::ALLOC_SOURCE_NEW); }
+void* operator new(mm::size_t bytes,void* ptr) { return ptr; }
+void* operator new[](mm::size_t bytes) { return mm::detail::tracked_malloc(bytes,mm::ALLOC_SOURCE_NEW); }
+void* operator new[](mm::size_t bytes,void* ptr) { return ptr; }
+void operator delete(void* ptr) { mm::detail::tracked_free(ptr,mm::ALLOC_SOURCE_NEW); }
+void operator delete[](void* ptr) { mm::detail::tracked_free(ptr,mm::ALLOC_SOURCE_NEW); }
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef MM_ATOMIC_HPP
+#define MM_ATOMIC_HPP
+#include "mm/type_traits.hpp"
+
+namespace mm {
+	enum memory_order {
+		memory_order_relaxed = __ATOMIC_RELAXED,
+		memory_order_consume = __ATOMIC_CONSUME,
+		memory_order_acquire = __ATOMIC_ACQUIRE,
+		memory_order_release = __ATOMIC_RELEASE,
+		memory_order_acq_rel = __ATOMIC_ACQ_REL,
+		memory_order_seq_cst = __ATOMIC_SEQ_CST
+	};
+
+	namespace detail {
+		// the failure order of a compare exchange may not contain a release
+		constexpr mm::memory_order cmpxchg_failure_order(mm::memory_order order) {
+			return order == mm::memory_order_acq_rel ? mm::memory_order_acquire
+			     : order == mm::memory_order_release ? mm::memory_order_relaxed
+			     : order;
+		}
+
+		// the builtins do byte arithmetic on pointers
+		template <class T> struct atomic_arithmetic_scale : mm::integral_constant<mm::size_t,1> {};
+		template <class T> struct atomic_arithmetic_scale<T*> : mm::integral_constant<mm::size_t,sizeof(T)> {};
+	}
+
+	template <class T>
+	class atomic {
+		STATIC_ASSERT(
+			mm::is_integral<T>::value || mm::is_pointer<T>::value || mm::is_enum<T>::value,
+			"mm::atomic only supports integral, pointer and enum types"
+		);
+
+	public:
+		using value_type = T;
+		using difference_type = mm::condition_t<mm::is_pointer<T>::value,mm::ptrdiff_t,T>;
+
+	private:
+		value_type m_value;
+
+		static constexpr difference_type scale(difference_type n) {
+			return n * difference_type(detail::atomic_arithmetic_scale<T>::value);
+		}
+
+	public:
+		atomic() = default;
+		constexpr atomic(value_type value) : m_value(value) {}
+
+		atomic(const atomic&) = delete;
+		atomic& operator=(const atomic&) = delete;
+
+		value_type load(mm::memory_order order = mm::memory_order_seq_cst) const {
+			return __atomic_load_n(&m_value,order);
+		}
+
+		void store(value_type value,mm::memory_order order = mm::memory_order_seq_cst) {
+			__atomic_store_n(&m_value,value,order);
+		}
+
+		value_type exchange(value_type value,mm::memory_order order = mm::memory_order_seq_cst) {
+			return __atomic_exchange_n(&m_value,value,order);
+		}
+
+		bool compare_exchange_weak(value_type& expected,value_type desired,mm::memory_order success,mm::memory_order failure) {
+			return __atomic_compare_exchange_n(&m_value,&expected,desired,true,success,failure);
+		}
+
+		bool compare_exchange_weak(value_type& expected,value_type desired,mm::memory_order order = mm::memory_order_seq_cst) {
+			return compare_exchange_weak(expected,desired,order,detail::cmpxchg_failure_order(order));
+		}
+
+		bool compare_exchange_strong(value_type& expected,value_type desired,mm::memory_order success,mm::memory_order failure) {
+			return __atomic_compare_exchange_n(&m_value,&expected,desired,false,success,failure);
+		}
+
+		bool compare_exchange_strong(value_type& expected,value_type desired,mm::memory_order order = mm::memory_order_seq_cst) {
+			return compare_exchange_strong(expected,desired,order,detail::cmpxchg_failure_order(order));
+		}
+
+		value_type fetch_add(difference_type n,mm::memory_order order = mm::memory_order_seq_cst) {
+			return __atomic_fetch_add(&m_value,scale(n),order);
+		}
+
+		value_type fetch_sub(difference_type n,mm::memory_order order = mm::memory_order_seq_cst) {
+			return __atomic_fetch_sub(&m_value,scale(n),order);
+		}
+
+		value_type fetch_and(value_type value,mm::memory_order order = mm::memory_order_seq_cst) {
+			return __atomic_fetch_and(&m_value,value,order);
+		}
+
+		value_type fetch_or(value_type value,mm::memory_order order = mm::memory_order_seq_cst) {
+			return __atomic_fetch_or(&m_value,value,order);
+		}
+
+		value_type fetch_xor(value_type value,mm::memory_order order = mm::memory_order_seq_cst) {
+			return __atomic_fetch_xor(&m_value,value,order);
+		}
+
+		operator value_type() const {
+			return load();
+		}
+
+		value_type operator=(value_type value) {
+			store(value);
+			return value;
+		}
+
+		value_type operator++() { return fetch_add(1) + 1; }
+		value_type operator--() { return fetch_sub(1) - 1; }
+		value_type operator++(int) { return fetch_add(1); }
+		value_type operator--(int) { return fetch_sub(1); }
+	};
+
+	inline void atomic_thread_fence(mm::memory_order order) {
+		__atomic_thread_fence(order);
+	}
+
+	inline void atomic_signal_fence(mm::memory_order order) {
+		__atomic_signal_fence(order);
+	}
+
+	// spin-wait hint, lets the sibling hyperthread run while we poll
+	inline void cpu_relax() {
+		#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+		#elif defined(__aarch64__)
+		asm volatile("yield" ::: "memory");
+		#endif
+	}
+}
+
+#endif
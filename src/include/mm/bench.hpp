@@ -0,0 +1,235 @@
+#ifndef MM_BENCH_HPP
+#define MM_BENCH_HPP
+#include <time.h>
+#include <string.h>
+#include "mm/common.hpp"
+
+// minimal microbenchmark harness. a case is a function that runs the operation
+// under test n times, the runner calibrates n so one repetition takes at least
+// min_repetition_ns, runs warmup repetitions, then records ns/op and cycles/op
+// for every timed repetition and reports the median and p99. values the
+// compiler could otherwise discard should be passed to do_not_optimize
+
+namespace mm {
+	template <class T>
+	inline void do_not_optimize(const T& value) {
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+
+	template <class T>
+	inline void do_not_optimize(T& value) {
+		asm volatile("" : "+r,m"(value) : : "memory");
+	}
+
+	// forces pending stores to be treated as observable
+	inline void clobber_memory() {
+		asm volatile("" : : : "memory");
+	}
+
+	namespace detail {
+		inline mm::u64 bench_now_ns() {
+			timespec ts;
+			clock_gettime(CLOCK_MONOTONIC,&ts);
+			return static_cast<mm::u64>(ts.tv_sec) * 1000000000ULL + static_cast<mm::u64>(ts.tv_nsec);
+		}
+
+		// reference cycles, zero where there is no time stamp counter
+		inline mm::u64 bench_now_cycles() {
+			#if defined(__x86_64__) || defined(__i386__)
+			return __builtin_ia32_rdtsc();
+			#else
+			return 0;
+			#endif
+		}
+
+		inline void bench_sort(double* values,mm::size_t n) {
+			for (mm::size_t i = 1; i < n; ++i) {
+				double value = values[i];
+				mm::size_t j = i;
+
+				for (; j > 0 && values[j - 1] > value; --j) {
+					values[j] = values[j - 1];
+				}
+
+				values[j] = value;
+			}
+		}
+
+		// nearest rank on sorted values
+		inline double bench_percentile(const double* sorted,mm::size_t n,mm::size_t percent) {
+			mm::size_t rank = (percent * n + 99) / 100;
+			return sorted[rank ? rank - 1 : 0];
+		}
+	}
+
+	struct bench_result {
+		const char* name;
+		mm::u64 iterations;
+		mm::size_t repetitions;
+		double median_ns;
+		double p99_ns;
+		double min_ns;
+		double median_cycles;
+		double p99_cycles;
+	};
+
+	class bench_runner {
+	public:
+		using bench_fn = void(*)(mm::u64);
+
+		static constexpr mm::size_t max_repetitions = 1000;
+
+	private:
+		mm::size_t m_warmup;
+		mm::size_t m_repetitions;
+		mm::u64 m_min_repetition_ns;
+		const char* m_filter;
+		bool m_json;
+		mm::size_t m_count;
+		double m_ns[max_repetitions];
+		double m_cycles[max_repetitions];
+
+		// doubles n until a single run is long enough to time reliably
+		mm::u64 calibrate(bench_fn fn) {
+			mm::u64 n = 1;
+
+			for (;;) {
+				mm::u64 start = detail::bench_now_ns();
+				fn(n);
+				mm::u64 elapsed = detail::bench_now_ns() - start;
+
+				if (elapsed >= m_min_repetition_ns || n >= (mm::u64(1) << 40)) {
+					return n;
+				}
+
+				n *= elapsed > 0 && m_min_repetition_ns / elapsed < 8 ? 2 : 8;
+			}
+		}
+
+		void report(const mm::bench_result& r) {
+			if (m_json) {
+				printf(
+					"%s\n\t{\"name\": \"%s\", \"iterations\": %llu, \"repetitions\": %zu, "
+					"\"median_ns\": %.3f, \"p99_ns\": %.3f, \"min_ns\": %.3f, "
+					"\"median_cycles\": %.3f, \"p99_cycles\": %.3f}",
+					m_count ? "," : "[",
+					r.name,
+					static_cast<unsigned long long>(r.iterations),
+					r.repetitions,
+					r.median_ns,
+					r.p99_ns,
+					r.min_ns,
+					r.median_cycles,
+					r.p99_cycles
+				);
+			} else {
+				if (m_count == 0) {
+					printf("%-40s %12s %12s %12s %12s\n","benchmark","median ns","p99 ns","median cyc","iterations");
+				}
+
+				printf(
+					"%-40s %12.3f %12.3f %12.3f %12llu\n",
+					r.name,
+					r.median_ns,
+					r.p99_ns,
+					r.median_cycles,
+					static_cast<unsigned long long>(r.iterations)
+				);
+			}
+		}
+
+	public:
+		bench_runner() :
+			m_warmup(3),
+			m_repetitions(31),
+			m_min_repetition_ns(1000000),
+			m_filter(nullptr),
+			m_json(false),
+			m_count(0)
+		{}
+
+		bench_runner(const bench_runner&) = delete;
+		bench_runner& operator=(const bench_runner&) = delete;
+
+		// --json, --filter=substring, --repetitions=n, --warmup=n, --min-time-ns=n
+		bool parse(int argc,const char* argv[]) {
+			for (int i = 1; i < argc; ++i) {
+				const char* arg = argv[i];
+
+				if (strcmp(arg,"--json") == 0) {
+					m_json = true;
+				} else if (strncmp(arg,"--filter=",9) == 0) {
+					m_filter = arg + 9;
+				} else if (strncmp(arg,"--repetitions=",14) == 0) {
+					m_repetitions = strtoul(arg + 14,nullptr,10);
+				} else if (strncmp(arg,"--warmup=",9) == 0) {
+					m_warmup = strtoul(arg + 9,nullptr,10);
+				} else if (strncmp(arg,"--min-time-ns=",14) == 0) {
+					m_min_repetition_ns = strtoull(arg + 14,nullptr,10);
+				} else {
+					fprintf(stderr,"usage: %s [--json] [--filter=name] [--repetitions=n] [--warmup=n] [--min-time-ns=n]\n",argv[0]);
+					return false;
+				}
+			}
+
+			if (m_repetitions == 0) {
+				m_repetitions = 1;
+			} else if (m_repetitions > max_repetitions) {
+				m_repetitions = max_repetitions;
+			}
+
+			return true;
+		}
+
+		void run(const char* name,bench_fn fn) {
+			if (m_filter && !strstr(name,m_filter)) {
+				return;
+			}
+
+			mm::u64 n = calibrate(fn);
+
+			for (mm::size_t i = 0; i < m_warmup; ++i) {
+				fn(n);
+			}
+
+			for (mm::size_t i = 0; i < m_repetitions; ++i) {
+				mm::u64 start_cycles = detail::bench_now_cycles();
+				mm::u64 start_ns = detail::bench_now_ns();
+				fn(n);
+				mm::u64 end_ns = detail::bench_now_ns();
+				mm::u64 end_cycles = detail::bench_now_cycles();
+
+				m_ns[i] = static_cast<double>(end_ns - start_ns) / static_cast<double>(n);
+				m_cycles[i] = static_cast<double>(end_cycles - start_cycles) / static_cast<double>(n);
+			}
+
+			detail::bench_sort(m_ns,m_repetitions);
+			detail::bench_sort(m_cycles,m_repetitions);
+
+			mm::bench_result result;
+			result.name = name;
+			result.iterations = n;
+			result.repetitions = m_repetitions;
+			result.median_ns = detail::bench_percentile(m_ns,m_repetitions,50);
+			result.p99_ns = detail::bench_percentile(m_ns,m_repetitions,99);
+			result.min_ns = m_ns[0];
+			result.median_cycles = detail::bench_percentile(m_cycles,m_repetitions,50);
+			result.p99_cycles = detail::bench_percentile(m_cycles,m_repetitions,99);
+
+			report(result);
+			++m_count;
+			fflush(stdout);
+		}
+
+		// closes the json array, returns the process exit code
+		int finish() {
+			if (m_json) {
+				printf(m_count ? "\n]\n" : "[]\n");
+			}
+
+			return 0;
+		}
+	};
+}
+
+#endif
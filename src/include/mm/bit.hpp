@@ -0,0 +1,42 @@
+#ifndef MM_BIT_HPP
+#define MM_BIT_HPP
+#include "mm/common.hpp"
+
+namespace mm {
+	// without -mpopcnt __builtin_popcountll is a call into libgcc, which is
+	// not linked, so fall back to the branch free bit count
+	inline int popcount(mm::u64 x) {
+	#if defined(__POPCNT__)
+		return __builtin_popcountll(x);
+	#else
+		x = x - ((x >> 1) & 0x5555555555555555ull);
+		x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+		x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+		return static_cast<int>((x * 0x0101010101010101ull) >> 56);
+	#endif
+	}
+
+	// 64 for 0
+	inline int countr_zero(mm::u64 x) {
+		return x ? __builtin_ctzll(x) : 64;
+	}
+
+	inline int countl_zero(mm::u64 x) {
+		return x ? __builtin_clzll(x) : 64;
+	}
+
+	inline int countr_one(mm::u64 x) {
+		return mm::countr_zero(~x);
+	}
+
+	constexpr bool has_single_bit(mm::u64 x) {
+		return x && !(x & (x - 1));
+	}
+
+	// index of the highest set bit plus one, 0 for 0
+	inline int bit_width(mm::u64 x) {
+		return 64 - mm::countl_zero(x);
+	}
+}
+
+#endif
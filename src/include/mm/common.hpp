@@ -5,14 +5,42 @@
 #include <stdlib.h>
 #include <stddef.h>
 
+// LOG_LEVEL shows the given level and everything above it, calls below it
+// compile to nothing. the SHOW_ flags can still be set one at a time
+#define LOG_LEVEL_PRINTF 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
 #ifdef DEBUG
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_PRINTF
+#endif
+#define TRACK_ALLOCATIONS
+#endif
+
+#ifdef LOG_LEVEL
+#if LOG_LEVEL <= LOG_LEVEL_PRINTF
 #define SHOW_PRINTF
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
 #define SHOW_INFO
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARNING
 #define SHOW_WARNINGS
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
 #define SHOW_ERRORS
 #endif
+#endif
 
-#ifdef SHOW_PRINTF
+// with ASYNC_LOGGING the macros below only enqueue a record (see log.hpp), the
+// format must then be a string literal. ERROR stays synchronous since it exits
+#if defined(SHOW_PRINTF) && defined(ASYNC_LOGGING)
+#define PRINTF(...)\
+	mm::detail::log_write(mm::LOG_PRINTF,"" __VA_ARGS__)
+#elif defined(SHOW_PRINTF)
 #define PRINTF(...)\
 	printf(__VA_ARGS__);\
 	printf("\n")
@@ -20,7 +48,10 @@
 #define PRINTF(...)
 #endif
 
-#ifdef SHOW_INFO
+#if defined(SHOW_INFO) && defined(ASYNC_LOGGING)
+#define INFO(...)\
+	mm::detail::log_write(mm::LOG_INFO,"" __VA_ARGS__)
+#elif defined(SHOW_INFO)
 #define INFO(...)\
 	printf("\033[36mINFO\033[0m: ");\
 	printf(__VA_ARGS__);\
@@ -29,7 +60,10 @@
 #define INFO(...)
 #endif
 
-#ifdef SHOW_WARNINGS
+#if defined(SHOW_WARNINGS) && defined(ASYNC_LOGGING)
+#define WARNING(...)\
+	mm::detail::log_write(mm::LOG_WARNING,"" __VA_ARGS__)
+#elif defined(SHOW_WARNINGS)
 #define WARNING(...)\
 	fprintf(stderr,"\033[33mWARNING\033[0m: ");\
 	fprintf(stderr,__VA_ARGS__);\
@@ -38,7 +72,14 @@
 #define WARNING(...)
 #endif
 
-#ifdef SHOW_ERRORS
+#if defined(SHOW_ERRORS) && defined(ASYNC_LOGGING)
+#define ERROR(code,...)\
+	mm::log_flush();\
+	fprintf(stderr,"\033[31mERROR\033[0m: ");\
+	fprintf(stderr,__VA_ARGS__);\
+	fprintf(stderr,"\n");\
+	exit(code)
+#elif defined(SHOW_ERRORS)
 #define ERROR(code,...)\
 	fprintf(stderr,"\033[31mERROR\033[0m: ");\
 	fprintf(stderr,__VA_ARGS__);\
@@ -56,7 +97,7 @@
 
 #define ASSERT(cond,code,...)\
 	if (!(cond)) {\
-		ERROR(__VA_ARGS__);\
+		ERROR(code,__VA_ARGS__);\
 	}
 
 #define STATIC_ASSERT(cond,msg)\
@@ -70,7 +111,7 @@ namespace mm {
 	using i32 = int32_t;
 	using i64 = int64_t;
 	using u8 = uint8_t;
-	using u16 = uint32_t;
+	using u16 = uint16_t;
 	using u32 = uint32_t;
 	using u64 = uint64_t;
 	using f32 = float;
@@ -78,14 +119,27 @@ namespace mm {
 	using size_t = size_t;
 	using ptrdiff_t = ptrdiff_t;
 	using nullptr_t = decltype(nullptr);
+
+	// smallest offset between two objects that avoids false sharing, and the
+	// largest size that is still promoted to share a cache line. apple arm
+	// cores use 128 byte lines
+#if defined(__aarch64__) && defined(__APPLE__)
+	constexpr mm::size_t hardware_destructive_interference_size = 128;
+#else
+	constexpr mm::size_t hardware_destructive_interference_size = 64;
+#endif
+	constexpr mm::size_t hardware_constructive_interference_size = 64;
 }
 
-void* operator new(mm::size_t bytes) { return malloc(bytes); }
-void* operator new(mm::size_t bytes,void* ptr) { return ptr; }
-void* operator new[](mm::size_t bytes) { return malloc(bytes); }
-void* operator new[](mm::size_t bytes,void* ptr) { return ptr; }
-void operator delete(void* ptr) { free(ptr); }
-void operator delete[](void* ptr) { free(ptr); }
+#include "mm/alloc_stats.hpp"
+
+#ifdef SAMPLE_ALLOCATIONS
+#include "mm/heap_profiler.hpp"
+#endif
+
+#ifdef ASYNC_LOGGING
+#include "mm/log.hpp"
+#endif
 
 #if defined(__GNUC__) || defined(__MINGW32__) || defined(__MINGW64__)
 extern "C" void __cxa_pure_virtual() {
@@ -0,0 +1,484 @@
+#ifndef MM_DEQUE_HPP
+#define MM_DEQUE_HPP
+#include "mm/memory.hpp"
+#include "mm/error.hpp"
+
+namespace mm {
+	namespace detail {
+		constexpr mm::size_t deque_floor_pow2(mm::size_t n,mm::size_t p = 1) {
+			return p * 2 > n ? p : detail::deque_floor_pow2(n,p * 2);
+		}
+
+		constexpr mm::size_t deque_log2(mm::size_t n) {
+			return n <= 1 ? 0 : 1 + detail::deque_log2(n / 2);
+		}
+
+		// about 4KB per block and never fewer than 16 elements, rounded down to
+		// a power of two so an index splits into block and offset with a shift
+		template <class T>
+		struct deque_block_elements : mm::integral_constant<mm::size_t,
+			detail::deque_floor_pow2(sizeof(T) * 16 > 4096 ? 16 : 4096 / sizeof(T))
+		> {};
+
+		// an absolute index into the block map, stays valid until the map is
+		// grown or recentred by a push
+		template <class T,bool Const>
+		class deque_iterator {
+		public:
+			using difference_type = mm::ptrdiff_t;
+			using value_type = T;
+			using pointer = mm::condition_t<Const,const T*,T*>;
+			using reference = mm::condition_t<Const,const T&,T&>;
+			using iterator_category = mm::random_access_iterator_tag;
+
+		private:
+			template <class U,bool C> friend class deque_iterator;
+
+			static constexpr mm::size_t shift = detail::deque_log2(detail::deque_block_elements<T>::value);
+			static constexpr mm::size_t mask = detail::deque_block_elements<T>::value - 1;
+
+			T* const* m_map;
+			mm::size_t m_index;
+
+		public:
+			deque_iterator() : m_map(nullptr), m_index(0) {}
+			deque_iterator(T* const* map,mm::size_t index) : m_map(map), m_index(index) {}
+
+			template <bool C = Const,mm::enable_if_t<C> = nullptr>
+			deque_iterator(const deque_iterator<T,false>& other) : m_map(other.m_map), m_index(other.m_index) {}
+
+			reference operator*() const { return m_map[m_index >> shift][m_index & mask]; }
+			pointer operator->() const { return mm::address_of(operator*()); }
+			reference operator[](difference_type n) const { return *(*this + n); }
+
+			deque_iterator& operator++() { ++m_index; return *this; }
+			deque_iterator& operator--() { --m_index; return *this; }
+			deque_iterator operator++(int) { deque_iterator tmp(*this); ++m_index; return tmp; }
+			deque_iterator operator--(int) { deque_iterator tmp(*this); --m_index; return tmp; }
+			deque_iterator& operator+=(difference_type n) { m_index += n; return *this; }
+			deque_iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+			deque_iterator operator+(difference_type n) const { return deque_iterator(m_map,m_index + n); }
+			deque_iterator operator-(difference_type n) const { return deque_iterator(m_map,m_index - n); }
+
+			template <bool C>
+			difference_type operator-(const deque_iterator<T,C>& other) const {
+				return static_cast<difference_type>(m_index - other.m_index);
+			}
+
+			template <bool C> bool operator==(const deque_iterator<T,C>& other) const { return m_index == other.m_index; }
+			template <bool C> bool operator!=(const deque_iterator<T,C>& other) const { return m_index != other.m_index; }
+			template <bool C> bool operator<(const deque_iterator<T,C>& other) const { return m_index < other.m_index; }
+			template <bool C> bool operator>(const deque_iterator<T,C>& other) const { return m_index > other.m_index; }
+			template <bool C> bool operator<=(const deque_iterator<T,C>& other) const { return m_index <= other.m_index; }
+			template <bool C> bool operator>=(const deque_iterator<T,C>& other) const { return m_index >= other.m_index; }
+		};
+	}
+
+	// double ended queue of fixed size blocks found through a block map.
+	// pushing and popping at either end is O(1) amortised and never moves an
+	// element, so references stay valid across pushes (iterators do not).
+	// blocks emptied by pops go to a free list threaded through the blocks
+	// themselves and are reused by later pushes, they are only returned to the
+	// allocator by shrink_to_fit and the destructor
+	template <class T,class Alloc = mm::default_allocator<T>>
+	class deque {
+	public:
+		using value_type = T;
+		using allocator_type = Alloc;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using reference = T&;
+		using const_reference = const T&;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using iterator = detail::deque_iterator<T,false>;
+		using const_iterator = detail::deque_iterator<T,true>;
+		using reverse_iterator = mm::reverse_iterator<iterator>;
+		using const_reverse_iterator = mm::reverse_iterator<const_iterator>;
+
+		static constexpr size_type block_elements = detail::deque_block_elements<T>::value;
+
+	private:
+		using alloc_traits = mm::allocator_traits<Alloc>;
+		using map_allocator = typename alloc_traits::template rebind_alloc<T*>;
+		using map_traits = mm::allocator_traits<map_allocator>;
+
+		STATIC_ASSERT((mm::is_same<typename alloc_traits::value_type,T>::value),"the allocator must allocate T");
+
+		static constexpr size_type shift = detail::deque_log2(block_elements);
+		static constexpr size_type mask = block_elements - 1;
+		static constexpr size_type min_map_size = 8;
+
+		mm::compressed_pair<T**,Alloc> m_map;
+		size_type m_map_size;
+		size_type m_start;
+		size_type m_size;
+		T* m_cache;
+
+		Alloc& get_alloc() { return m_map.second(); }
+
+		T& at_index(size_type index) const {
+			return m_map.first()[index >> shift][index & mask];
+		}
+
+		T* acquire_block() {
+			if (m_cache) {
+				T* block = m_cache;
+				memcpy(&m_cache,block,sizeof(T*));
+				return block;
+			}
+
+			T* block = alloc_traits::allocate(get_alloc(),block_elements);
+
+			if (!block) {
+				ERROR(mm::ERROR_FAILED_ALLOC,"%s",mm::error_msg[mm::ERROR_FAILED_ALLOC]);
+			}
+
+			return block;
+		}
+
+		void release_block(size_type block) {
+			T* p = m_map.first()[block];
+			memcpy(static_cast<void*>(p),&m_cache,sizeof(T*));
+			m_cache = p;
+			m_map.first()[block] = nullptr;
+		}
+
+		void reset_start() {
+			m_start = (m_map_size / 2) << shift;
+		}
+
+		// recentres the live blocks, growing the map when it is over half full,
+		// so there is a free slot at both ends
+		void make_room() {
+			size_type first = m_start >> shift;
+			size_type used = m_size ? ((m_start + m_size - 1) >> shift) - first + 1 : 0;
+			T** map = m_map.first();
+
+			if (m_map_size >= 2 * (used + 1)) {
+				size_type new_first = (m_map_size - used) / 2;
+
+				memmove(map + new_first,map + first,used * sizeof(T*));
+
+				for (size_type i = 0; i < new_first; ++i) {
+					map[i] = nullptr;
+				}
+
+				for (size_type i = new_first + used; i < m_map_size; ++i) {
+					map[i] = nullptr;
+				}
+
+				m_start = (new_first << shift) + (m_start & mask);
+				return;
+			}
+
+			size_type new_size = m_map_size * 2;
+
+			if (new_size < min_map_size) {
+				new_size = min_map_size;
+			}
+
+			if (new_size < 2 * (used + 1)) {
+				new_size = 2 * (used + 1);
+			}
+
+			map_allocator alloc(get_alloc());
+			T** new_map = map_traits::allocate(alloc,new_size);
+
+			if (!new_map) {
+				ERROR(mm::ERROR_FAILED_ALLOC,"%s",mm::error_msg[mm::ERROR_FAILED_ALLOC]);
+			}
+
+			size_type new_first = (new_size - used) / 2;
+
+			for (size_type i = 0; i < new_size; ++i) {
+				new_map[i] = nullptr;
+			}
+
+			if (used) {
+				memcpy(new_map + new_first,map + first,used * sizeof(T*));
+			}
+
+			if (map) {
+				map_traits::deallocate(alloc,map,m_map_size);
+			}
+
+			m_map.first() = new_map;
+			m_map_size = new_size;
+			m_start = (new_first << shift) + (m_start & mask);
+		}
+
+		// the slot just past the back, with its block present
+		T* back_slot() {
+			size_type index = m_start + m_size;
+
+			if ((index >> shift) >= m_map_size) {
+				make_room();
+				index = m_start + m_size;
+			}
+
+			T*& block = m_map.first()[index >> shift];
+
+			if (!block) {
+				block = acquire_block();
+			}
+
+			return block + (index & mask);
+		}
+
+		// the slot just before the front, with its block present
+		T* front_slot() {
+			if (m_start == 0) {
+				make_room();
+			}
+
+			size_type index = m_start - 1;
+			T*& block = m_map.first()[index >> shift];
+
+			if (!block) {
+				block = acquire_block();
+			}
+
+			return block + (index & mask);
+		}
+
+		void free_cache() {
+			while (m_cache) {
+				T* block = m_cache;
+				memcpy(&m_cache,block,sizeof(T*));
+				alloc_traits::deallocate(get_alloc(),block,block_elements);
+			}
+		}
+
+		void free_all() {
+			clear();
+			free_cache();
+
+			if (m_map.first()) {
+				map_allocator alloc(get_alloc());
+				map_traits::deallocate(alloc,m_map.first(),m_map_size);
+				m_map.first() = nullptr;
+			}
+
+			m_map_size = 0;
+			m_start = 0;
+		}
+
+		void steal(deque& other) {
+			m_map.first() = other.m_map.first();
+			m_map_size = other.m_map_size;
+			m_start = other.m_start;
+			m_size = other.m_size;
+			m_cache = other.m_cache;
+
+			other.m_map.first() = nullptr;
+			other.m_map_size = 0;
+			other.m_start = 0;
+			other.m_size = 0;
+			other.m_cache = nullptr;
+		}
+
+	public:
+		deque() : m_map(nullptr), m_map_size(0), m_start(0), m_size(0), m_cache(nullptr) {}
+
+		explicit deque(const Alloc& alloc) : m_map(nullptr,alloc), m_map_size(0), m_start(0), m_size(0), m_cache(nullptr) {}
+
+		deque(const deque& other) :
+			m_map(nullptr,alloc_traits::select_on_container_copy_construction(other.m_map.second())),
+			m_map_size(0),
+			m_start(0),
+			m_size(0),
+			m_cache(nullptr)
+		{
+			for (const T& value : other) {
+				emplace_back(value);
+			}
+		}
+
+		deque(deque&& other) : m_map(nullptr,mm::move(other.get_alloc())), m_map_size(0), m_start(0), m_size(0), m_cache(nullptr) {
+			steal(other);
+		}
+
+		~deque() {
+			free_all();
+		}
+
+		// reuses the blocks already held
+		deque& operator=(const deque& other) {
+			if (this != &other) {
+				clear();
+
+				for (const T& value : other) {
+					emplace_back(value);
+				}
+			}
+
+			return *this;
+		}
+
+		deque& operator=(deque&& other) {
+			if (this == &other) {
+				return *this;
+			}
+
+			if (alloc_traits::propagate_on_container_move_assignment::value) {
+				free_all();
+				get_alloc() = mm::move(other.get_alloc());
+				steal(other);
+			} else if (alloc_traits::is_always_equal::value || get_alloc() == other.get_alloc()) {
+				free_all();
+				steal(other);
+			} else {
+				clear();
+
+				for (T& value : other) {
+					emplace_back(mm::move(value));
+				}
+
+				other.clear();
+			}
+
+			return *this;
+		}
+
+		allocator_type get_allocator() const { return m_map.second(); }
+
+		iterator begin() { return iterator(m_map.first(),m_start); }
+		const_iterator begin() const { return const_iterator(m_map.first(),m_start); }
+		const_iterator cbegin() const { return const_iterator(m_map.first(),m_start); }
+		iterator end() { return iterator(m_map.first(),m_start + m_size); }
+		const_iterator end() const { return const_iterator(m_map.first(),m_start + m_size); }
+		const_iterator cend() const { return const_iterator(m_map.first(),m_start + m_size); }
+		reverse_iterator rbegin() { return reverse_iterator(end()); }
+		const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+		reverse_iterator rend() { return reverse_iterator(begin()); }
+		const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+		size_type size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+
+		// unchecked
+		T& operator[](size_type i) { return at_index(m_start + i); }
+		const T& operator[](size_type i) const { return at_index(m_start + i); }
+		T& front() { return at_index(m_start); }
+		const T& front() const { return at_index(m_start); }
+		T& back() { return at_index(m_start + m_size - 1); }
+		const T& back() const { return at_index(m_start + m_size - 1); }
+
+		template <class... Args>
+		T& emplace_back(Args&&... args) {
+			T* slot = back_slot();
+			mm::construct_at(slot,mm::forward<Args>(args)...);
+			++m_size;
+			return *slot;
+		}
+
+		template <class... Args>
+		T& emplace_front(Args&&... args) {
+			T* slot = front_slot();
+			mm::construct_at(slot,mm::forward<Args>(args)...);
+			--m_start;
+			++m_size;
+			return *slot;
+		}
+
+		void push_back(const T& value) { emplace_back(value); }
+		void push_back(T&& value) { emplace_back(mm::move(value)); }
+		void push_front(const T& value) { emplace_front(value); }
+		void push_front(T&& value) { emplace_front(mm::move(value)); }
+
+		void pop_back() {
+			size_type index = m_start + m_size - 1;
+			mm::destroy_at(mm::address_of(at_index(index)));
+			--m_size;
+
+			if (m_size == 0) {
+				release_block(index >> shift);
+				reset_start();
+			} else if ((index & mask) == 0) {
+				release_block(index >> shift);
+			}
+		}
+
+		void pop_front() {
+			size_type index = m_start;
+			mm::destroy_at(mm::address_of(at_index(index)));
+			++m_start;
+			--m_size;
+
+			if (m_size == 0) {
+				release_block(index >> shift);
+				reset_start();
+			} else if ((m_start & mask) == 0) {
+				release_block(index >> shift);
+			}
+		}
+
+		// keeps the blocks for reuse
+		void clear() {
+			if (m_size == 0) {
+				return;
+			}
+
+			for (size_type i = m_start; i < m_start + m_size; ++i) {
+				mm::destroy_at(mm::address_of(at_index(i)));
+			}
+
+			size_type last = (m_start + m_size - 1) >> shift;
+
+			for (size_type block = m_start >> shift; block <= last; ++block) {
+				release_block(block);
+			}
+
+			m_size = 0;
+			reset_start();
+		}
+
+		// returns cached blocks to the allocator
+		void shrink_to_fit() {
+			free_cache();
+		}
+
+		void swap(deque& other) {
+			mm::swap(m_map.first(),other.m_map.first());
+			mm::swap(m_map_size,other.m_map_size);
+			mm::swap(m_start,other.m_start);
+			mm::swap(m_size,other.m_size);
+			mm::swap(m_cache,other.m_cache);
+
+			if (alloc_traits::propagate_on_container_swap::value) {
+				mm::swap(get_alloc(),other.get_alloc());
+			}
+		}
+	};
+
+	template <class T,class Alloc>
+	constexpr typename mm::deque<T,Alloc>::size_type mm::deque<T,Alloc>::block_elements;
+
+	template <class T,class Alloc>
+	bool operator==(const mm::deque<T,Alloc>& lhs,const mm::deque<T,Alloc>& rhs) {
+		if (lhs.size() != rhs.size()) {
+			return false;
+		}
+
+		for (mm::size_t i = 0; i < lhs.size(); ++i) {
+			if (!(lhs[i] == rhs[i])) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	template <class T,class Alloc>
+	bool operator!=(const mm::deque<T,Alloc>& lhs,const mm::deque<T,Alloc>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class T,class Alloc>
+	void swap(mm::deque<T,Alloc>& lhs,mm::deque<T,Alloc>& rhs) {
+		lhs.swap(rhs);
+	}
+}
+
+#endif
@@ -0,0 +1,512 @@
+#ifndef MM_DYNAMIC_BITSET_HPP
+#define MM_DYNAMIC_BITSET_HPP
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "mm/memory.hpp"
+#include "mm/error.hpp"
+#include "mm/bit.hpp"
+
+namespace mm {
+	namespace detail {
+		struct bitset_and {
+			static mm::u64 apply(mm::u64 a,mm::u64 b) { return a & b; }
+		#if defined(__AVX2__)
+			static __m256i apply(__m256i a,__m256i b) { return _mm256_and_si256(a,b); }
+		#endif
+		};
+
+		struct bitset_or {
+			static mm::u64 apply(mm::u64 a,mm::u64 b) { return a | b; }
+		#if defined(__AVX2__)
+			static __m256i apply(__m256i a,__m256i b) { return _mm256_or_si256(a,b); }
+		#endif
+		};
+
+		struct bitset_xor {
+			static mm::u64 apply(mm::u64 a,mm::u64 b) { return a ^ b; }
+		#if defined(__AVX2__)
+			static __m256i apply(__m256i a,__m256i b) { return _mm256_xor_si256(a,b); }
+		#endif
+		};
+
+		struct bitset_and_not {
+			static mm::u64 apply(mm::u64 a,mm::u64 b) { return a & ~b; }
+		#if defined(__AVX2__)
+			static __m256i apply(__m256i a,__m256i b) { return _mm256_andnot_si256(b,a); }
+		#endif
+		};
+
+		// dst[i] = Op(dst[i],src[i]), 4 words at a time with avx2
+		template <class Op>
+		void bitset_apply(mm::u64* dst,const mm::u64* src,mm::size_t n) {
+			mm::size_t i = 0;
+
+		#if defined(__AVX2__)
+			for (; i + 4 <= n; i += 4) {
+				__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+				__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),Op::apply(a,b));
+			}
+		#endif
+
+			for (; i < n; ++i) {
+				dst[i] = Op::apply(dst[i],src[i]);
+			}
+		}
+
+		// avx2 counts nibbles with a shuffle lookup and sums bytes with sad,
+		// which beats one popcnt per word on long runs
+		inline mm::size_t bitset_count(const mm::u64* words,mm::size_t n) {
+			mm::size_t i = 0;
+			mm::size_t total = 0;
+
+		#if defined(__AVX2__)
+			const __m256i lookup = _mm256_setr_epi8(
+				0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+				0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4
+			);
+			const __m256i low = _mm256_set1_epi8(0x0f);
+			__m256i sum = _mm256_setzero_si256();
+
+			for (; i + 4 <= n; i += 4) {
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+				__m256i lo = _mm256_shuffle_epi8(lookup,_mm256_and_si256(v,low));
+				__m256i hi = _mm256_shuffle_epi8(lookup,_mm256_and_si256(_mm256_srli_epi16(v,4),low));
+				sum = _mm256_add_epi64(sum,_mm256_sad_epu8(_mm256_add_epi8(lo,hi),_mm256_setzero_si256()));
+			}
+
+			total += static_cast<mm::size_t>(_mm256_extract_epi64(sum,0));
+			total += static_cast<mm::size_t>(_mm256_extract_epi64(sum,1));
+			total += static_cast<mm::size_t>(_mm256_extract_epi64(sum,2));
+			total += static_cast<mm::size_t>(_mm256_extract_epi64(sum,3));
+		#endif
+
+			for (; i < n; ++i) {
+				total += static_cast<mm::size_t>(mm::popcount(words[i]));
+			}
+
+			return total;
+		}
+
+		// index of the first non zero word at or after i, n if none
+		inline mm::size_t bitset_next_word(const mm::u64* words,mm::size_t i,mm::size_t n) {
+		#if defined(__AVX2__)
+			for (; i + 4 <= n; i += 4) {
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+
+				if (!_mm256_testz_si256(v,v)) {
+					break;
+				}
+			}
+		#endif
+
+			for (; i < n && !words[i]; ++i) {}
+
+			return i;
+		}
+	}
+
+	// bits packed into u64 words, bit i is bit i % 64 of word i / 64. bits past
+	// size() in the last word are kept clear so whole words can be counted and
+	// compared. bulk operations work a word, or four with avx2, at a time
+	template <class Alloc = mm::default_allocator<mm::u64>>
+	class dynamic_bitset {
+	public:
+		using word_type = mm::u64;
+		using size_type = mm::size_t;
+		using allocator_type = Alloc;
+
+		static constexpr size_type bits_per_word = 64;
+		static constexpr size_type npos = size_type(-1);
+
+	private:
+		using alloc_traits = mm::allocator_traits<Alloc>;
+
+		STATIC_ASSERT((mm::is_same<typename alloc_traits::value_type,mm::u64>::value),"the allocator must allocate u64");
+
+		mm::compressed_pair<mm::u64*,Alloc> m_words;
+		size_type m_size;
+		size_type m_capacity;
+
+		static size_type words_for(size_type bits) {
+			return (bits + bits_per_word - 1) / bits_per_word;
+		}
+
+		Alloc& get_alloc() { return m_words.second(); }
+
+		void clear_tail() {
+			if (m_size % bits_per_word) {
+				m_words.first()[m_size / bits_per_word] &= (mm::u64(1) << (m_size % bits_per_word)) - 1;
+			}
+		}
+
+		// capacity in words
+		void reallocate(size_type capacity) {
+			mm::u64* words = capacity ? alloc_traits::allocate(get_alloc(),capacity) : nullptr;
+
+			if (capacity && !words) {
+				ERROR(mm::ERROR_FAILED_ALLOC,"%s",mm::error_msg[mm::ERROR_FAILED_ALLOC]);
+			}
+
+			if (m_words.first()) {
+				if (num_words()) {
+					memcpy(words,m_words.first(),num_words() * sizeof(mm::u64));
+				}
+
+				alloc_traits::deallocate(get_alloc(),m_words.first(),m_capacity);
+			}
+
+			m_words.first() = words;
+			m_capacity = capacity;
+		}
+
+		void free_all() {
+			if (m_words.first()) {
+				alloc_traits::deallocate(get_alloc(),m_words.first(),m_capacity);
+			}
+
+			m_words.first() = nullptr;
+			m_size = 0;
+			m_capacity = 0;
+		}
+
+		void steal(dynamic_bitset& other) {
+			m_words.first() = other.m_words.first();
+			m_size = other.m_size;
+			m_capacity = other.m_capacity;
+
+			other.m_words.first() = nullptr;
+			other.m_size = 0;
+			other.m_capacity = 0;
+		}
+
+		void copy_from(const dynamic_bitset& other) {
+			if (other.num_words() > m_capacity) {
+				free_all();
+				reallocate(other.num_words());
+			}
+
+			if (other.num_words()) {
+				memcpy(m_words.first(),other.m_words.first(),other.num_words() * sizeof(mm::u64));
+			}
+
+			m_size = other.m_size;
+		}
+
+	public:
+		dynamic_bitset() : m_words(nullptr), m_size(0), m_capacity(0) {}
+
+		explicit dynamic_bitset(const Alloc& alloc) : m_words(nullptr,alloc), m_size(0), m_capacity(0) {}
+
+		explicit dynamic_bitset(size_type n,bool value = false,const Alloc& alloc = Alloc()) : m_words(nullptr,alloc), m_size(0), m_capacity(0) {
+			resize(n,value);
+		}
+
+		dynamic_bitset(const dynamic_bitset& other) :
+			m_words(nullptr,alloc_traits::select_on_container_copy_construction(other.m_words.second())),
+			m_size(0),
+			m_capacity(0)
+		{
+			copy_from(other);
+		}
+
+		dynamic_bitset(dynamic_bitset&& other) : m_words(nullptr,mm::move(other.get_alloc())), m_size(0), m_capacity(0) {
+			steal(other);
+		}
+
+		~dynamic_bitset() {
+			free_all();
+		}
+
+		dynamic_bitset& operator=(const dynamic_bitset& other) {
+			if (this != &other) {
+				copy_from(other);
+			}
+
+			return *this;
+		}
+
+		dynamic_bitset& operator=(dynamic_bitset&& other) {
+			if (this == &other) {
+				return *this;
+			}
+
+			if (alloc_traits::propagate_on_container_move_assignment::value) {
+				free_all();
+				get_alloc() = mm::move(other.get_alloc());
+				steal(other);
+			} else if (alloc_traits::is_always_equal::value || get_alloc() == other.get_alloc()) {
+				free_all();
+				steal(other);
+			} else {
+				copy_from(other);
+				other.clear();
+			}
+
+			return *this;
+		}
+
+		allocator_type get_allocator() const { return m_words.second(); }
+
+		size_type size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+		size_type capacity() const { return m_capacity * bits_per_word; }
+		size_type num_words() const { return words_for(m_size); }
+
+		// bits past size() in the last word must stay clear
+		mm::u64* data() { return m_words.first(); }
+		const mm::u64* data() const { return m_words.first(); }
+
+		// unchecked
+		bool test(size_type i) const {
+			return (m_words.first()[i / bits_per_word] >> (i % bits_per_word)) & 1;
+		}
+
+		bool operator[](size_type i) const {
+			return test(i);
+		}
+
+		dynamic_bitset& set(size_type i) {
+			m_words.first()[i / bits_per_word] |= mm::u64(1) << (i % bits_per_word);
+			return *this;
+		}
+
+		dynamic_bitset& set(size_type i,bool value) {
+			return value ? set(i) : reset(i);
+		}
+
+		dynamic_bitset& reset(size_type i) {
+			m_words.first()[i / bits_per_word] &= ~(mm::u64(1) << (i % bits_per_word));
+			return *this;
+		}
+
+		dynamic_bitset& flip(size_type i) {
+			m_words.first()[i / bits_per_word] ^= mm::u64(1) << (i % bits_per_word);
+			return *this;
+		}
+
+		dynamic_bitset& set() {
+			if (m_size) {
+				memset(m_words.first(),0xff,num_words() * sizeof(mm::u64));
+				clear_tail();
+			}
+
+			return *this;
+		}
+
+		dynamic_bitset& reset() {
+			if (m_size) {
+				memset(m_words.first(),0,num_words() * sizeof(mm::u64));
+			}
+
+			return *this;
+		}
+
+		dynamic_bitset& flip() {
+			for (size_type i = 0; i < num_words(); ++i) {
+				m_words.first()[i] = ~m_words.first()[i];
+			}
+
+			clear_tail();
+			return *this;
+		}
+
+		void reserve(size_type bits) {
+			if (words_for(bits) > m_capacity) {
+				reallocate(words_for(bits));
+			}
+		}
+
+		void resize(size_type n,bool value = false) {
+			size_type old_words = num_words();
+			size_type new_words = words_for(n);
+
+			if (new_words > m_capacity) {
+				size_type grown = m_capacity * 2;
+				reallocate(new_words > grown ? new_words : grown);
+			}
+
+			if (n > m_size) {
+				// the tail of the old last word is already clear
+				if (value && m_size % bits_per_word) {
+					m_words.first()[old_words - 1] |= ~mm::u64(0) << (m_size % bits_per_word);
+				}
+
+				if (new_words > old_words) {
+					memset(m_words.first() + old_words,value ? 0xff : 0,(new_words - old_words) * sizeof(mm::u64));
+				}
+			}
+
+			m_size = n;
+			clear_tail();
+		}
+
+		void push_back(bool value) {
+			resize(m_size + 1,value);
+		}
+
+		void clear() {
+			m_size = 0;
+		}
+
+		void shrink_to_fit() {
+			if (num_words() < m_capacity) {
+				reallocate(num_words());
+			}
+		}
+
+		size_type count() const {
+			return detail::bitset_count(m_words.first(),num_words());
+		}
+
+		bool any() const {
+			return detail::bitset_next_word(m_words.first(),0,num_words()) != num_words();
+		}
+
+		bool none() const {
+			return !any();
+		}
+
+		bool all() const {
+			return count() == m_size;
+		}
+
+		// npos when no bit is set
+		size_type find_first() const {
+			return find_from(0);
+		}
+
+		// first set bit after i
+		size_type find_next(size_type i) const {
+			return i + 1 >= m_size ? npos : find_from(i + 1);
+		}
+
+		// first set bit at or after i
+		size_type find_from(size_type i) const {
+			if (i >= m_size) {
+				return npos;
+			}
+
+			const mm::u64* words = m_words.first();
+			size_type w = i / bits_per_word;
+			mm::u64 word = words[w] & (~mm::u64(0) << (i % bits_per_word));
+
+			if (!word) {
+				w = detail::bitset_next_word(words,w + 1,num_words());
+
+				if (w == num_words()) {
+					return npos;
+				}
+
+				word = words[w];
+			}
+
+			return w * bits_per_word + static_cast<size_type>(mm::countr_zero(word));
+		}
+
+		// the bulk operations need equal sizes, unchecked
+		dynamic_bitset& operator&=(const dynamic_bitset& other) {
+			detail::bitset_apply<detail::bitset_and>(m_words.first(),other.m_words.first(),num_words());
+			return *this;
+		}
+
+		dynamic_bitset& operator|=(const dynamic_bitset& other) {
+			detail::bitset_apply<detail::bitset_or>(m_words.first(),other.m_words.first(),num_words());
+			return *this;
+		}
+
+		dynamic_bitset& operator^=(const dynamic_bitset& other) {
+			detail::bitset_apply<detail::bitset_xor>(m_words.first(),other.m_words.first(),num_words());
+			return *this;
+		}
+
+		// and not, clears every bit set in other
+		dynamic_bitset& operator-=(const dynamic_bitset& other) {
+			detail::bitset_apply<detail::bitset_and_not>(m_words.first(),other.m_words.first(),num_words());
+			return *this;
+		}
+
+		bool intersects(const dynamic_bitset& other) const {
+			for (size_type i = 0; i < num_words(); ++i) {
+				if (m_words.first()[i] & other.m_words.first()[i]) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool is_subset_of(const dynamic_bitset& other) const {
+			for (size_type i = 0; i < num_words(); ++i) {
+				if (m_words.first()[i] & ~other.m_words.first()[i]) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		void swap(dynamic_bitset& other) {
+			mm::swap(m_words.first(),other.m_words.first());
+			mm::swap(m_size,other.m_size);
+			mm::swap(m_capacity,other.m_capacity);
+
+			if (alloc_traits::propagate_on_container_swap::value) {
+				mm::swap(get_alloc(),other.get_alloc());
+			}
+		}
+	};
+
+	template <class Alloc>
+	constexpr typename mm::dynamic_bitset<Alloc>::size_type mm::dynamic_bitset<Alloc>::bits_per_word;
+
+	template <class Alloc>
+	constexpr typename mm::dynamic_bitset<Alloc>::size_type mm::dynamic_bitset<Alloc>::npos;
+
+	template <class Alloc>
+	bool operator==(const mm::dynamic_bitset<Alloc>& lhs,const mm::dynamic_bitset<Alloc>& rhs) {
+		return lhs.size() == rhs.size() && (lhs.empty() || memcmp(lhs.data(),rhs.data(),lhs.num_words() * sizeof(mm::u64)) == 0);
+	}
+
+	template <class Alloc>
+	bool operator!=(const mm::dynamic_bitset<Alloc>& lhs,const mm::dynamic_bitset<Alloc>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class Alloc>
+	mm::dynamic_bitset<Alloc> operator&(const mm::dynamic_bitset<Alloc>& lhs,const mm::dynamic_bitset<Alloc>& rhs) {
+		mm::dynamic_bitset<Alloc> result(lhs);
+		result &= rhs;
+		return result;
+	}
+
+	template <class Alloc>
+	mm::dynamic_bitset<Alloc> operator|(const mm::dynamic_bitset<Alloc>& lhs,const mm::dynamic_bitset<Alloc>& rhs) {
+		mm::dynamic_bitset<Alloc> result(lhs);
+		result |= rhs;
+		return result;
+	}
+
+	template <class Alloc>
+	mm::dynamic_bitset<Alloc> operator^(const mm::dynamic_bitset<Alloc>& lhs,const mm::dynamic_bitset<Alloc>& rhs) {
+		mm::dynamic_bitset<Alloc> result(lhs);
+		result ^= rhs;
+		return result;
+	}
+
+	template <class Alloc>
+	mm::dynamic_bitset<Alloc> operator-(const mm::dynamic_bitset<Alloc>& lhs,const mm::dynamic_bitset<Alloc>& rhs) {
+		mm::dynamic_bitset<Alloc> result(lhs);
+		result -= rhs;
+		return result;
+	}
+
+	template <class Alloc>
+	void swap(mm::dynamic_bitset<Alloc>& lhs,mm::dynamic_bitset<Alloc>& rhs) {
+		lhs.swap(rhs);
+	}
+}
+
+#endif
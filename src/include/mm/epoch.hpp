@@ -0,0 +1,355 @@
+#ifndef MM_EPOCH_HPP
+#define MM_EPOCH_HPP
+#include <pthread.h>
+#include "mm/memory.hpp"
+#include "mm/error.hpp"
+
+namespace mm {
+	class epoch_domain;
+
+	namespace detail {
+		struct epoch_batch {
+			static constexpr mm::size_t capacity = 64;
+
+			epoch_batch* next;
+			mm::u64 epoch;
+			mm::size_t size;
+			detail::deferred_delete entries[capacity];
+
+			epoch_batch() : next(nullptr), epoch(0), size(0) {}
+
+			void reclaim() {
+				for (mm::size_t i = 0; i < size; ++i) {
+					entries[i]();
+				}
+
+				size = 0;
+			}
+		};
+
+		// one per thread per domain, records are never unlinked and are reused
+		// once their thread exits. aligned to a cache line so announcing an epoch
+		// never invalidates a neighbouring thread's record
+		struct alignas(mm::hardware_destructive_interference_size) epoch_record {
+			mm::atomic<mm::u64> state; // (epoch << 1) | active
+			mm::atomic<bool> in_use;
+			epoch_record* next;
+			epoch_domain* domain;
+
+			// only touched by the owning thread
+			mm::u32 depth;
+			epoch_batch* current;
+			epoch_batch* limbo_head;
+			epoch_batch* limbo_tail;
+
+			epoch_record(epoch_domain* d) :
+				state(0),
+				in_use(true),
+				next(nullptr),
+				domain(d),
+				depth(0),
+				current(nullptr),
+				limbo_head(nullptr),
+				limbo_tail(nullptr)
+			{}
+		};
+	}
+
+	// epoch based reclamation. readers pin the current epoch with an epoch_guard
+	// while they hold references into a shared structure, writers unlink nodes
+	// and retire() them. retired nodes are queued in per-thread batches stamped
+	// with the global epoch once full, and a batch is reclaimed after the global
+	// epoch has advanced twice past its stamp, at which point every reader that
+	// could have seen its nodes has left. the epoch only advances once every
+	// active reader has observed the current one, so a stalled reader delays
+	// reclamation for the whole domain (see hazard_pointer.hpp for a bounded
+	// alternative)
+	class epoch_domain {
+	private:
+		mm::atomic<mm::u64> m_epoch;
+		mm::atomic<detail::epoch_record*> m_records;
+		mm::atomic<detail::epoch_batch*> m_orphans;
+		pthread_key_t m_key;
+
+		static void thread_exit(void* record) {
+			detail::epoch_record* self = static_cast<detail::epoch_record*>(record);
+			self->domain->release_record(self);
+		}
+
+		detail::epoch_record* acquire_record() {
+			for (detail::epoch_record* it = m_records.load(mm::memory_order_acquire); it; it = it->next) {
+				bool expected = false;
+
+				if (!it->in_use.load(mm::memory_order_relaxed) && it->in_use.compare_exchange_strong(expected,true,mm::memory_order_acquire)) {
+					return it;
+				}
+			}
+
+			void* memory = aligned_alloc(alignof(detail::epoch_record),sizeof(detail::epoch_record));
+
+			if (!memory) {
+				ERROR(mm::ERROR_FAILED_ALLOC,"%s",mm::error_msg[mm::ERROR_FAILED_ALLOC]);
+			}
+
+			detail::epoch_record* record = mm::construct_at(static_cast<detail::epoch_record*>(memory),this);
+			detail::epoch_record* head = m_records.load(mm::memory_order_relaxed);
+
+			do {
+				record->next = head;
+			} while (!m_records.compare_exchange_weak(head,record,mm::memory_order_release,mm::memory_order_relaxed));
+
+			return record;
+		}
+
+		// hands any pending batches to the domain and frees the record for reuse
+		void release_record(detail::epoch_record* record) {
+			close_batch(record);
+
+			if (record->limbo_head) {
+				push_orphans(record->limbo_head,record->limbo_tail);
+				record->limbo_head = record->limbo_tail = nullptr;
+			}
+
+			record->depth = 0;
+			record->state.store(0,mm::memory_order_release);
+			record->in_use.store(false,mm::memory_order_release);
+		}
+
+		void push_orphans(detail::epoch_batch* head,detail::epoch_batch* tail) {
+			detail::epoch_batch* orphans = m_orphans.load(mm::memory_order_relaxed);
+
+			do {
+				tail->next = orphans;
+			} while (!m_orphans.compare_exchange_weak(orphans,head,mm::memory_order_release,mm::memory_order_relaxed));
+		}
+
+		void close_batch(detail::epoch_record* record) {
+			detail::epoch_batch* batch = record->current;
+
+			if (!batch || batch->size == 0) {
+				return;
+			}
+
+			batch->epoch = m_epoch.load(mm::memory_order_acquire);
+			batch->next = nullptr;
+
+			if (record->limbo_tail) {
+				record->limbo_tail->next = batch;
+			} else {
+				record->limbo_head = batch;
+			}
+
+			record->limbo_tail = batch;
+			record->current = nullptr;
+		}
+
+		// batches are appended in epoch order, so reclaiming stops at the first young one
+		void reclaim_limbo(detail::epoch_record* record,mm::u64 epoch) {
+			while (record->limbo_head && record->limbo_head->epoch + 2 <= epoch) {
+				detail::epoch_batch* batch = record->limbo_head;
+				record->limbo_head = batch->next;
+				batch->reclaim();
+				recycle_batch(record,batch);
+			}
+
+			if (!record->limbo_head) {
+				record->limbo_tail = nullptr;
+			}
+		}
+
+		void reclaim_orphans(mm::u64 epoch) {
+			if (!m_orphans.load(mm::memory_order_relaxed)) {
+				return;
+			}
+
+			detail::epoch_batch* batch = m_orphans.exchange(nullptr,mm::memory_order_acquire);
+
+			while (batch) {
+				detail::epoch_batch* next = batch->next;
+
+				if (batch->epoch + 2 <= epoch) {
+					batch->reclaim();
+					delete batch;
+				} else {
+					push_orphans(batch,batch);
+				}
+
+				batch = next;
+			}
+		}
+
+		// keeps one spare batch around so steady state retiring never allocates
+		void recycle_batch(detail::epoch_record* record,detail::epoch_batch* batch) {
+			if (!record->current) {
+				batch->next = nullptr;
+				record->current = batch;
+			} else {
+				delete batch;
+			}
+		}
+
+		bool try_advance(mm::u64 epoch) {
+			for (detail::epoch_record* it = m_records.load(mm::memory_order_acquire); it; it = it->next) {
+				mm::u64 state = it->state.load(mm::memory_order_acquire);
+
+				if ((state & 1) && (state >> 1) != epoch) {
+					return false;
+				}
+			}
+
+			return m_epoch.compare_exchange_strong(epoch,epoch + 1,mm::memory_order_acq_rel);
+		}
+
+		void collect(detail::epoch_record* record) {
+			mm::u64 epoch = m_epoch.load(mm::memory_order_acquire);
+
+			if (try_advance(epoch)) {
+				++epoch;
+			}
+
+			reclaim_limbo(record,epoch);
+			reclaim_orphans(epoch);
+		}
+
+	public:
+		epoch_domain() : m_epoch(2), m_records(nullptr), m_orphans(nullptr) {
+			pthread_key_create(&m_key,&epoch_domain::thread_exit);
+		}
+
+		epoch_domain(const epoch_domain&) = delete;
+		epoch_domain& operator=(const epoch_domain&) = delete;
+
+		// every thread must have left the domain, anything still retired is reclaimed
+		~epoch_domain() {
+			pthread_key_delete(m_key);
+
+			detail::epoch_record* record = m_records.load(mm::memory_order_acquire);
+
+			while (record) {
+				detail::epoch_record* next = record->next;
+
+				close_batch(record);
+				reclaim_limbo(record,mm::numeric_limits<mm::u64>::max);
+				delete record->current;
+				mm::destroy_at(record);
+				free(record);
+
+				record = next;
+			}
+
+			reclaim_orphans(mm::numeric_limits<mm::u64>::max);
+		}
+
+		// the calling thread's record, registered on first use
+		detail::epoch_record* record() {
+			detail::epoch_record* record = static_cast<detail::epoch_record*>(pthread_getspecific(m_key));
+
+			if (!record) {
+				record = acquire_record();
+				pthread_setspecific(m_key,record);
+			}
+
+			return record;
+		}
+
+		void enter(detail::epoch_record* record) {
+			if (record->depth++ > 0) {
+				return;
+			}
+
+			mm::u64 epoch = m_epoch.load(mm::memory_order_relaxed);
+
+			// the announcement has to be visible before we read any shared pointers
+			for (;;) {
+				record->state.store((epoch << 1) | 1,mm::memory_order_relaxed);
+				mm::atomic_thread_fence(mm::memory_order_seq_cst);
+
+				mm::u64 current = m_epoch.load(mm::memory_order_relaxed);
+
+				if (current == epoch) {
+					break;
+				}
+
+				epoch = current;
+			}
+		}
+
+		void leave(detail::epoch_record* record) {
+			if (--record->depth > 0) {
+				return;
+			}
+
+			record->state.store(record->state.load(mm::memory_order_relaxed) & ~mm::u64(1),mm::memory_order_release);
+		}
+
+		// ptr must already be unreachable for new readers. defers the unique_ptr's
+		// deleter, stateless deleters such as default_delete cost no extra allocation
+		template <class T,class Deleter>
+		void retire(mm::unique_ptr<T,Deleter>&& ptr) {
+			if (!ptr) {
+				return;
+			}
+
+			detail::epoch_record* self = record();
+
+			if (!self->current) {
+				self->current = new detail::epoch_batch();
+			}
+
+			detail::epoch_batch* batch = self->current;
+			batch->entries[batch->size++] = detail::make_deferred_delete(mm::move(ptr));
+
+			if (batch->size == detail::epoch_batch::capacity) {
+				close_batch(self);
+				collect(self);
+			}
+		}
+
+		template <class T>
+		void retire(T* ptr) {
+			retire(mm::unique_ptr<T>(ptr));
+		}
+
+		// closes the calling thread's batch and reclaims whatever is old enough
+		void flush() {
+			detail::epoch_record* self = record();
+			close_batch(self);
+			collect(self);
+		}
+
+		mm::u64 epoch() const {
+			return m_epoch.load(mm::memory_order_relaxed);
+		}
+	};
+
+	// pins the domain's epoch for the lifetime of the guard, guards may nest
+	class epoch_guard {
+	private:
+		mm::epoch_domain& m_domain;
+		detail::epoch_record* m_record;
+
+	public:
+		explicit epoch_guard(mm::epoch_domain& domain) : m_domain(domain), m_record(domain.record()) {
+			m_domain.enter(m_record);
+		}
+
+		epoch_guard(const epoch_guard&) = delete;
+		epoch_guard& operator=(const epoch_guard&) = delete;
+
+		~epoch_guard() {
+			m_domain.leave(m_record);
+		}
+
+		template <class T,class Deleter>
+		void retire(mm::unique_ptr<T,Deleter>&& ptr) {
+			m_domain.retire(mm::move(ptr));
+		}
+
+		template <class T>
+		void retire(T* ptr) {
+			m_domain.retire(ptr);
+		}
+	};
+}
+
+#endif
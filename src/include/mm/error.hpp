@@ -5,13 +5,21 @@ namespace mm {
 	enum  error {
 		ERROR_GENERAL = 1,
 		ERROR_FAILED_ALLOC,
-		ERROR_UNITIALIZED_OPTIONAL
+		ERROR_UNITIALIZED_OPTIONAL,
+		ERROR_BAD_EXPECTED_ACCESS,
+		ERROR_BAD_VARIANT_ACCESS,
+		ERROR_CAPACITY_EXCEEDED
 	};
 
+	// indexed by mm::error, g++ does not support designated array initializers
 	const char *error_msg[] = {
-		[ERROR_GENERAL] = "",
-		[ERROR_FAILED_ALLOC] = "failed to allocate memory",
-		[ERROR_UNITIALIZED_OPTIONAL] = "tried to accessed unitialized optional"
+		"",
+		"",
+		"failed to allocate memory",
+		"tried to accessed unitialized optional",
+		"tried to access the value of an expected holding an error",
+		"tried to access an inactive variant alternative",
+		"tried to grow a fixed capacity container past its capacity"
 	};
 }
 
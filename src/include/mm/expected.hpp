@@ -0,0 +1,523 @@
+#ifndef MM_EXPECTED_HPP
+#define MM_EXPECTED_HPP
+#include "mm/utility.hpp"
+#include "mm/functional.hpp"
+#include "mm/optional.hpp"
+#include "mm/error.hpp"
+
+namespace mm {
+	template <class T,class E = mm::error> class expected;
+
+	template <class E>
+	class unexpected {
+	private:
+		E m_error;
+
+	public:
+		constexpr explicit unexpected(const E& error) : m_error(error) {}
+		constexpr explicit unexpected(E&& error) : m_error(mm::move(error)) {}
+
+		E& error() & { return m_error; }
+		const E& error() const & { return m_error; }
+		E&& error() && { return mm::move(m_error); }
+	};
+
+	template <class E>
+	mm::unexpected<mm::decay_t<E>> make_unexpected(E&& error) {
+		return mm::unexpected<mm::decay_t<E>>(mm::forward<E>(error));
+	}
+
+	template <class E1,class E2>
+	bool operator==(const mm::unexpected<E1>& lhs,const mm::unexpected<E2>& rhs) {
+		return lhs.error() == rhs.error();
+	}
+
+	template <class E1,class E2>
+	bool operator!=(const mm::unexpected<E1>& lhs,const mm::unexpected<E2>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	struct unexpect_t { explicit unexpect_t() = default; };
+	constexpr unexpect_t unexpect {};
+
+	namespace detail {
+		struct expected_uninit_t {};
+
+		template <class T,class E,bool = mm::is_trivially_destructible<T>::value && mm::is_trivially_destructible<E>::value>
+		struct expected_storage {
+			union {
+				T m_value;
+				E m_error;
+			};
+
+			bool m_has_value;
+
+			explicit expected_storage(detail::expected_uninit_t) : m_has_value(false) {}
+
+			template <class... Args>
+			constexpr explicit expected_storage(mm::in_place_t,Args&&... args) : m_value(mm::forward<Args>(args)...), m_has_value(true) {}
+
+			template <class... Args>
+			constexpr explicit expected_storage(mm::unexpect_t,Args&&... args) : m_error(mm::forward<Args>(args)...), m_has_value(false) {}
+
+			void destroy() {}
+
+			template <class... Args>
+			void construct_value(Args&&... args) {
+				mm::construct_at(mm::address_of(m_value),mm::forward<Args>(args)...);
+				m_has_value = true;
+			}
+
+			template <class... Args>
+			void construct_error(Args&&... args) {
+				mm::construct_at(mm::address_of(m_error),mm::forward<Args>(args)...);
+				m_has_value = false;
+			}
+		};
+
+		template <class T,class E>
+		struct expected_storage<T,E,false> {
+			union {
+				T m_value;
+				E m_error;
+			};
+
+			bool m_has_value;
+
+			explicit expected_storage(detail::expected_uninit_t) : m_has_value(false) {}
+
+			template <class... Args>
+			constexpr explicit expected_storage(mm::in_place_t,Args&&... args) : m_value(mm::forward<Args>(args)...), m_has_value(true) {}
+
+			template <class... Args>
+			constexpr explicit expected_storage(mm::unexpect_t,Args&&... args) : m_error(mm::forward<Args>(args)...), m_has_value(false) {}
+
+			~expected_storage() {
+				destroy();
+			}
+
+			void destroy() {
+				if (m_has_value) {
+					mm::destroy_at(mm::address_of(m_value));
+				} else {
+					mm::destroy_at(mm::address_of(m_error));
+				}
+			}
+
+			template <class... Args>
+			void construct_value(Args&&... args) {
+				mm::construct_at(mm::address_of(m_value),mm::forward<Args>(args)...);
+				m_has_value = true;
+			}
+
+			template <class... Args>
+			void construct_error(Args&&... args) {
+				mm::construct_at(mm::address_of(m_error),mm::forward<Args>(args)...);
+				m_has_value = false;
+			}
+		};
+
+		// like optional, trivially copyable alternatives keep the implicit copies
+		template <class T,class E,bool =
+			mm::is_trivially_copy_constructible<T>::value
+		     && mm::is_trivially_copy_assignable<T>::value
+		     && mm::is_trivially_destructible<T>::value
+		     && mm::is_trivially_copy_constructible<E>::value
+		     && mm::is_trivially_copy_assignable<E>::value
+		     && mm::is_trivially_destructible<E>::value
+		>
+		struct expected_copy_base : expected_storage<T,E> {
+			using expected_storage<T,E>::expected_storage;
+		};
+
+		template <class T,class E>
+		struct expected_copy_base<T,E,false> : expected_storage<T,E> {
+			using expected_storage<T,E>::expected_storage;
+
+			expected_copy_base(const expected_copy_base& other) : expected_storage<T,E>(detail::expected_uninit_t()) {
+				if (other.m_has_value) {
+					this->construct_value(other.m_value);
+				} else {
+					this->construct_error(other.m_error);
+				}
+			}
+
+			expected_copy_base(expected_copy_base&& other) : expected_storage<T,E>(detail::expected_uninit_t()) {
+				if (other.m_has_value) {
+					this->construct_value(mm::move(other.m_value));
+				} else {
+					this->construct_error(mm::move(other.m_error));
+				}
+			}
+
+			expected_copy_base& operator=(const expected_copy_base& other) {
+				if (this->m_has_value && other.m_has_value) {
+					this->m_value = other.m_value;
+				} else if (!this->m_has_value && !other.m_has_value) {
+					this->m_error = other.m_error;
+				} else if (other.m_has_value) {
+					this->destroy();
+					this->construct_value(other.m_value);
+				} else {
+					this->destroy();
+					this->construct_error(other.m_error);
+				}
+
+				return *this;
+			}
+
+			expected_copy_base& operator=(expected_copy_base&& other) {
+				if (this->m_has_value && other.m_has_value) {
+					this->m_value = mm::move(other.m_value);
+				} else if (!this->m_has_value && !other.m_has_value) {
+					this->m_error = mm::move(other.m_error);
+				} else if (other.m_has_value) {
+					this->destroy();
+					this->construct_value(mm::move(other.m_value));
+				} else {
+					this->destroy();
+					this->construct_error(mm::move(other.m_error));
+				}
+
+				return *this;
+			}
+		};
+
+		template <class T> struct is_expected : mm::false_t {};
+		template <class T,class E> struct is_expected< mm::expected<T,E> > : mm::true_t {};
+
+		template <class T> struct is_unexpected : mm::false_t {};
+		template <class E> struct is_unexpected< mm::unexpected<E> > : mm::true_t {};
+
+		template <class E,class F,class... Args>
+		using expected_map_t = mm::expected< mm::remove_cvref_t< mm::invoke_result_t<F,Args...> >,E >;
+
+		// map() has to build expected<void,E> when the function returns nothing
+		template <class E,class F,class... Args,mm::enable_if_t<
+			!mm::is_void< mm::invoke_result_t<F,Args...> >::value
+		> = nullptr>
+		detail::expected_map_t<E,F,Args...> expected_map(F&& f,Args&&... args) {
+			return detail::expected_map_t<E,F,Args...>(mm::in_place,mm::invoke(mm::forward<F>(f),mm::forward<Args>(args)...));
+		}
+
+		template <class E,class F,class... Args,mm::enable_if_t<
+			mm::is_void< mm::invoke_result_t<F,Args...> >::value
+		> = nullptr>
+		mm::expected<void,E> expected_map(F&& f,Args&&... args) {
+			mm::invoke(mm::forward<F>(f),mm::forward<Args>(args)...);
+			return mm::expected<void,E>();
+		}
+
+		inline void expected_bad_access() {
+			ERROR(mm::ERROR_BAD_EXPECTED_ACCESS,"%s",mm::error_msg[mm::ERROR_BAD_EXPECTED_ACCESS]);
+		}
+	}
+
+	// holds either a value or the error that prevented producing it, for failure
+	// paths that must be recoverable without exceptions. and_then chains calls
+	// that can fail, map transforms the value and or_else handles the error,
+	// each passes the other state through untouched
+	template <class T,class E>
+	class expected : private detail::expected_copy_base<T,E> {
+	private:
+		using base = detail::expected_copy_base<T,E>;
+
+		template <class U,class G> friend class expected;
+
+	public:
+		using value_type = T;
+		using error_type = E;
+		using unexpected_type = mm::unexpected<E>;
+
+		template <class U = T,mm::enable_if_t<
+			mm::is_default_constructible<U>::value
+		> = nullptr>
+		constexpr expected() : base(mm::in_place) {}
+
+		expected(const expected&) = default;
+		expected(expected&&) = default;
+
+		template <class U = T,mm::enable_if_t<
+			mm::is_constructible<T,U&&>::value
+		     && !mm::is_same<mm::remove_cvref_t<U>,mm::in_place_t>::value
+		     && !mm::is_same<mm::remove_cvref_t<U>,mm::unexpect_t>::value
+		     && !detail::is_expected<mm::remove_cvref_t<U>>::value
+		     && !detail::is_unexpected<mm::remove_cvref_t<U>>::value
+		> = nullptr>
+		constexpr expected(U&& value) : base(mm::in_place,mm::forward<U>(value)) {}
+
+		template <class G>
+		constexpr expected(const mm::unexpected<G>& error) : base(mm::unexpect,error.error()) {}
+
+		template <class G>
+		constexpr expected(mm::unexpected<G>&& error) : base(mm::unexpect,mm::move(error.error())) {}
+
+		template <class... Args>
+		constexpr explicit expected(mm::in_place_t,Args&&... args) : base(mm::in_place,mm::forward<Args>(args)...) {}
+
+		template <class... Args>
+		constexpr explicit expected(mm::unexpect_t,Args&&... args) : base(mm::unexpect,mm::forward<Args>(args)...) {}
+
+		expected& operator=(const expected&) = default;
+		expected& operator=(expected&&) = default;
+
+		template <class U = T,mm::enable_if_t<
+			mm::is_constructible<T,U&&>::value
+		     && !detail::is_expected<mm::remove_cvref_t<U>>::value
+		     && !detail::is_unexpected<mm::remove_cvref_t<U>>::value
+		> = nullptr>
+		expected& operator=(U&& value) {
+			if (has_value()) {
+				this->m_value = mm::forward<U>(value);
+			} else {
+				this->destroy();
+				this->construct_value(mm::forward<U>(value));
+			}
+
+			return *this;
+		}
+
+		template <class G>
+		expected& operator=(const mm::unexpected<G>& error) {
+			if (has_value()) {
+				this->destroy();
+				this->construct_error(error.error());
+			} else {
+				this->m_error = error.error();
+			}
+
+			return *this;
+		}
+
+		template <class... Args>
+		T& emplace(Args&&... args) {
+			this->destroy();
+			this->construct_value(mm::forward<Args>(args)...);
+			return this->m_value;
+		}
+
+		bool has_value() const { return this->m_has_value; }
+		explicit operator bool() const { return this->m_has_value; }
+
+		T& value() & {
+			if (!has_value()) {
+				detail::expected_bad_access();
+			}
+
+			return this->m_value;
+		}
+
+		const T& value() const & {
+			if (!has_value()) {
+				detail::expected_bad_access();
+			}
+
+			return this->m_value;
+		}
+
+		T&& value() && {
+			if (!has_value()) {
+				detail::expected_bad_access();
+			}
+
+			return mm::move(this->m_value);
+		}
+
+		// unchecked
+		E& error() & { return this->m_error; }
+		const E& error() const & { return this->m_error; }
+		E&& error() && { return mm::move(this->m_error); }
+
+		template <class U>
+		T value_or(U&& fallback) const & {
+			return has_value() ? this->m_value : static_cast<T>(mm::forward<U>(fallback));
+		}
+
+		template <class U>
+		T value_or(U&& fallback) && {
+			return has_value() ? mm::move(this->m_value) : static_cast<T>(mm::forward<U>(fallback));
+		}
+
+		// unchecked
+		T& operator*() & { return this->m_value; }
+		const T& operator*() const & { return this->m_value; }
+		T&& operator*() && { return mm::move(this->m_value); }
+
+		T* operator->() { return mm::address_of(this->m_value); }
+		const T* operator->() const { return mm::address_of(this->m_value); }
+
+		// f(value) returns an expected with the same error type
+		template <class F>
+		mm::remove_cvref_t<mm::invoke_result_t<F,T&>> and_then(F&& f) & {
+			using result = mm::remove_cvref_t<mm::invoke_result_t<F,T&>>;
+			return has_value() ? mm::invoke(mm::forward<F>(f),this->m_value) : result(mm::unexpect,this->m_error);
+		}
+
+		template <class F>
+		mm::remove_cvref_t<mm::invoke_result_t<F,const T&>> and_then(F&& f) const & {
+			using result = mm::remove_cvref_t<mm::invoke_result_t<F,const T&>>;
+			return has_value() ? mm::invoke(mm::forward<F>(f),this->m_value) : result(mm::unexpect,this->m_error);
+		}
+
+		template <class F>
+		mm::remove_cvref_t<mm::invoke_result_t<F,T&&>> and_then(F&& f) && {
+			using result = mm::remove_cvref_t<mm::invoke_result_t<F,T&&>>;
+			return has_value() ? mm::invoke(mm::forward<F>(f),mm::move(this->m_value)) : result(mm::unexpect,mm::move(this->m_error));
+		}
+
+		// f(value) returns a plain value (or nothing) that is wrapped again
+		template <class F>
+		detail::expected_map_t<E,F,T&> map(F&& f) & {
+			using result = detail::expected_map_t<E,F,T&>;
+			return has_value() ? detail::expected_map<E>(mm::forward<F>(f),this->m_value) : result(mm::unexpect,this->m_error);
+		}
+
+		template <class F>
+		detail::expected_map_t<E,F,const T&> map(F&& f) const & {
+			using result = detail::expected_map_t<E,F,const T&>;
+			return has_value() ? detail::expected_map<E>(mm::forward<F>(f),this->m_value) : result(mm::unexpect,this->m_error);
+		}
+
+		template <class F>
+		detail::expected_map_t<E,F,T&&> map(F&& f) && {
+			using result = detail::expected_map_t<E,F,T&&>;
+			return has_value() ? detail::expected_map<E>(mm::forward<F>(f),mm::move(this->m_value)) : result(mm::unexpect,mm::move(this->m_error));
+		}
+
+		// f(error) returns an expected with the same value type, to recover or
+		// to translate the error
+		template <class F>
+		mm::remove_cvref_t<mm::invoke_result_t<F,const E&>> or_else(F&& f) const & {
+			using result = mm::remove_cvref_t<mm::invoke_result_t<F,const E&>>;
+			return has_value() ? result(mm::in_place,this->m_value) : mm::invoke(mm::forward<F>(f),this->m_error);
+		}
+
+		template <class F>
+		mm::remove_cvref_t<mm::invoke_result_t<F,E&&>> or_else(F&& f) && {
+			using result = mm::remove_cvref_t<mm::invoke_result_t<F,E&&>>;
+			return has_value() ? result(mm::in_place,mm::move(this->m_value)) : mm::invoke(mm::forward<F>(f),mm::move(this->m_error));
+		}
+	};
+
+	// success or an error, stored as an optional error. errors with a spare
+	// value, such as mm::error whose 0 is not an error, take no extra space
+	template <class E>
+	class expected<void,E> {
+	private:
+		mm::optional<E> m_error;
+
+	public:
+		using value_type = void;
+		using error_type = E;
+		using unexpected_type = mm::unexpected<E>;
+
+		constexpr expected() : m_error() {}
+		constexpr explicit expected(mm::in_place_t) : m_error() {}
+
+		template <class G>
+		constexpr expected(const mm::unexpected<G>& error) : m_error(mm::in_place,error.error()) {}
+
+		template <class G>
+		constexpr expected(mm::unexpected<G>&& error) : m_error(mm::in_place,mm::move(error.error())) {}
+
+		template <class... Args>
+		constexpr explicit expected(mm::unexpect_t,Args&&... args) : m_error(mm::in_place,mm::forward<Args>(args)...) {}
+
+		template <class G>
+		expected& operator=(const mm::unexpected<G>& error) {
+			m_error = error.error();
+			return *this;
+		}
+
+		void emplace() {
+			m_error.reset();
+		}
+
+		bool has_value() const { return !m_error.has_value(); }
+		explicit operator bool() const { return !m_error.has_value(); }
+
+		void value() const {
+			if (!has_value()) {
+				detail::expected_bad_access();
+			}
+		}
+
+		// unchecked
+		E& error() & { return *m_error; }
+		const E& error() const & { return *m_error; }
+		E&& error() && { return mm::move(*m_error); }
+
+		template <class F>
+		mm::remove_cvref_t<mm::invoke_result_t<F>> and_then(F&& f) const & {
+			using result = mm::remove_cvref_t<mm::invoke_result_t<F>>;
+			return has_value() ? mm::invoke(mm::forward<F>(f)) : result(mm::unexpect,*m_error);
+		}
+
+		template <class F>
+		mm::remove_cvref_t<mm::invoke_result_t<F>> and_then(F&& f) && {
+			using result = mm::remove_cvref_t<mm::invoke_result_t<F>>;
+			return has_value() ? mm::invoke(mm::forward<F>(f)) : result(mm::unexpect,mm::move(*m_error));
+		}
+
+		template <class F>
+		detail::expected_map_t<E,F> map(F&& f) const & {
+			using result = detail::expected_map_t<E,F>;
+			return has_value() ? detail::expected_map<E>(mm::forward<F>(f)) : result(mm::unexpect,*m_error);
+		}
+
+		template <class F>
+		detail::expected_map_t<E,F> map(F&& f) && {
+			using result = detail::expected_map_t<E,F>;
+			return has_value() ? detail::expected_map<E>(mm::forward<F>(f)) : result(mm::unexpect,mm::move(*m_error));
+		}
+
+		template <class F>
+		mm::remove_cvref_t<mm::invoke_result_t<F,const E&>> or_else(F&& f) const & {
+			using result = mm::remove_cvref_t<mm::invoke_result_t<F,const E&>>;
+			return has_value() ? result() : mm::invoke(mm::forward<F>(f),*m_error);
+		}
+
+		template <class F>
+		mm::remove_cvref_t<mm::invoke_result_t<F,E&&>> or_else(F&& f) && {
+			using result = mm::remove_cvref_t<mm::invoke_result_t<F,E&&>>;
+			return has_value() ? result() : mm::invoke(mm::forward<F>(f),mm::move(*m_error));
+		}
+	};
+
+	template <class T1,class E1,class T2,class E2,mm::enable_if_t<
+		!mm::is_void<T1>::value && !mm::is_void<T2>::value
+	> = nullptr>
+	bool operator==(const mm::expected<T1,E1>& lhs,const mm::expected<T2,E2>& rhs) {
+		if (lhs.has_value() != rhs.has_value()) {
+			return false;
+		}
+
+		return lhs.has_value() ? *lhs == *rhs : lhs.error() == rhs.error();
+	}
+
+	template <class E1,class E2>
+	bool operator==(const mm::expected<void,E1>& lhs,const mm::expected<void,E2>& rhs) {
+		if (lhs.has_value() != rhs.has_value()) {
+			return false;
+		}
+
+		return lhs.has_value() || lhs.error() == rhs.error();
+	}
+
+	template <class T1,class E1,class T2,class E2>
+	bool operator!=(const mm::expected<T1,E1>& lhs,const mm::expected<T2,E2>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class T,class E,class G>
+	bool operator==(const mm::expected<T,E>& lhs,const mm::unexpected<G>& rhs) {
+		return !lhs.has_value() && lhs.error() == rhs.error();
+	}
+
+	template <class T,class E,class G>
+	bool operator!=(const mm::expected<T,E>& lhs,const mm::unexpected<G>& rhs) {
+		return !(lhs == rhs);
+	}
+}
+
+#endif
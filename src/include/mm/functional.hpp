@@ -96,6 +96,72 @@ namespace mm {
 	template <class T> constexpr mm::reference_wrapper<T> cref(const T& t) {
 		return mm::reference_wrapper<T>(t);
 	}
+
+	template <class>
+	class function_ref;
+
+	// non owning reference to a callable, two words and never allocates. the
+	// callable must outlive the function_ref
+	template <class R,class... Args>
+	class function_ref<R(Args...)> {
+	private:
+		union storage {
+			void* object;
+			void (*function)();
+		};
+
+		storage m_storage;
+		R (*m_call)(storage,Args...);
+
+		template <class F>
+		static R call_object(storage s,Args... args) {
+			return static_cast<R>(mm::invoke(*static_cast<F*>(s.object),mm::forward<Args>(args)...));
+		}
+
+		template <class F>
+		static R call_function(storage s,Args... args) {
+			return static_cast<R>(mm::invoke(reinterpret_cast<F*>(s.function),mm::forward<Args>(args)...));
+		}
+
+	public:
+		template <class F,mm::enable_if_t<
+			!mm::is_same< mm::remove_cvref_t<F>, function_ref >::value
+		     && !mm::is_function< mm::remove_reference_t<F> >::value
+		     && !mm::is_pointer< mm::remove_cvref_t<F> >::value
+		> = nullptr>
+		function_ref(F&& f) : m_call(&call_object< mm::remove_reference_t<F> >) {
+			m_storage.object = const_cast<void*>(static_cast<const volatile void*>(mm::address_of(f)));
+		}
+
+		// functions are stored by pointer, so temporaries of &func are fine
+		template <class F,mm::enable_if_t<mm::is_function<F>::value> = nullptr>
+		function_ref(F* f) : m_call(&call_function<F>) {
+			m_storage.function = reinterpret_cast<void (*)()>(f);
+		}
+
+		function_ref(const function_ref&) = default;
+		function_ref& operator=(const function_ref&) = default;
+
+		R operator()(Args... args) const {
+			return m_call(m_storage,mm::forward<Args>(args)...);
+		}
+	};
+
+	template <class T = void>
+	struct equal_to {
+		constexpr bool operator()(const T& lhs,const T& rhs) const {
+			return lhs == rhs;
+		}
+	};
+
+	// compares any two types with ==, lookups can then use a key type
+	template <>
+	struct equal_to<void> {
+		template <class T,class U>
+		constexpr auto operator()(T&& lhs,U&& rhs) const -> decltype(mm::forward<T>(lhs) == mm::forward<U>(rhs)) {
+			return mm::forward<T>(lhs) == mm::forward<U>(rhs);
+		}
+	};
 }
 
 #endif
@@ -0,0 +1,446 @@
+#ifndef MM_HAZARD_POINTER_HPP
+#define MM_HAZARD_POINTER_HPP
+#include <pthread.h>
+#include "mm/memory.hpp"
+#include "mm/error.hpp"
+
+namespace mm {
+	class hazard_domain;
+
+	namespace detail {
+		// retired pointers handed over by exited threads, adopted by the next scan
+		struct hazard_orphans {
+			hazard_orphans* next;
+			mm::size_t size;
+			detail::deferred_delete* entries;
+		};
+
+		// one per thread per domain, records are never unlinked and are reused
+		// once their thread exits. aligned to a cache line so publishing a hazard
+		// never invalidates a neighbouring thread's slots
+		struct alignas(mm::hardware_destructive_interference_size) hazard_record {
+			static constexpr mm::u32 slot_count = 8;
+
+			mm::atomic<void*> slots[slot_count];
+			mm::atomic<bool> in_use;
+			hazard_record* next;
+			hazard_domain* domain;
+
+			// only touched by the owning thread
+			mm::u32 free_slots;
+			bool scanning;
+			detail::deferred_delete* retired;
+			mm::size_t retired_size;
+			mm::size_t retired_capacity;
+			void** scratch;
+			mm::size_t scratch_capacity;
+
+			hazard_record(hazard_domain* d) :
+				in_use(true),
+				next(nullptr),
+				domain(d),
+				free_slots((1u << slot_count) - 1),
+				scanning(false),
+				retired(nullptr),
+				retired_size(0),
+				retired_capacity(0),
+				scratch(nullptr),
+				scratch_capacity(0)
+			{
+				for (mm::u32 i = 0; i < slot_count; ++i) {
+					slots[i].store(nullptr,mm::memory_order_relaxed);
+				}
+			}
+
+			void push_retired(const detail::deferred_delete& entry) {
+				if (retired_size == retired_capacity) {
+					retired_capacity = retired_capacity ? retired_capacity * 2 : 64;
+					retired = static_cast<detail::deferred_delete*>(realloc(retired,retired_capacity * sizeof(detail::deferred_delete)));
+
+					if (!retired) {
+						ERROR(mm::ERROR_FAILED_ALLOC,"%s",mm::error_msg[mm::ERROR_FAILED_ALLOC]);
+					}
+				}
+
+				retired[retired_size++] = entry;
+			}
+		};
+	}
+
+	// hazard pointer based reclamation. a reader publishes the pointer it is
+	// about to dereference in one of its thread's hazard slots with protect(),
+	// writers unlink nodes and retire() them. once a thread has retired more
+	// than twice as many pointers as there are hazard slots it scans every slot
+	// and reclaims whatever is not protected, which amortises the scan to O(1)
+	// per retire. unlike epoch_domain a stalled reader only pins the handful of
+	// nodes it protects, so unreclaimed memory stays bounded
+	class hazard_domain {
+	private:
+		mm::atomic<detail::hazard_record*> m_records;
+		mm::atomic<detail::hazard_orphans*> m_orphans;
+		mm::atomic<mm::size_t> m_record_count;
+		pthread_key_t m_key;
+
+		static void thread_exit(void* record) {
+			detail::hazard_record* self = static_cast<detail::hazard_record*>(record);
+			self->domain->release_record(self);
+		}
+
+		detail::hazard_record* acquire_record() {
+			for (detail::hazard_record* it = m_records.load(mm::memory_order_acquire); it; it = it->next) {
+				bool expected = false;
+
+				if (!it->in_use.load(mm::memory_order_relaxed) && it->in_use.compare_exchange_strong(expected,true,mm::memory_order_acquire)) {
+					return it;
+				}
+			}
+
+			void* memory = aligned_alloc(alignof(detail::hazard_record),sizeof(detail::hazard_record));
+
+			if (!memory) {
+				ERROR(mm::ERROR_FAILED_ALLOC,"%s",mm::error_msg[mm::ERROR_FAILED_ALLOC]);
+			}
+
+			detail::hazard_record* record = mm::construct_at(static_cast<detail::hazard_record*>(memory),this);
+			detail::hazard_record* head = m_records.load(mm::memory_order_relaxed);
+
+			do {
+				record->next = head;
+			} while (!m_records.compare_exchange_weak(head,record,mm::memory_order_release,mm::memory_order_relaxed));
+
+			m_record_count.fetch_add(1,mm::memory_order_relaxed);
+			return record;
+		}
+
+		// hands whatever is still protected to the domain and frees the record for reuse
+		void release_record(detail::hazard_record* record) {
+			for (mm::u32 i = 0; i < detail::hazard_record::slot_count; ++i) {
+				record->slots[i].store(nullptr,mm::memory_order_release);
+			}
+
+			record->free_slots = (1u << detail::hazard_record::slot_count) - 1;
+			scan(record);
+
+			if (record->retired_size > 0) {
+				detail::hazard_orphans* orphans = new detail::hazard_orphans();
+				orphans->size = record->retired_size;
+				orphans->entries = record->retired;
+
+				record->retired = nullptr;
+				record->retired_size = 0;
+				record->retired_capacity = 0;
+
+				orphans->next = m_orphans.load(mm::memory_order_relaxed);
+
+				while (!m_orphans.compare_exchange_weak(orphans->next,orphans,mm::memory_order_release,mm::memory_order_relaxed)) {}
+			}
+
+			record->in_use.store(false,mm::memory_order_release);
+		}
+
+		void adopt_orphans(detail::hazard_record* record) {
+			if (!m_orphans.load(mm::memory_order_relaxed)) {
+				return;
+			}
+
+			detail::hazard_orphans* orphans = m_orphans.exchange(nullptr,mm::memory_order_acquire);
+
+			while (orphans) {
+				detail::hazard_orphans* next = orphans->next;
+
+				for (mm::size_t i = 0; i < orphans->size; ++i) {
+					record->push_retired(orphans->entries[i]);
+				}
+
+				free(orphans->entries);
+				delete orphans;
+				orphans = next;
+			}
+		}
+
+		mm::size_t scan_threshold() const {
+			mm::size_t hazards = m_record_count.load(mm::memory_order_relaxed) * detail::hazard_record::slot_count;
+			return hazards * 2 > 64 ? hazards * 2 : 64;
+		}
+
+		// gathers every published hazard into an open addressed set in the
+		// record's scratch buffer, so checking each retired pointer is O(1).
+		// records registered after the snapshot cannot protect anything that
+		// was unlinked before the scan started
+		mm::size_t collect_hazards(detail::hazard_record* record) {
+			detail::hazard_record* records = m_records.load(mm::memory_order_acquire);
+			mm::size_t hazards = 0;
+			mm::size_t capacity = 16;
+
+			for (detail::hazard_record* it = records; it; it = it->next) {
+				hazards += detail::hazard_record::slot_count;
+			}
+
+			while (capacity < hazards * 2) {
+				capacity *= 2;
+			}
+
+			if (record->scratch_capacity < capacity) {
+				free(record->scratch);
+				record->scratch = static_cast<void**>(malloc(capacity * sizeof(void*)));
+				record->scratch_capacity = capacity;
+
+				if (!record->scratch) {
+					ERROR(mm::ERROR_FAILED_ALLOC,"%s",mm::error_msg[mm::ERROR_FAILED_ALLOC]);
+				}
+			}
+
+			capacity = record->scratch_capacity;
+
+			for (mm::size_t i = 0; i < capacity; ++i) {
+				record->scratch[i] = nullptr;
+			}
+
+			for (detail::hazard_record* it = records; it; it = it->next) {
+				for (mm::u32 i = 0; i < detail::hazard_record::slot_count; ++i) {
+					void* hazard = it->slots[i].load(mm::memory_order_acquire);
+
+					if (!hazard) {
+						continue;
+					}
+
+					mm::size_t index = hash(hazard) & (capacity - 1);
+
+					while (record->scratch[index] && record->scratch[index] != hazard) {
+						index = (index + 1) & (capacity - 1);
+					}
+
+					record->scratch[index] = hazard;
+				}
+			}
+
+			return capacity;
+		}
+
+		static mm::size_t hash(void* ptr) {
+			mm::u64 key = static_cast<mm::u64>(reinterpret_cast<uintptr_t>(ptr));
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdULL;
+			key ^= key >> 33;
+			return static_cast<mm::size_t>(key);
+		}
+
+		static bool is_hazard(void** set,mm::size_t capacity,void* ptr) {
+			mm::size_t index = hash(ptr) & (capacity - 1);
+
+			while (set[index]) {
+				if (set[index] == ptr) {
+					return true;
+				}
+
+				index = (index + 1) & (capacity - 1);
+			}
+
+			return false;
+		}
+
+		void scan(detail::hazard_record* record) {
+			adopt_orphans(record);
+
+			// orders our unlinks before reading the slots, pairs with the fence in protect()
+			mm::atomic_thread_fence(mm::memory_order_seq_cst);
+
+			mm::size_t capacity = collect_hazards(record);
+
+			// a deleter may retire more pointers, so detach the list before running any
+			detail::deferred_delete* retired = record->retired;
+			mm::size_t size = record->retired_size;
+
+			record->retired = nullptr;
+			record->retired_size = 0;
+			record->retired_capacity = 0;
+			record->scanning = true;
+
+			for (mm::size_t i = 0; i < size; ++i) {
+				if (is_hazard(record->scratch,capacity,retired[i].object)) {
+					record->push_retired(retired[i]);
+				} else {
+					retired[i]();
+				}
+			}
+
+			record->scanning = false;
+			free(retired);
+		}
+
+	public:
+		hazard_domain() : m_records(nullptr), m_orphans(nullptr), m_record_count(0) {
+			pthread_key_create(&m_key,&hazard_domain::thread_exit);
+		}
+
+		hazard_domain(const hazard_domain&) = delete;
+		hazard_domain& operator=(const hazard_domain&) = delete;
+
+		// every thread must have released its hazard pointers, anything still retired is reclaimed
+		~hazard_domain() {
+			pthread_key_delete(m_key);
+
+			detail::hazard_record* record = m_records.load(mm::memory_order_acquire);
+
+			while (record) {
+				detail::hazard_record* next = record->next;
+
+				for (mm::size_t i = 0; i < record->retired_size; ++i) {
+					record->retired[i]();
+				}
+
+				free(record->retired);
+				free(record->scratch);
+				mm::destroy_at(record);
+				free(record);
+
+				record = next;
+			}
+
+			detail::hazard_orphans* orphans = m_orphans.load(mm::memory_order_acquire);
+
+			while (orphans) {
+				detail::hazard_orphans* next = orphans->next;
+
+				for (mm::size_t i = 0; i < orphans->size; ++i) {
+					orphans->entries[i]();
+				}
+
+				free(orphans->entries);
+				delete orphans;
+				orphans = next;
+			}
+		}
+
+		// the calling thread's record, registered on first use
+		detail::hazard_record* record() {
+			detail::hazard_record* record = static_cast<detail::hazard_record*>(pthread_getspecific(m_key));
+
+			if (!record) {
+				record = acquire_record();
+				pthread_setspecific(m_key,record);
+			}
+
+			return record;
+		}
+
+		// ptr must already be unreachable for new readers. defers the unique_ptr's
+		// deleter, stateless deleters such as default_delete cost no extra allocation
+		template <class T,class Deleter>
+		void retire(mm::unique_ptr<T,Deleter>&& ptr) {
+			if (!ptr) {
+				return;
+			}
+
+			detail::hazard_record* self = record();
+			self->push_retired(detail::make_deferred_delete(mm::move(ptr)));
+
+			if (self->retired_size >= scan_threshold() && !self->scanning) {
+				scan(self);
+			}
+		}
+
+		template <class T>
+		void retire(T* ptr) {
+			retire(mm::unique_ptr<T>(ptr));
+		}
+
+		// reclaims every retired pointer of the calling thread that is not protected
+		void flush() {
+			scan(record());
+		}
+	};
+
+	// owns one hazard slot of the calling thread for its lifetime
+	class hazard_pointer {
+	private:
+		mm::atomic<void*>* m_slot;
+		detail::hazard_record* m_record;
+		mm::u32 m_index;
+
+	public:
+		hazard_pointer() : m_slot(nullptr), m_record(nullptr), m_index(0) {}
+
+		explicit hazard_pointer(mm::hazard_domain& domain) : m_record(domain.record()) {
+			if (m_record->free_slots == 0) {
+				ERROR(mm::ERROR_GENERAL,"thread ran out of hazard pointers");
+			}
+
+			m_index = static_cast<mm::u32>(__builtin_ctz(m_record->free_slots));
+			m_record->free_slots &= ~(1u << m_index);
+			m_slot = &m_record->slots[m_index];
+		}
+
+		hazard_pointer(const hazard_pointer&) = delete;
+		hazard_pointer& operator=(const hazard_pointer&) = delete;
+
+		hazard_pointer(hazard_pointer&& other) : m_slot(other.m_slot), m_record(other.m_record), m_index(other.m_index) {
+			other.m_slot = nullptr;
+			other.m_record = nullptr;
+		}
+
+		hazard_pointer& operator=(hazard_pointer&& other) {
+			hazard_pointer(mm::move(other)).swap(*this);
+			return *this;
+		}
+
+		~hazard_pointer() {
+			if (m_slot) {
+				m_slot->store(nullptr,mm::memory_order_release);
+				m_record->free_slots |= 1u << m_index;
+			}
+		}
+
+		void swap(hazard_pointer& other) {
+			mm::swap(m_slot,other.m_slot);
+			mm::swap(m_record,other.m_record);
+			mm::swap(m_index,other.m_index);
+		}
+
+		bool empty() const {
+			return m_slot == nullptr;
+		}
+
+		// publishes ptr if src still holds it, on failure ptr is refreshed from src
+		template <class T>
+		bool try_protect(T*& ptr,const mm::atomic<T*>& src) {
+			T* expected = ptr;
+			m_slot->store(const_cast<void*>(static_cast<const volatile void*>(expected)),mm::memory_order_relaxed);
+			mm::atomic_thread_fence(mm::memory_order_seq_cst);
+
+			ptr = src.load(mm::memory_order_acquire);
+
+			if (ptr != expected) {
+				reset_protection();
+				return false;
+			}
+
+			return true;
+		}
+
+		// loads src and keeps the result safe to dereference until the protection is reset
+		template <class T>
+		T* protect(const mm::atomic<T*>& src) {
+			T* ptr = src.load(mm::memory_order_relaxed);
+
+			while (!try_protect(ptr,src)) {}
+
+			return ptr;
+		}
+
+		template <class T>
+		void reset_protection(const T* ptr) {
+			m_slot->store(const_cast<void*>(static_cast<const volatile void*>(ptr)),mm::memory_order_release);
+		}
+
+		void reset_protection(mm::nullptr_t = nullptr) {
+			m_slot->store(nullptr,mm::memory_order_release);
+		}
+	};
+
+	inline mm::hazard_pointer make_hazard_pointer(mm::hazard_domain& domain) {
+		return mm::hazard_pointer(domain);
+	}
+}
+
+#endif
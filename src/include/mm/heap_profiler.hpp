@@ -0,0 +1,303 @@
+#ifndef MM_HEAP_PROFILER_HPP
+#define MM_HEAP_PROFILER_HPP
+#include <execinfo.h>
+#include <string.h>
+#include "mm/common.hpp"
+
+// sampling heap profiler, compiled in with SAMPLE_ALLOCATIONS and switched on
+// at runtime with heap_profile_start(). every thread counts down the bytes it
+// allocates and takes a sample when the count runs out, the next count is
+// drawn from an exponential distribution with the sampling period as its
+// mean, so each allocated byte is equally likely to be sampled. a sample
+// captures the call stack with backtrace() and charges the allocation to a
+// bucket per distinct stack. the bucket is stored in the allocation header so
+// freeing a sampled allocation is O(1). profiles are written in the
+// gperftools heap profile text format, which pprof reads and unsamples
+//
+// uses libc and the __atomic builtins directly since common.hpp pulls this
+// header in before anything else is declared
+
+namespace mm {
+	namespace detail {
+		constexpr mm::size_t heap_profile_max_depth = 32;
+		constexpr mm::size_t heap_profile_table_size = 4096;
+
+		struct heap_profile_bucket {
+			heap_profile_bucket* next;
+			mm::u64 hash;
+			mm::size_t depth;
+			void* stack[heap_profile_max_depth];
+			mm::u64 alloc_count;
+			mm::u64 alloc_bytes;
+			mm::u64 live_count;
+			mm::u64 live_bytes;
+		};
+
+		// zero initialised, only touched under heap_profile_lock
+		// period keeps its value after stopping so a later dump can still be unsampled
+		struct heap_profile_state {
+			mm::u64 period;
+			bool active;
+			bool lock;
+			heap_profile_bucket* table[heap_profile_table_size];
+		};
+
+		// per thread, plain data so no runtime support is needed for __thread
+		struct heap_profile_thread {
+			mm::i64 countdown;
+			mm::u64 rng;
+			bool busy;
+		};
+
+		// zero initialised statics need no guard, and being inline there is one
+		// of each however many translation units include this header
+		inline heap_profile_state& heap_profile() {
+			static heap_profile_state state;
+			return state;
+		}
+
+		inline heap_profile_thread& heap_profile_local() {
+			static __thread heap_profile_thread local;
+			return local;
+		}
+
+		inline void heap_profile_lock() {
+			while (__atomic_test_and_set(&heap_profile().lock,__ATOMIC_ACQUIRE)) {
+				#if defined(__x86_64__) || defined(__i386__)
+				__builtin_ia32_pause();
+				#endif
+			}
+		}
+
+		inline void heap_profile_unlock() {
+			__atomic_clear(&heap_profile().lock,__ATOMIC_RELEASE);
+		}
+
+		// natural log of x in (0,1], accurate enough to shape the sampling intervals
+		// without pulling in libm
+		inline double heap_profile_log(double x) {
+			mm::u64 bits;
+			memcpy(&bits,&x,sizeof(bits));
+
+			mm::i64 exponent = static_cast<mm::i64>((bits >> 52) & 0x7ff) - 1023;
+			bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+
+			double mantissa;
+			memcpy(&mantissa,&bits,sizeof(mantissa));
+
+			// ln(m) = 2 atanh((m - 1) / (m + 1)) for m in [1,2)
+			double t = (mantissa - 1) / (mantissa + 1);
+			double t2 = t * t;
+			double ln_mantissa = 2 * t * (1 + t2 * (1.0 / 3 + t2 * (1.0 / 5 + t2 * (1.0 / 7 + t2 * (1.0 / 9)))));
+
+			return static_cast<double>(exponent) * 0.6931471805599453 + ln_mantissa;
+		}
+
+		inline mm::i64 heap_profile_next_interval(mm::u64 period) {
+			mm::u64& rng = heap_profile_local().rng;
+
+			if (rng == 0) {
+				rng = reinterpret_cast<uintptr_t>(&rng) ^ 0x9e3779b97f4a7c15ULL;
+			}
+
+			// xorshift64*
+			rng ^= rng >> 12;
+			rng ^= rng << 25;
+			rng ^= rng >> 27;
+
+			mm::u64 random = (rng * 0x2545f4914f6cdd1dULL) >> 11;
+			double uniform = (static_cast<double>(random) + 1) / 9007199254740992.0;
+
+			return static_cast<mm::i64>(-heap_profile_log(uniform) * static_cast<double>(period)) + 1;
+		}
+
+		inline mm::u64 heap_profile_hash(void* const* stack,mm::size_t depth) {
+			mm::u64 hash = 0xcbf29ce484222325ULL;
+
+			for (mm::size_t i = 0; i < depth; ++i) {
+				hash = (hash ^ static_cast<mm::u64>(reinterpret_cast<uintptr_t>(stack[i]))) * 0x100000001b3ULL;
+			}
+
+			return hash;
+		}
+
+		inline heap_profile_bucket* heap_profile_find_bucket(void* const* stack,mm::size_t depth) {
+			mm::u64 hash = heap_profile_hash(stack,depth);
+			heap_profile_bucket** head = &heap_profile().table[hash % heap_profile_table_size];
+
+			for (heap_profile_bucket* it = *head; it; it = it->next) {
+				if (it->hash == hash && it->depth == depth && memcmp(it->stack,stack,depth * sizeof(void*)) == 0) {
+					return it;
+				}
+			}
+
+			heap_profile_bucket* bucket = static_cast<heap_profile_bucket*>(calloc(1,sizeof(heap_profile_bucket)));
+
+			if (!bucket) {
+				return nullptr;
+			}
+
+			bucket->hash = hash;
+			bucket->depth = depth;
+			memcpy(bucket->stack,stack,depth * sizeof(void*));
+			bucket->next = *head;
+			*head = bucket;
+			return bucket;
+		}
+
+		// called for every hooked allocation, returns the bucket to charge it to
+		// when it was sampled. the fast path is a thread local subtraction
+		inline void* heap_profile_allocate(mm::size_t bytes) {
+			heap_profile_thread& local = heap_profile_local();
+
+			local.countdown -= static_cast<mm::i64>(bytes);
+
+			if (local.countdown >= 0) {
+				return nullptr;
+			}
+
+			bool active = __atomic_load_n(&heap_profile().active,__ATOMIC_ACQUIRE);
+
+			// stays negative so the next allocation checks again, and is stale
+			// by the time the profiler is started
+			if (!active || local.busy) {
+				local.countdown = -(mm::i64(1) << 62);
+				return nullptr;
+			}
+
+			// a stale countdown left over from before the profiler was started
+			// does not count as a sample
+			bool sample = local.countdown > -(mm::i64(1) << 61);
+			local.countdown = heap_profile_next_interval(__atomic_load_n(&heap_profile().period,__ATOMIC_RELAXED));
+
+			if (!sample) {
+				return nullptr;
+			}
+
+			local.busy = true;
+
+			void* stack[heap_profile_max_depth + 2];
+			int depth = backtrace(stack,heap_profile_max_depth + 2);
+
+			// drop this function and the allocation hook that called it, when they were not inlined
+			int skip = depth > 2 ? 2 : 0;
+
+			heap_profile_lock();
+			heap_profile_bucket* bucket = heap_profile_find_bucket(stack + skip,static_cast<mm::size_t>(depth - skip));
+
+			if (bucket) {
+				++bucket->alloc_count;
+				bucket->alloc_bytes += bytes;
+				++bucket->live_count;
+				bucket->live_bytes += bytes;
+			}
+
+			heap_profile_unlock();
+			local.busy = false;
+			return bucket;
+		}
+
+		inline void heap_profile_free(void* sample,mm::size_t bytes) {
+			heap_profile_bucket* bucket = static_cast<heap_profile_bucket*>(sample);
+
+			heap_profile_lock();
+			--bucket->live_count;
+			bucket->live_bytes -= bytes;
+			heap_profile_unlock();
+		}
+	}
+
+	// starts sampling roughly every period bytes, threads pick it up on their next sample
+	inline void heap_profile_start(mm::size_t period = 512 * 1024) {
+		__atomic_store_n(&detail::heap_profile().period,static_cast<mm::u64>(period ? period : 1),__ATOMIC_RELAXED);
+		__atomic_store_n(&detail::heap_profile().active,true,__ATOMIC_RELEASE);
+	}
+
+	// allocations sampled so far stay in the profile until they are freed
+	inline void heap_profile_stop() {
+		__atomic_store_n(&detail::heap_profile().active,false,__ATOMIC_RELAXED);
+	}
+
+	// writes live and cumulative samples in the gperftools heap profile format,
+	// followed by the memory map pprof needs to symbolise the addresses
+	inline bool heap_profile_dump(FILE* file) {
+		mm::u64 live_count = 0;
+		mm::u64 live_bytes = 0;
+		mm::u64 alloc_count = 0;
+		mm::u64 alloc_bytes = 0;
+
+		detail::heap_profile_lock();
+
+		for (mm::size_t i = 0; i < detail::heap_profile_table_size; ++i) {
+			for (detail::heap_profile_bucket* it = detail::heap_profile().table[i]; it; it = it->next) {
+				live_count += it->live_count;
+				live_bytes += it->live_bytes;
+				alloc_count += it->alloc_count;
+				alloc_bytes += it->alloc_bytes;
+			}
+		}
+
+		mm::u64 period = __atomic_load_n(&detail::heap_profile().period,__ATOMIC_RELAXED);
+
+		fprintf(
+			file,
+			"heap profile: %llu: %llu [%llu: %llu] @ heap_v2/%llu\n",
+			static_cast<unsigned long long>(live_count),
+			static_cast<unsigned long long>(live_bytes),
+			static_cast<unsigned long long>(alloc_count),
+			static_cast<unsigned long long>(alloc_bytes),
+			static_cast<unsigned long long>(period ? period : 1)
+		);
+
+		for (mm::size_t i = 0; i < detail::heap_profile_table_size; ++i) {
+			for (detail::heap_profile_bucket* it = detail::heap_profile().table[i]; it; it = it->next) {
+				fprintf(
+					file,
+					"%llu: %llu [%llu: %llu] @",
+					static_cast<unsigned long long>(it->live_count),
+					static_cast<unsigned long long>(it->live_bytes),
+					static_cast<unsigned long long>(it->alloc_count),
+					static_cast<unsigned long long>(it->alloc_bytes)
+				);
+
+				for (mm::size_t j = 0; j < it->depth; ++j) {
+					fprintf(file," %p",it->stack[j]);
+				}
+
+				fprintf(file,"\n");
+			}
+		}
+
+		detail::heap_profile_unlock();
+
+		fprintf(file,"\nMAPPED_LIBRARIES:\n");
+
+		FILE* maps = fopen("/proc/self/maps","r");
+
+		if (maps) {
+			char buffer[4096];
+			mm::size_t n;
+
+			while ((n = fread(buffer,1,sizeof(buffer),maps)) > 0) {
+				fwrite(buffer,1,n,file);
+			}
+
+			fclose(maps);
+		}
+
+		return !ferror(file);
+	}
+
+	inline bool heap_profile_dump(const char* path) {
+		FILE* file = fopen(path,"w");
+
+		if (!file) {
+			return false;
+		}
+
+		bool ok = mm::heap_profile_dump(file);
+		return fclose(file) == 0 && ok;
+	}
+}
+
+#endif
@@ -0,0 +1,349 @@
+#ifndef MM_INLINE_VECTOR_HPP
+#define MM_INLINE_VECTOR_HPP
+#include "mm/memory.hpp"
+#include "mm/expected.hpp"
+#include "mm/error.hpp"
+
+namespace mm {
+	namespace detail {
+		// a plain byte array rather than aligned_storage_t, gcc's scalar
+		// replacement loses stores made through T* when a struct wrapping the
+		// bytes is then copied as an aggregate
+		template <class T,mm::size_t N,bool = mm::is_trivially_destructible<T>::value>
+		struct inline_vector_storage {
+			alignas(T) unsigned char m_data[sizeof(T) * N];
+			mm::smallest_unsigned_t<N> m_size;
+
+			inline_vector_storage() : m_size(0) {}
+
+			T* data() { return reinterpret_cast<T*>(m_data); }
+			const T* data() const { return reinterpret_cast<const T*>(m_data); }
+
+			void destroy(mm::size_t,mm::size_t) {}
+		};
+
+		template <class T,mm::size_t N>
+		struct inline_vector_storage<T,N,false> {
+			alignas(T) unsigned char m_data[sizeof(T) * N];
+			mm::smallest_unsigned_t<N> m_size;
+
+			inline_vector_storage() : m_size(0) {}
+			inline_vector_storage(const inline_vector_storage&) = default;
+			inline_vector_storage& operator=(const inline_vector_storage&) = default;
+
+			~inline_vector_storage() {
+				destroy(0,m_size);
+			}
+
+			T* data() { return reinterpret_cast<T*>(m_data); }
+			const T* data() const { return reinterpret_cast<const T*>(m_data); }
+
+			void destroy(mm::size_t first,mm::size_t last) {
+				for (; first < last; ++first) {
+					mm::destroy_at(data() + first);
+				}
+			}
+		};
+
+		// trivially copyable elements keep the implicit copies, a copy is then
+		// a copy of the whole object and arrays of vectors can be memcpy'd
+		template <class T,mm::size_t N,bool =
+			mm::is_trivially_copy_constructible<T>::value
+		     && mm::is_trivially_copy_assignable<T>::value
+		     && mm::is_trivially_destructible<T>::value
+		>
+		struct inline_vector_copy_base : detail::inline_vector_storage<T,N> {};
+
+		template <class T,mm::size_t N>
+		struct inline_vector_copy_base<T,N,false> : detail::inline_vector_storage<T,N> {
+			inline_vector_copy_base() = default;
+
+			inline_vector_copy_base(const inline_vector_copy_base& other) {
+				for (mm::size_t i = 0; i < other.m_size; ++i) {
+					mm::construct_at(this->data() + i,other.data()[i]);
+				}
+
+				this->m_size = other.m_size;
+			}
+
+			inline_vector_copy_base(inline_vector_copy_base&& other) {
+				for (mm::size_t i = 0; i < other.m_size; ++i) {
+					mm::construct_at(this->data() + i,mm::move(other.data()[i]));
+				}
+
+				this->m_size = other.m_size;
+			}
+
+			inline_vector_copy_base& operator=(const inline_vector_copy_base& other) {
+				if (this != &other) {
+					assign(other.data(),other.m_size);
+				}
+
+				return *this;
+			}
+
+			inline_vector_copy_base& operator=(inline_vector_copy_base&& other) {
+				if (this != &other) {
+					assign(mm::make_move_iterator(other.data()),other.m_size);
+				}
+
+				return *this;
+			}
+
+			// assigns over the live prefix, constructs or destroys the rest
+			template <class Iter>
+			void assign(Iter source,mm::size_t n) {
+				mm::size_t common = n < this->m_size ? n : this->m_size;
+				mm::size_t i = 0;
+
+				for (; i < common; ++i, ++source) {
+					this->data()[i] = *source;
+				}
+
+				for (; i < n; ++i, ++source) {
+					mm::construct_at(this->data() + i,*source);
+				}
+
+				this->destroy(n,this->m_size);
+				this->m_size = static_cast<mm::smallest_unsigned_t<N>>(n);
+			}
+		};
+	}
+
+	// vector whose elements live inside the object, it never allocates. the
+	// size is stored in the smallest type that fits N. growing past N returns
+	// ERROR_CAPACITY_EXCEEDED and leaves the vector unchanged
+	template <class T,mm::size_t N>
+	class inline_vector : private detail::inline_vector_copy_base<T,N> {
+	private:
+		using size_storage = mm::smallest_unsigned_t<N>;
+
+		STATIC_ASSERT(N > 0,"inline_vector needs a capacity");
+
+		static mm::expected<void,mm::error> overflow() {
+			return mm::make_unexpected(mm::ERROR_CAPACITY_EXCEEDED);
+		}
+
+	public:
+		using value_type = T;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using reference = T&;
+		using const_reference = const T&;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using iterator = T*;
+		using const_iterator = const T*;
+		using reverse_iterator = mm::reverse_iterator<iterator>;
+		using const_reverse_iterator = mm::reverse_iterator<const_iterator>;
+
+		static constexpr size_type static_capacity = N;
+
+		inline_vector() = default;
+		inline_vector(const inline_vector&) = default;
+		inline_vector(inline_vector&&) = default;
+		inline_vector& operator=(const inline_vector&) = default;
+		inline_vector& operator=(inline_vector&&) = default;
+
+		iterator begin() { return data(); }
+		const_iterator begin() const { return data(); }
+		const_iterator cbegin() const { return data(); }
+		iterator end() { return data() + size(); }
+		const_iterator end() const { return data() + size(); }
+		const_iterator cend() const { return data() + size(); }
+		reverse_iterator rbegin() { return reverse_iterator(end()); }
+		const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+		reverse_iterator rend() { return reverse_iterator(begin()); }
+		const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+		T* data() { return base_data(); }
+		const T* data() const { return base_data(); }
+
+		size_type size() const { return this->m_size; }
+		constexpr size_type capacity() const { return N; }
+		constexpr size_type max_size() const { return N; }
+		bool empty() const { return this->m_size == 0; }
+		bool full() const { return this->m_size == N; }
+
+		// unchecked
+		T& operator[](size_type i) { return data()[i]; }
+		const T& operator[](size_type i) const { return data()[i]; }
+		T& front() { return data()[0]; }
+		const T& front() const { return data()[0]; }
+		T& back() { return data()[size() - 1]; }
+		const T& back() const { return data()[size() - 1]; }
+
+		template <class... Args>
+		mm::expected<void,mm::error> emplace_back(Args&&... args) {
+			if (full()) {
+				return overflow();
+			}
+
+			mm::construct_at(data() + size(),mm::forward<Args>(args)...);
+			++this->m_size;
+			return mm::expected<void,mm::error>();
+		}
+
+		mm::expected<void,mm::error> push_back(const T& value) {
+			return emplace_back(value);
+		}
+
+		mm::expected<void,mm::error> push_back(T&& value) {
+			return emplace_back(mm::move(value));
+		}
+
+		void pop_back() {
+			--this->m_size;
+			this->destroy(size(),size() + 1);
+		}
+
+		void clear() {
+			this->destroy(0,size());
+			this->m_size = 0;
+		}
+
+		// the new element is built before anything moves, so args may refer
+		// to elements of this vector
+		template <class... Args>
+		mm::expected<iterator,mm::error> emplace(const_iterator pos,Args&&... args) {
+			if (full()) {
+				return mm::make_unexpected(mm::ERROR_CAPACITY_EXCEEDED);
+			}
+
+			iterator p = begin() + (pos - cbegin());
+			iterator last = end();
+
+			if (p == last) {
+				mm::construct_at(last,mm::forward<Args>(args)...);
+			} else {
+				T value(mm::forward<Args>(args)...);
+				mm::construct_at(last,mm::move(last[-1]));
+
+				for (iterator it = last - 1; it != p; --it) {
+					*it = mm::move(it[-1]);
+				}
+
+				*p = mm::move(value);
+			}
+
+			++this->m_size;
+			return p;
+		}
+
+		mm::expected<iterator,mm::error> insert(const_iterator pos,const T& value) {
+			return emplace(pos,value);
+		}
+
+		mm::expected<iterator,mm::error> insert(const_iterator pos,T&& value) {
+			return emplace(pos,mm::move(value));
+		}
+
+		iterator erase(const_iterator first,const_iterator last) {
+			iterator p = begin() + (first - cbegin());
+			iterator q = begin() + (last - cbegin());
+
+			if (p != q) {
+				iterator out = p;
+
+				for (iterator it = q; it != end(); ++it, ++out) {
+					*out = mm::move(*it);
+				}
+
+				size_type n = static_cast<size_type>(out - begin());
+				this->destroy(n,size());
+				this->m_size = static_cast<size_storage>(n);
+			}
+
+			return p;
+		}
+
+		iterator erase(const_iterator pos) {
+			return erase(pos,pos + 1);
+		}
+
+		mm::expected<void,mm::error> resize(size_type n) {
+			if (n > N) {
+				return overflow();
+			}
+
+			for (size_type i = size(); i < n; ++i) {
+				mm::construct_at(data() + i);
+			}
+
+			this->destroy(n,size());
+			this->m_size = static_cast<size_storage>(n);
+			return mm::expected<void,mm::error>();
+		}
+
+		mm::expected<void,mm::error> resize(size_type n,const T& value) {
+			if (n > N) {
+				return overflow();
+			}
+
+			for (size_type i = size(); i < n; ++i) {
+				mm::construct_at(data() + i,value);
+			}
+
+			this->destroy(n,size());
+			this->m_size = static_cast<size_storage>(n);
+			return mm::expected<void,mm::error>();
+		}
+
+		// all or nothing, a range longer than N leaves the vector unchanged
+		template <class ForwardIter>
+		mm::expected<void,mm::error> assign(ForwardIter first,ForwardIter last) {
+			if (static_cast<size_type>(mm::distance(first,last)) > N) {
+				return overflow();
+			}
+
+			clear();
+
+			for (; first != last; ++first) {
+				mm::construct_at(data() + size(),*first);
+				++this->m_size;
+			}
+
+			return mm::expected<void,mm::error>();
+		}
+
+		void swap(inline_vector& other) {
+			inline_vector tmp(mm::move(other));
+			other = mm::move(*this);
+			*this = mm::move(tmp);
+		}
+
+	private:
+		T* base_data() { return detail::inline_vector_storage<T,N>::data(); }
+		const T* base_data() const { return detail::inline_vector_storage<T,N>::data(); }
+	};
+
+	template <class T,mm::size_t N>
+	constexpr typename mm::inline_vector<T,N>::size_type mm::inline_vector<T,N>::static_capacity;
+
+	template <class T,mm::size_t N>
+	bool operator==(const mm::inline_vector<T,N>& lhs,const mm::inline_vector<T,N>& rhs) {
+		if (lhs.size() != rhs.size()) {
+			return false;
+		}
+
+		for (mm::size_t i = 0; i < lhs.size(); ++i) {
+			if (!(lhs[i] == rhs[i])) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	template <class T,mm::size_t N>
+	bool operator!=(const mm::inline_vector<T,N>& lhs,const mm::inline_vector<T,N>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class T,mm::size_t N>
+	void swap(mm::inline_vector<T,N>& lhs,mm::inline_vector<T,N>& rhs) {
+		lhs.swap(rhs);
+	}
+}
+
+#endif
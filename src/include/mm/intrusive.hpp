@@ -0,0 +1,574 @@
+#ifndef MM_INTRUSIVE_HPP
+#define MM_INTRUSIVE_HPP
+#include "mm/memory.hpp"
+#include "mm/functional.hpp"
+#include "mm/span.hpp"
+#include "mm/error.hpp"
+
+// containers that link elements through hooks embedded in the elements, so
+// inserting and erasing never allocate and an element can unlink itself in
+// O(1) without knowing which container it is in. an element needs one hook
+// per container it can be in at the same time:
+//
+//	struct connection {
+//		mm::list_hook idle;
+//		mm::set_hook by_id;
+//	};
+//
+//	mm::intrusive_list<connection,mm::member_hook<connection,mm::list_hook,&connection::idle>> idle_list;
+//
+// inserting an element that is already linked moves it, and a hook unlinks
+// itself when its element is destroyed. since elements can leave without the
+// container being told, containers do not keep a count and size() walks
+
+namespace mm {
+	template <class T,class Hook> class intrusive_list;
+	template <class T,class Hook,class Hash,class Equal> class intrusive_hash_set;
+
+	class list_hook {
+	private:
+		template <class T,class Hook> friend class intrusive_list;
+		template <class T,class Hook,bool Const> friend class intrusive_list_iterator;
+
+		list_hook* m_next;
+		list_hook* m_prev;
+
+	public:
+		list_hook() : m_next(nullptr), m_prev(nullptr) {}
+
+		// a copied element starts out unlinked
+		list_hook(const list_hook&) : m_next(nullptr), m_prev(nullptr) {}
+
+		list_hook& operator=(const list_hook&) {
+			return *this;
+		}
+
+		~list_hook() {
+			unlink();
+		}
+
+		bool is_linked() const {
+			return m_next != nullptr;
+		}
+
+		void unlink() {
+			if (m_next) {
+				m_next->m_prev = m_prev;
+				m_prev->m_next = m_next;
+				m_next = nullptr;
+				m_prev = nullptr;
+			}
+		}
+	};
+
+	// singly linked forwards, the back pointer is to whichever pointer points
+	// at this hook (the bucket head or the previous hook's next) so unlinking
+	// does not need the bucket
+	class set_hook {
+	private:
+		template <class T,class Hook,class Hash,class Equal> friend class intrusive_hash_set;
+		template <class T,class Hook,bool Const> friend class intrusive_hash_set_iterator;
+
+		set_hook* m_next;
+		set_hook** m_pprev;
+
+	public:
+		set_hook() : m_next(nullptr), m_pprev(nullptr) {}
+		set_hook(const set_hook&) : m_next(nullptr), m_pprev(nullptr) {}
+
+		set_hook& operator=(const set_hook&) {
+			return *this;
+		}
+
+		~set_hook() {
+			unlink();
+		}
+
+		bool is_linked() const {
+			return m_pprev != nullptr;
+		}
+
+		void unlink() {
+			if (m_pprev) {
+				*m_pprev = m_next;
+
+				if (m_next) {
+					m_next->m_pprev = m_pprev;
+				}
+
+				m_next = nullptr;
+				m_pprev = nullptr;
+			}
+		}
+	};
+
+	// maps between an element and its HookType member
+	template <class T,class HookType,HookType T::*Member>
+	struct member_hook {
+		using value_type = T;
+		using hook_type = HookType;
+
+		static HookType* to_hook(T& value) {
+			return mm::address_of(value.*Member);
+		}
+
+		static T* to_value(HookType* hook) {
+			return reinterpret_cast<T*>(reinterpret_cast<char*>(hook) - offset());
+		}
+
+		static const T* to_value(const HookType* hook) {
+			return reinterpret_cast<const T*>(reinterpret_cast<const char*>(hook) - offset());
+		}
+
+	private:
+		static mm::size_t offset() {
+			mm::aligned_storage_t<sizeof(T),alignof(T)> storage;
+			T* value = reinterpret_cast<T*>(&storage);
+			return static_cast<mm::size_t>(reinterpret_cast<char*>(mm::address_of(value->*Member)) - reinterpret_cast<char*>(value));
+		}
+	};
+
+	template <class T,class Hook,bool Const>
+	class intrusive_list_iterator {
+	public:
+		using difference_type = mm::ptrdiff_t;
+		using value_type = T;
+		using pointer = mm::condition_t<Const,const T*,T*>;
+		using reference = mm::condition_t<Const,const T&,T&>;
+		using iterator_category = mm::bidirectional_iterator_tag;
+
+	private:
+		template <class U,class H> friend class intrusive_list;
+		template <class U,class H,bool C> friend class intrusive_list_iterator;
+
+		mm::list_hook* m_node;
+
+	public:
+		intrusive_list_iterator() : m_node(nullptr) {}
+		explicit intrusive_list_iterator(mm::list_hook* node) : m_node(node) {}
+
+		template <bool C = Const,mm::enable_if_t<C> = nullptr>
+		intrusive_list_iterator(const intrusive_list_iterator<T,Hook,false>& other) : m_node(other.m_node) {}
+
+		reference operator*() const { return *Hook::to_value(m_node); }
+		pointer operator->() const { return Hook::to_value(m_node); }
+
+		intrusive_list_iterator& operator++() { m_node = m_node->m_next; return *this; }
+		intrusive_list_iterator& operator--() { m_node = m_node->m_prev; return *this; }
+		intrusive_list_iterator operator++(int) { intrusive_list_iterator tmp(*this); m_node = m_node->m_next; return tmp; }
+		intrusive_list_iterator operator--(int) { intrusive_list_iterator tmp(*this); m_node = m_node->m_prev; return tmp; }
+
+		template <bool C> bool operator==(const intrusive_list_iterator<T,Hook,C>& other) const { return m_node == other.m_node; }
+		template <bool C> bool operator!=(const intrusive_list_iterator<T,Hook,C>& other) const { return m_node != other.m_node; }
+	};
+
+	// circular doubly linked list through a sentinel hook
+	template <class T,class Hook>
+	class intrusive_list {
+	public:
+		using value_type = T;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using reference = T&;
+		using const_reference = const T&;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using iterator = mm::intrusive_list_iterator<T,Hook,false>;
+		using const_iterator = mm::intrusive_list_iterator<T,Hook,true>;
+		using reverse_iterator = mm::reverse_iterator<iterator>;
+		using const_reverse_iterator = mm::reverse_iterator<const_iterator>;
+
+		STATIC_ASSERT((mm::is_same<typename Hook::hook_type,mm::list_hook>::value),"intrusive_list needs a list_hook");
+
+	private:
+		mm::list_hook m_root;
+
+		mm::list_hook* root() const {
+			return const_cast<mm::list_hook*>(&m_root);
+		}
+
+		void reset() {
+			m_root.m_next = &m_root;
+			m_root.m_prev = &m_root;
+		}
+
+		// moves hook when it is already linked somewhere
+		void link_before(mm::list_hook* position,mm::list_hook* hook) {
+			if (hook == position) {
+				return;
+			}
+
+			hook->unlink();
+			hook->m_next = position;
+			hook->m_prev = position->m_prev;
+			position->m_prev->m_next = hook;
+			position->m_prev = hook;
+		}
+
+	public:
+		intrusive_list() {
+			reset();
+		}
+
+		intrusive_list(const intrusive_list&) = delete;
+		intrusive_list& operator=(const intrusive_list&) = delete;
+
+		intrusive_list(intrusive_list&& other) {
+			reset();
+			splice(end(),other);
+		}
+
+		intrusive_list& operator=(intrusive_list&& other) {
+			if (this != &other) {
+				clear();
+				splice(end(),other);
+			}
+
+			return *this;
+		}
+
+		~intrusive_list() {
+			clear();
+			m_root.m_next = nullptr;
+		}
+
+		iterator begin() { return iterator(m_root.m_next); }
+		const_iterator begin() const { return const_iterator(m_root.m_next); }
+		const_iterator cbegin() const { return const_iterator(m_root.m_next); }
+		iterator end() { return iterator(root()); }
+		const_iterator end() const { return const_iterator(root()); }
+		const_iterator cend() const { return const_iterator(root()); }
+		reverse_iterator rbegin() { return reverse_iterator(end()); }
+		const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+		reverse_iterator rend() { return reverse_iterator(begin()); }
+		const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+		bool empty() const { return m_root.m_next == &m_root; }
+
+		// O(n)
+		size_type size() const {
+			size_type n = 0;
+
+			for (const mm::list_hook* hook = m_root.m_next; hook != &m_root; hook = hook->m_next) {
+				++n;
+			}
+
+			return n;
+		}
+
+		// unchecked
+		T& front() { return *Hook::to_value(m_root.m_next); }
+		const T& front() const { return *Hook::to_value(m_root.m_next); }
+		T& back() { return *Hook::to_value(m_root.m_prev); }
+		const T& back() const { return *Hook::to_value(m_root.m_prev); }
+
+		void push_back(T& value) {
+			link_before(&m_root,Hook::to_hook(value));
+		}
+
+		void push_front(T& value) {
+			link_before(m_root.m_next,Hook::to_hook(value));
+		}
+
+		void pop_back() {
+			m_root.m_prev->unlink();
+		}
+
+		void pop_front() {
+			m_root.m_next->unlink();
+		}
+
+		iterator insert(const_iterator position,T& value) {
+			mm::list_hook* hook = Hook::to_hook(value);
+			link_before(position.m_node,hook);
+			return iterator(hook);
+		}
+
+		iterator erase(const_iterator position) {
+			mm::list_hook* next = position.m_node->m_next;
+			position.m_node->unlink();
+			return iterator(next);
+		}
+
+		// O(1), the list it is in is not needed
+		static void remove(T& value) {
+			Hook::to_hook(value)->unlink();
+		}
+
+		static iterator iterator_to(T& value) {
+			return iterator(Hook::to_hook(value));
+		}
+
+		static const_iterator iterator_to(const T& value) {
+			return const_iterator(Hook::to_hook(const_cast<T&>(value)));
+		}
+
+		// moves every element of other before position, O(1)
+		void splice(const_iterator position,intrusive_list& other) {
+			if (other.empty() || &other == this) {
+				return;
+			}
+
+			mm::list_hook* first = other.m_root.m_next;
+			mm::list_hook* last = other.m_root.m_prev;
+			mm::list_hook* next = position.m_node;
+			other.reset();
+
+			first->m_prev = next->m_prev;
+			next->m_prev->m_next = first;
+			last->m_next = next;
+			next->m_prev = last;
+		}
+
+		void clear() {
+			while (!empty()) {
+				pop_front();
+			}
+		}
+
+		void swap(intrusive_list& other) {
+			intrusive_list tmp(mm::move(other));
+			other.splice(other.end(),*this);
+			splice(end(),tmp);
+		}
+	};
+
+	template <class T,class Hook,bool Const>
+	class intrusive_hash_set_iterator {
+	public:
+		using difference_type = mm::ptrdiff_t;
+		using value_type = T;
+		using pointer = mm::condition_t<Const,const T*,T*>;
+		using reference = mm::condition_t<Const,const T&,T&>;
+		using iterator_category = mm::forward_iterator_tag;
+
+	private:
+		template <class U,class H,bool C> friend class intrusive_hash_set_iterator;
+
+		mm::set_hook* const* m_bucket;
+		mm::set_hook* const* m_end;
+		mm::set_hook* m_node;
+
+		void skip_empty() {
+			while (!m_node && m_bucket != m_end && ++m_bucket != m_end) {
+				m_node = *m_bucket;
+			}
+		}
+
+	public:
+		intrusive_hash_set_iterator() : m_bucket(nullptr), m_end(nullptr), m_node(nullptr) {}
+
+		intrusive_hash_set_iterator(mm::set_hook* const* bucket,mm::set_hook* const* end) : m_bucket(bucket), m_end(end), m_node(bucket != end ? *bucket : nullptr) {
+			skip_empty();
+		}
+
+		intrusive_hash_set_iterator(mm::set_hook* const* bucket,mm::set_hook* const* end,mm::set_hook* node) : m_bucket(bucket), m_end(end), m_node(node) {}
+
+		template <bool C = Const,mm::enable_if_t<C> = nullptr>
+		intrusive_hash_set_iterator(const intrusive_hash_set_iterator<T,Hook,false>& other) : m_bucket(other.m_bucket), m_end(other.m_end), m_node(other.m_node) {}
+
+		reference operator*() const { return *Hook::to_value(m_node); }
+		pointer operator->() const { return Hook::to_value(m_node); }
+
+		intrusive_hash_set_iterator& operator++() {
+			m_node = m_node->m_next;
+			skip_empty();
+			return *this;
+		}
+
+		intrusive_hash_set_iterator operator++(int) {
+			intrusive_hash_set_iterator tmp(*this);
+			++*this;
+			return tmp;
+		}
+
+		template <bool C> bool operator==(const intrusive_hash_set_iterator<T,Hook,C>& other) const { return m_node == other.m_node; }
+		template <bool C> bool operator!=(const intrusive_hash_set_iterator<T,Hook,C>& other) const { return m_node != other.m_node; }
+	};
+
+	// one chain head, bucket arrays must start out null
+	using intrusive_bucket = mm::set_hook*;
+
+	// chained hash set over a bucket array the caller owns, a power of two in
+	// length. Hash is called with elements and with lookup keys, Equal with an
+	// element and a key. rehash moves every element to a new bucket array
+	template <class T,class Hook,class Hash,class Equal = mm::equal_to<>>
+	class intrusive_hash_set {
+	public:
+		using value_type = T;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using hasher = Hash;
+		using key_equal = Equal;
+		using reference = T&;
+		using const_reference = const T&;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using iterator = mm::intrusive_hash_set_iterator<T,Hook,false>;
+		using const_iterator = mm::intrusive_hash_set_iterator<T,Hook,true>;
+
+		STATIC_ASSERT((mm::is_same<typename Hook::hook_type,mm::set_hook>::value),"intrusive_hash_set needs a set_hook");
+
+	private:
+		mm::span<mm::intrusive_bucket> m_buckets;
+		mm::compressed_pair<Hash,Equal> m_fns;
+
+		static void check_buckets(mm::span<mm::intrusive_bucket> buckets) {
+			ASSERT(
+				!buckets.empty() && (buckets.size() & (buckets.size() - 1)) == 0,
+				mm::ERROR_GENERAL,
+				"intrusive_hash_set bucket count must be a power of two"
+			);
+		}
+
+		template <class K>
+		mm::intrusive_bucket& bucket_for(const K& key) {
+			return m_buckets[static_cast<size_type>(m_fns.first()(key)) & (m_buckets.size() - 1)];
+		}
+
+		template <class K>
+		mm::set_hook* find_hook(mm::intrusive_bucket& head,const K& key) const {
+			for (mm::set_hook* hook = head; hook; hook = hook->m_next) {
+				if (m_fns.second()(*Hook::to_value(hook),key)) {
+					return hook;
+				}
+			}
+
+			return nullptr;
+		}
+
+		static void link(mm::intrusive_bucket& head,mm::set_hook* hook) {
+			hook->m_next = head;
+			hook->m_pprev = &head;
+
+			if (head) {
+				head->m_pprev = &hook->m_next;
+			}
+
+			head = hook;
+		}
+
+	public:
+		explicit intrusive_hash_set(mm::span<mm::intrusive_bucket> buckets,const Hash& hash = Hash(),const Equal& equal = Equal()) :
+			m_buckets(buckets),
+			m_fns(hash,equal)
+		{
+			check_buckets(buckets);
+		}
+
+		intrusive_hash_set(const intrusive_hash_set&) = delete;
+		intrusive_hash_set& operator=(const intrusive_hash_set&) = delete;
+
+		~intrusive_hash_set() {
+			clear();
+		}
+
+		iterator begin() { return iterator(m_buckets.data(),m_buckets.data() + m_buckets.size()); }
+		const_iterator begin() const { return const_iterator(m_buckets.data(),m_buckets.data() + m_buckets.size()); }
+		iterator end() { return iterator(m_buckets.data() + m_buckets.size(),m_buckets.data() + m_buckets.size(),nullptr); }
+		const_iterator end() const { return const_iterator(m_buckets.data() + m_buckets.size(),m_buckets.data() + m_buckets.size(),nullptr); }
+
+		size_type bucket_count() const { return m_buckets.size(); }
+
+		bool empty() const {
+			for (mm::intrusive_bucket head : m_buckets) {
+				if (head) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		// O(n + buckets)
+		size_type size() const {
+			size_type n = 0;
+
+			for (mm::intrusive_bucket head : m_buckets) {
+				for (mm::set_hook* hook = head; hook; hook = hook->m_next) {
+					++n;
+				}
+			}
+
+			return n;
+		}
+
+		// false when an equal element is already present. an element linked
+		// into another set is moved
+		bool insert(T& value) {
+			mm::intrusive_bucket& head = bucket_for(value);
+
+			if (find_hook(head,value)) {
+				return false;
+			}
+
+			mm::set_hook* hook = Hook::to_hook(value);
+			hook->unlink();
+			link(head,hook);
+			return true;
+		}
+
+		template <class K>
+		T* find(const K& key) {
+			mm::set_hook* hook = find_hook(bucket_for(key),key);
+			return hook ? Hook::to_value(hook) : nullptr;
+		}
+
+		template <class K>
+		const T* find(const K& key) const {
+			return const_cast<intrusive_hash_set*>(this)->find(key);
+		}
+
+		template <class K>
+		bool contains(const K& key) const {
+			return find(key) != nullptr;
+		}
+
+		// O(1), the set it is in is not needed
+		static void erase(T& value) {
+			Hook::to_hook(value)->unlink();
+		}
+
+		// the element that was removed, if any
+		template <class K>
+		T* erase_key(const K& key) {
+			mm::set_hook* hook = find_hook(bucket_for(key),key);
+
+			if (!hook) {
+				return nullptr;
+			}
+
+			hook->unlink();
+			return Hook::to_value(hook);
+		}
+
+		void clear() {
+			for (mm::intrusive_bucket& head : m_buckets) {
+				while (head) {
+					head->unlink();
+				}
+			}
+		}
+
+		// relinks every element into buckets, which must be null, and returns
+		// the old bucket array to the caller
+		mm::span<mm::intrusive_bucket> rehash(mm::span<mm::intrusive_bucket> buckets) {
+			check_buckets(buckets);
+
+			mm::span<mm::intrusive_bucket> old = m_buckets;
+			m_buckets = buckets;
+
+			for (mm::intrusive_bucket& head : old) {
+				while (head) {
+					mm::set_hook* hook = head;
+					hook->unlink();
+					link(bucket_for(*Hook::to_value(hook)),hook);
+				}
+			}
+
+			return old;
+		}
+	};
+}
+
+#endif
@@ -9,6 +9,10 @@ namespace mm {
 	struct bidirectional_iterator_tag : mm::forward_iterator_tag {};
 	struct random_access_iterator_tag : mm::bidirectional_iterator_tag {};
 
+	// elements are adjacent in memory, so [first,last) can be handled as a raw
+	// pointer range (see mm::to_address)
+	struct contiguous_iterator_tag : mm::random_access_iterator_tag {};
+
 	template <class Iter>
 	struct iterator_traits {
 		using difference_type = typename Iter::difference_type;
@@ -24,7 +28,7 @@ namespace mm {
 		using value_type = T;
 		using pointer = T*;
 		using reference = T&;
-		using iterator_category = mm::random_access_iterator_tag;
+		using iterator_category = mm::contiguous_iterator_tag;
 	};
 
 	template <class T>
@@ -33,9 +37,22 @@ namespace mm {
 		using value_type = T;
 		using pointer = const T*;
 		using reference = const T&;
-		using iterator_category = mm::random_access_iterator_tag;
+		using iterator_category = mm::contiguous_iterator_tag;
 	};
 
+	template <class Iter>
+	struct is_contiguous_iterator : mm::is_base_of<mm::contiguous_iterator_tag,typename mm::iterator_traits<Iter>::iterator_category> {};
+
+	namespace detail {
+		// adaptors that walk or dereference differently are at most random access
+		template <class Iter>
+		using adapted_iterator_category = mm::condition_t<
+			mm::is_contiguous_iterator<Iter>::value,
+			mm::random_access_iterator_tag,
+			typename mm::iterator_traits<Iter>::iterator_category
+		>;
+	}
+
 	template <class Iter>
 	class reverse_iterator {
 	public:
@@ -44,7 +61,7 @@ namespace mm {
 		using value_type = typename mm::iterator_traits<Iter>::value_type;
 		using pointer = typename mm::iterator_traits<Iter>::pointer;
 		using reference = typename mm::iterator_traits<Iter>::reference;
-		using iterator_category = typename mm::iterator_traits<Iter>::iterator_category;
+		using iterator_category = detail::adapted_iterator_category<Iter>;
 
 	private:
 		iterator_type m_current;
@@ -76,7 +93,7 @@ namespace mm {
 		}
 
 		reference operator[](difference_type n) const {
-			return m_current[-n + 1];
+			return m_current[-n - 1];
 		}
 
 		reverse_iterator& operator++() {
@@ -89,19 +106,23 @@ namespace mm {
 			return *this;
 		}
 
-		reverse_iterator operator++(int) const {
-			return reverse_iterator(m_current - 1);
+		reverse_iterator operator++(int) {
+			reverse_iterator tmp(*this);
+			--m_current;
+			return tmp;
 		}
 
-		reverse_iterator operator--(int) const {
-			return reverse_iterator(m_current + 1);
+		reverse_iterator operator--(int) {
+			reverse_iterator tmp(*this);
+			++m_current;
+			return tmp;
 		}
 
-		reverse_iterator operator+(difference_type n) {
+		reverse_iterator operator+(difference_type n) const {
 			return reverse_iterator(m_current - n);
 		}
 
-		reverse_iterator operator-(difference_type n) {
+		reverse_iterator operator-(difference_type n) const {
 			return reverse_iterator(m_current + n);
 		}
 
@@ -128,22 +149,27 @@ namespace mm {
 
 	template <class Iter1,class Iter2>
 	bool operator>(const mm::reverse_iterator<Iter1>& lhs,const mm::reverse_iterator<Iter2>& rhs) {
-		return lhs.base() > rhs.base();
+		return lhs.base() < rhs.base();
 	}
 
 	template <class Iter1,class Iter2>
 	bool operator<(const mm::reverse_iterator<Iter1>& lhs,const mm::reverse_iterator<Iter2>& rhs) {
-		return lhs.base() < rhs.base();
+		return lhs.base() > rhs.base();
 	}
 
 	template <class Iter1,class Iter2>
 	bool operator>=(const mm::reverse_iterator<Iter1>& lhs,const mm::reverse_iterator<Iter2>& rhs) {
-		return lhs.base() >= rhs.base();
+		return lhs.base() <= rhs.base();
 	}
 
 	template <class Iter1,class Iter2>
 	bool operator<=(const mm::reverse_iterator<Iter1>& lhs,const mm::reverse_iterator<Iter2>& rhs) {
-		return lhs.base() <= rhs.base();
+		return lhs.base() >= rhs.base();
+	}
+
+	template <class Iter1,class Iter2>
+	auto operator-(const mm::reverse_iterator<Iter1>& lhs,const mm::reverse_iterator<Iter2>& rhs) -> decltype(rhs.base() - lhs.base()) {
+		return rhs.base() - lhs.base();
 	}
 
 	template <class Iter>
@@ -183,7 +209,7 @@ namespace mm {
 		reverse_adapter& operator=(const reverse_adapter&) = delete;
 		reverse_adapter& operator=(reverse_adapter&&) = delete;
 
-		reverse_adapter(const container_type& c) : m_container(c) {}
+		reverse_adapter(container_type& c) : m_container(c) {}
 
 		reverse_iterator begin() { return m_container.rbegin(); }
 		const_reverse_iterator cbegin() const { return m_container.crbegin(); }
@@ -206,7 +232,7 @@ namespace mm {
 		using value_type = typename mm::iterator_traits<Iter>::value_type;
 		using pointer = typename mm::iterator_traits<Iter>::pointer;
 		using reference = value_type&&;
-		using iterator_category = typename mm::iterator_traits<Iter>::iterator_category;
+		using iterator_category = detail::adapted_iterator_category<Iter>;
 
 	private:
 		iterator_type m_current;
@@ -224,7 +250,7 @@ namespace mm {
 			return *this;
 		}
 
-		iterator_type base() {
+		iterator_type base() const {
 			return m_current;
 		}
 
@@ -233,7 +259,7 @@ namespace mm {
 		}
 
 		reference operator[](difference_type n) const {
-			return mm::move(*m_current[n]);
+			return mm::move(m_current[n]);
 		}
 
 		move_iterator& operator++() {
@@ -246,12 +272,16 @@ namespace mm {
 			return *this;
 		}
 
-		move_iterator operator++(int) const {
-			return move_iterator(m_current + 1);
+		move_iterator operator++(int) {
+			move_iterator tmp(*this);
+			++m_current;
+			return tmp;
 		}
 
-		move_iterator operator--(int) const {
-			return move_iterator(m_current - 1);
+		move_iterator operator--(int) {
+			move_iterator tmp(*this);
+			--m_current;
+			return tmp;
 		}
 
 		move_iterator operator+(difference_type n) const {
@@ -303,6 +333,11 @@ namespace mm {
 		return lhs.base() <= rhs.base();
 	}
 
+	template <class Iter1,class Iter2>
+	auto operator-(const mm::move_iterator<Iter1>& lhs,const mm::move_iterator<Iter2>& rhs) -> decltype(lhs.base() - rhs.base()) {
+		return lhs.base() - rhs.base();
+	}
+
 	template <class Iter>
 	mm::move_iterator<Iter> operator+(typename mm::move_iterator<Iter>::difference_type n,const mm::move_iterator<Iter>& it) {
 		return mm::move_iterator<Iter>(it.base() + n);
@@ -325,10 +360,8 @@ namespace mm {
 		using value_type = typename container_type::value_type;
 		using size_type = typename container_type::size_type;
 		using difference_type = typename container_type::difference_type;
-		using iterator = typename container_type::iterator;
-		using const_iterator = typename container_type::const_iterator;
-		using reverse_iterator = typename container_type::reverse_iterator;
-		using const_reverse_iterator = typename container_type::const_reverse_iterator;
+		using iterator = mm::move_iterator<typename container_type::iterator>;
+		using reverse_iterator = mm::move_iterator<typename container_type::reverse_iterator>;
 
 	private:
 		container_type& m_container;
@@ -340,19 +373,13 @@ namespace mm {
 		move_adapter& operator=(const move_adapter&) = delete;
 		move_adapter& operator=(move_adapter&&) = delete;
 
-		move_adapter(const container_type& c) : m_container(c) {}
+		move_adapter(container_type& c) : m_container(c) {}
 
-		reverse_iterator begin() { return mm::make_move_iterator(m_container.begin()); }
-		const_reverse_iterator cbegin() const { return mm::make_move_iterator(m_container.cbegin()); }
+		iterator begin() { return mm::make_move_iterator(m_container.begin()); }
+		iterator end() { return mm::make_move_iterator(m_container.end()); }
 
-		reverse_iterator end() { return mm::make_move_iterator(m_container.end()); }
-		const_reverse_iterator cend() const { return mm::make_move_iterator(m_container.cend()); }
-
-		iterator rbegin() { return mm::make_move_iterator(m_container.begin()); }
-		const_iterator crbegin() const { return mm::make_move_iterator(m_container.crbegin()); }
-
-		iterator rend() { return mm::make_move_iterator(m_container.end()); }
-		const_iterator crend() const { return mm::make_move_iterator(m_container.crend()); }
+		reverse_iterator rbegin() { return mm::make_move_iterator(m_container.rbegin()); }
+		reverse_iterator rend() { return mm::make_move_iterator(m_container.rend()); }
 	};
 
 	template <class Container>
@@ -366,11 +393,11 @@ namespace mm {
 		using container_type = Container;
 
 	private:
-		container_type m_container;
+		container_type* m_container;
 
 	public:
 		back_insert_iterator() : m_container(nullptr) {}
-		back_insert_iterator(const container_type& c) : m_container(mm::address_of(c)) {}
+		back_insert_iterator(container_type& c) : m_container(mm::address_of(c)) {}
 
 		back_insert_iterator& operator=(const typename container_type::value_type& value) {
 			m_container->push_back(value);
@@ -411,11 +438,11 @@ namespace mm {
 		using container_type = Container;
 
 	private:
-		container_type m_container;
+		container_type* m_container;
 
 	public:
 		front_insert_iterator() : m_container(nullptr) {}
-		front_insert_iterator(const container_type& c) : m_container(mm::address_of(c)) {}
+		front_insert_iterator(container_type& c) : m_container(mm::address_of(c)) {}
 
 		front_insert_iterator& operator=(const typename container_type::value_type& value) {
 			m_container->push_front(value);
@@ -525,7 +552,7 @@ namespace mm {
 		detail::advance_impl<Iter>(
 			it,
 			typename mm::iterator_traits<Iter>::difference_type(n),
-			mm::iterator_traits<Iter>::iterator_category
+			typename mm::iterator_traits<Iter>::iterator_category()
 		);
 	}
 
@@ -553,7 +580,7 @@ namespace mm {
 		return detail::distance_impl<Iter>(
 			first,
 			last,
-			mm::iterator_traits<Iter>::iterator_category
+			typename mm::iterator_traits<Iter>::iterator_category()
 		);
 	}
 
@@ -0,0 +1,491 @@
+#ifndef MM_LOG_HPP
+#define MM_LOG_HPP
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include "mm/common.hpp"
+
+// asynchronous logging behind the PRINTF/INFO/WARNING macros, compiled in with
+// ASYNC_LOGGING. a log call copies the format string pointer and its arguments
+// as a binary record into the calling thread's ring buffer and returns, a
+// background thread drains the rings and does the formatting and the stdio
+// calls. the rings are single producer single consumer, so logging never takes
+// a lock or makes a system call. when a ring is full the record is dropped and
+// counted rather than blocking the caller. records from different threads are
+// not ordered relative to each other
+//
+// the format has to be a string literal since it is read after the call
+// returns, string arguments are copied (truncated to log_max_string bytes).
+// conversions are applied to the stored argument type, so length modifiers are
+// ignored and '*' widths are not supported
+
+namespace mm {
+	enum log_level {
+		LOG_PRINTF = LOG_LEVEL_PRINTF,
+		LOG_INFO = LOG_LEVEL_INFO,
+		LOG_WARNING = LOG_LEVEL_WARNING,
+		LOG_ERROR = LOG_LEVEL_ERROR
+	};
+
+	namespace detail {
+		constexpr mm::size_t log_ring_capacity = 1 << 18;
+		constexpr mm::size_t log_max_string = 1024;
+		constexpr mm::u8 log_record_padding = 0xff;
+
+		enum log_arg_type {
+			LOG_ARG_INT,
+			LOG_ARG_UINT,
+			LOG_ARG_DOUBLE,
+			LOG_ARG_POINTER,
+			LOG_ARG_STRING
+		};
+
+		// records are 8 byte aligned and never straddle the end of the ring
+		struct log_record {
+			mm::u32 size;
+			mm::u8 level;
+			mm::u8 args;
+			mm::u16 reserved;
+			const char* format;
+		};
+
+		// every argument starts with an 8 byte slot holding its type and, for
+		// strings, the length of the copied bytes that follow
+		struct log_arg {
+			mm::u32 type;
+			mm::u32 length;
+		};
+
+		struct log_ring {
+			alignas(mm::hardware_destructive_interference_size) mm::u64 head; // written by the owning thread
+			alignas(mm::hardware_destructive_interference_size) mm::u64 tail; // written by the flusher
+			alignas(mm::hardware_destructive_interference_size) bool in_use;
+			log_ring* next;
+			mm::u8 data[log_ring_capacity];
+		};
+
+		// zero or constant initialised, so it is usable before any constructor runs
+		struct log_state {
+			log_ring* rings;
+			int status; // 0 never started, 1 running, 2 stopped
+			bool stop;
+			mm::u64 dropped;
+			pthread_t flusher;
+			pthread_key_t key;
+			pthread_once_t key_once;
+			pthread_mutex_t consumer; // serialises draining, producers never take it
+		};
+
+		// constant initialised statics need no guard, and being inline there is
+		// one of each however many translation units include this header
+		inline log_state& logger() {
+			static log_state state = { nullptr,0,false,0,pthread_t(),pthread_key_t(),PTHREAD_ONCE_INIT,PTHREAD_MUTEX_INITIALIZER };
+			return state;
+		}
+
+		inline log_ring*& log_thread_ring() {
+			static __thread log_ring* ring;
+			return ring;
+		}
+
+		inline mm::size_t log_align(mm::size_t bytes) {
+			return (bytes + 7) & ~mm::size_t(7);
+		}
+
+		// arguments are first reduced to the type they are stored as, and both
+		// the sizing and the writing below are given that type, so a char* or
+		// char array is sized as the string it is written as. plain overloads
+		// rather than type traits keep this header usable from common.hpp,
+		// unscoped enums promote to int
+		inline const char* log_arg_decay(const char* s) { return s; }
+		inline long long log_arg_decay(bool value) { return value; }
+		inline long long log_arg_decay(char value) { return value; }
+		inline long long log_arg_decay(signed char value) { return value; }
+		inline long long log_arg_decay(short value) { return value; }
+		inline long long log_arg_decay(int value) { return value; }
+		inline long long log_arg_decay(long value) { return value; }
+		inline long long log_arg_decay(long long value) { return value; }
+		inline unsigned long long log_arg_decay(unsigned char value) { return value; }
+		inline unsigned long long log_arg_decay(unsigned short value) { return value; }
+		inline unsigned long long log_arg_decay(unsigned int value) { return value; }
+		inline unsigned long long log_arg_decay(unsigned long value) { return value; }
+		inline unsigned long long log_arg_decay(unsigned long long value) { return value; }
+		inline double log_arg_decay(double value) { return value; }
+		inline const void* log_arg_decay(const void* value) { return value; }
+		inline const void* log_arg_decay(mm::nullptr_t) { return nullptr; }
+
+		// strings are copied and everything else takes one 8 byte slot
+		inline mm::size_t log_arg_size(const char* s) {
+			mm::size_t length = s ? strnlen(s,log_max_string) : 6;
+			return sizeof(log_arg) + log_align(length + 1);
+		}
+
+		inline mm::size_t log_arg_size(long long) { return sizeof(log_arg) + 8; }
+		inline mm::size_t log_arg_size(unsigned long long) { return sizeof(log_arg) + 8; }
+		inline mm::size_t log_arg_size(double) { return sizeof(log_arg) + 8; }
+		inline mm::size_t log_arg_size(const void*) { return sizeof(log_arg) + 8; }
+
+		inline void log_arg_header(mm::u8*& out,log_arg_type type,mm::u32 length) {
+			log_arg header = { static_cast<mm::u32>(type),length };
+			memcpy(out,&header,sizeof(header));
+			out += sizeof(header);
+		}
+
+		template <class T>
+		void log_arg_scalar(mm::u8*& out,log_arg_type type,T value) {
+			log_arg_header(out,type,0);
+			memcpy(out,&value,sizeof(value));
+			out += 8;
+		}
+
+		inline void log_arg_write(mm::u8*& out,const char* s) {
+			if (!s) {
+				s = "(null)";
+			}
+
+			mm::size_t length = strnlen(s,log_max_string);
+			log_arg_header(out,LOG_ARG_STRING,static_cast<mm::u32>(length));
+			memcpy(out,s,length);
+			out[length] = '\0';
+			out += log_align(length + 1);
+		}
+
+		inline void log_arg_write(mm::u8*& out,long long value) { log_arg_scalar(out,LOG_ARG_INT,value); }
+		inline void log_arg_write(mm::u8*& out,unsigned long long value) { log_arg_scalar(out,LOG_ARG_UINT,value); }
+		inline void log_arg_write(mm::u8*& out,double value) { log_arg_scalar(out,LOG_ARG_DOUBLE,value); }
+		inline void log_arg_write(mm::u8*& out,const void* value) { log_arg_scalar(out,LOG_ARG_POINTER,value); }
+
+		// printf style formatting of a single stored argument
+		inline void log_format_arg(FILE* file,const char* spec,mm::size_t spec_length,char conversion,const log_arg& arg,const mm::u8* payload) {
+			// the length modifier is replaced to match the stored type
+			char buffer[64];
+
+			if (spec_length > sizeof(buffer) - 4) {
+				spec_length = sizeof(buffer) - 4;
+			}
+
+			mm::size_t n = 0;
+
+			for (mm::size_t i = 0; i < spec_length - 1; ++i) {
+				if (!strchr("hlLqjzt",spec[i])) {
+					buffer[n++] = spec[i];
+				}
+			}
+
+			long long i;
+			double d;
+			const void* p;
+			memcpy(&i,payload,sizeof(i));
+			memcpy(&d,payload,sizeof(d));
+			memcpy(&p,payload,sizeof(p));
+
+			if (arg.type == LOG_ARG_DOUBLE) {
+				i = static_cast<long long>(d);
+			} else if (arg.type == LOG_ARG_INT) {
+				d = static_cast<double>(i);
+			} else if (arg.type == LOG_ARG_UINT) {
+				d = static_cast<double>(static_cast<unsigned long long>(i));
+			}
+
+			if (strchr("diouxX",conversion)) {
+				buffer[n++] = 'l';
+				buffer[n++] = 'l';
+				buffer[n++] = conversion;
+				buffer[n] = '\0';
+				fprintf(file,buffer,i);
+			} else if (strchr("fFeEgGaA",conversion)) {
+				buffer[n++] = conversion;
+				buffer[n] = '\0';
+				fprintf(file,buffer,d);
+			} else if (conversion == 'c') {
+				buffer[n++] = conversion;
+				buffer[n] = '\0';
+				fprintf(file,buffer,static_cast<int>(i));
+			} else if (conversion == 'p') {
+				buffer[n++] = conversion;
+				buffer[n] = '\0';
+				fprintf(file,buffer,p);
+			} else if (conversion == 's' && arg.type == LOG_ARG_STRING) {
+				buffer[n++] = conversion;
+				buffer[n] = '\0';
+				fprintf(file,buffer,reinterpret_cast<const char*>(payload));
+			} else {
+				fwrite(spec,1,spec_length,file);
+			}
+		}
+
+		inline void log_format(const log_record& record,const mm::u8* payload) {
+			FILE* file = record.level >= LOG_WARNING ? stderr : stdout;
+
+			if (record.level == LOG_INFO) {
+				fputs("\033[36mINFO\033[0m: ",file);
+			} else if (record.level == LOG_WARNING) {
+				fputs("\033[33mWARNING\033[0m: ",file);
+			} else if (record.level == LOG_ERROR) {
+				fputs("\033[31mERROR\033[0m: ",file);
+			}
+
+			const char* it = record.format;
+			mm::size_t remaining = record.args;
+
+			while (*it) {
+				const char* percent = strchr(it,'%');
+
+				if (!percent) {
+					fputs(it,file);
+					break;
+				}
+
+				fwrite(it,1,percent - it,file);
+
+				if (percent[1] == '%') {
+					fputc('%',file);
+					it = percent + 2;
+					continue;
+				}
+
+				// flags, width, precision and length, then the conversion
+				const char* end = percent + 1 + strspn(percent + 1,"-+ #0123456789.hlLqjzt");
+
+				if (!*end) {
+					fputs(percent,file);
+					break;
+				}
+
+				mm::size_t spec_length = end - percent + 1;
+
+				if (remaining == 0) {
+					fwrite(percent,1,spec_length,file);
+				} else {
+					log_arg arg;
+					memcpy(&arg,payload,sizeof(arg));
+					payload += sizeof(arg);
+
+					log_format_arg(file,percent,spec_length,*end,arg,payload);
+					payload += arg.type == LOG_ARG_STRING ? log_align(arg.length + 1) : 8;
+					--remaining;
+				}
+
+				it = end + 1;
+			}
+
+			fputc('\n',file);
+		}
+
+		// returns whether anything was written, the caller holds logger().consumer
+		inline bool log_drain(log_ring* ring) {
+			mm::u64 tail = ring->tail;
+			mm::u64 head = __atomic_load_n(&ring->head,__ATOMIC_ACQUIRE);
+
+			if (tail == head) {
+				return false;
+			}
+
+			while (tail != head) {
+				const mm::u8* at = ring->data + (tail & (log_ring_capacity - 1));
+				log_record record;
+
+				// padding can be as short as 8 bytes at the very end of the ring
+				memcpy(&record,at,sizeof(mm::u64));
+
+				if (record.level != log_record_padding) {
+					memcpy(&record,at,sizeof(record));
+					log_format(record,at + sizeof(record));
+				}
+
+				tail += record.size;
+			}
+
+			__atomic_store_n(&ring->tail,tail,__ATOMIC_RELEASE);
+			return true;
+		}
+
+		inline bool log_drain_all() {
+			bool wrote = false;
+
+			pthread_mutex_lock(&logger().consumer);
+
+			for (log_ring* it = __atomic_load_n(&logger().rings,__ATOMIC_ACQUIRE); it; it = it->next) {
+				wrote |= log_drain(it);
+			}
+
+			mm::u64 dropped = __atomic_exchange_n(&logger().dropped,0,__ATOMIC_RELAXED);
+
+			if (dropped) {
+				fprintf(stderr,"\033[33mWARNING\033[0m: dropped %llu log records\n",static_cast<unsigned long long>(dropped));
+			}
+
+			if (wrote) {
+				fflush(stdout);
+				fflush(stderr);
+			}
+
+			pthread_mutex_unlock(&logger().consumer);
+			return wrote;
+		}
+
+		// polls rather than being woken so producers never make a system call.
+		// the poll interval starts at 50us after any output and backs off to
+		// 1ms while idle, so a burst is drained before it fills a ring
+		inline void* log_flusher(void*) {
+			long interval = 50000;
+
+			while (!__atomic_load_n(&logger().stop,__ATOMIC_ACQUIRE)) {
+				if (log_drain_all()) {
+					interval = 50000;
+				} else {
+					timespec idle = { 0,interval };
+					nanosleep(&idle,nullptr);
+					interval = interval < 1000000 ? interval * 2 : 1000000;
+				}
+			}
+
+			log_drain_all();
+			return nullptr;
+		}
+
+		// rings are never freed, a thread that exits leaves its ring for the next
+		// new thread to pick up once the flusher has drained it
+		inline void log_thread_exit(void* ring) {
+			__atomic_store_n(&static_cast<log_ring*>(ring)->in_use,false,__ATOMIC_RELEASE);
+		}
+
+		inline void log_create_key() {
+			pthread_key_create(&logger().key,&log_thread_exit);
+		}
+
+		inline log_ring* log_acquire_ring() {
+			pthread_once(&logger().key_once,&log_create_key);
+
+			for (log_ring* it = __atomic_load_n(&logger().rings,__ATOMIC_ACQUIRE); it; it = it->next) {
+				bool expected = false;
+
+				if (!__atomic_load_n(&it->in_use,__ATOMIC_RELAXED) && __atomic_compare_exchange_n(&it->in_use,&expected,true,false,__ATOMIC_ACQUIRE,__ATOMIC_RELAXED)) {
+					// a ring still holding records from its last thread would
+					// leave the new one little or no room, skip it until drained
+					if (it->head == __atomic_load_n(&it->tail,__ATOMIC_ACQUIRE)) {
+						pthread_setspecific(logger().key,it);
+						return it;
+					}
+
+					__atomic_store_n(&it->in_use,false,__ATOMIC_RELEASE);
+				}
+			}
+
+			log_ring* ring = static_cast<log_ring*>(aligned_alloc(alignof(log_ring),sizeof(log_ring)));
+
+			if (!ring) {
+				return nullptr;
+			}
+
+			ring->head = 0;
+			ring->tail = 0;
+			ring->in_use = true;
+			ring->next = __atomic_load_n(&logger().rings,__ATOMIC_RELAXED);
+
+			while (!__atomic_compare_exchange_n(&logger().rings,&ring->next,ring,true,__ATOMIC_RELEASE,__ATOMIC_RELAXED)) {}
+
+			pthread_setspecific(logger().key,ring);
+			return ring;
+		}
+
+		inline void log_stop_at_exit();
+
+		inline void log_start() {
+			int expected = 0;
+
+			if (__atomic_compare_exchange_n(&logger().status,&expected,1,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)) {
+				if (pthread_create(&logger().flusher,nullptr,&log_flusher,nullptr) == 0) {
+					atexit(&log_stop_at_exit);
+				} else {
+					__atomic_store_n(&logger().status,2,__ATOMIC_RELEASE);
+				}
+			}
+		}
+
+		inline void log_stop() {
+			int expected = 1;
+
+			if (__atomic_compare_exchange_n(&logger().status,&expected,2,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)) {
+				__atomic_store_n(&logger().stop,true,__ATOMIC_RELEASE);
+				pthread_join(logger().flusher,nullptr);
+			}
+
+			log_drain_all();
+		}
+
+		inline void log_stop_at_exit() {
+			log_stop();
+		}
+
+		template <class... Args>
+		void log_write(mm::log_level level,const char* format,const Args&... args) {
+			log_ring* ring = log_thread_ring();
+
+			if (!ring) {
+				ring = log_thread_ring() = log_acquire_ring();
+
+				if (!ring) {
+					__atomic_fetch_add(&logger().dropped,1,__ATOMIC_RELAXED);
+					return;
+				}
+			}
+
+			mm::size_t sizes[] = { sizeof(log_record),log_arg_size(log_arg_decay(args))... };
+			mm::size_t size = 0;
+
+			for (mm::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+				size += sizes[i];
+			}
+
+			mm::u64 head = ring->head;
+			mm::u64 tail = __atomic_load_n(&ring->tail,__ATOMIC_ACQUIRE);
+			mm::size_t offset = head & (log_ring_capacity - 1);
+			mm::size_t contiguous = log_ring_capacity - offset;
+			mm::size_t needed = size <= contiguous ? size : size + contiguous;
+
+			if (size > log_ring_capacity / 2 || log_ring_capacity - (head - tail) < needed) {
+				__atomic_fetch_add(&logger().dropped,1,__ATOMIC_RELAXED);
+				return;
+			}
+
+			if (size > contiguous) {
+				log_record padding = { static_cast<mm::u32>(contiguous),log_record_padding,0,0,nullptr };
+				memcpy(ring->data + offset,&padding,sizeof(mm::u64));
+				head += contiguous;
+				offset = 0;
+			}
+
+			log_record record = { static_cast<mm::u32>(size),static_cast<mm::u8>(level),static_cast<mm::u8>(sizeof...(Args)),0,format };
+			mm::u8* out = ring->data + offset;
+			memcpy(out,&record,sizeof(record));
+			out += sizeof(record);
+
+			int expand[] = { 0,(log_arg_write(out,log_arg_decay(args)),0)... };
+			(void)expand;
+
+			__atomic_store_n(&ring->head,head + size,__ATOMIC_RELEASE);
+
+			if (__atomic_load_n(&logger().status,__ATOMIC_ACQUIRE) != 1) {
+				if (__atomic_load_n(&logger().status,__ATOMIC_ACQUIRE) == 0) {
+					log_start();
+				} else {
+					// logging after shutdown falls back to draining inline
+					log_drain_all();
+				}
+			}
+		}
+	}
+
+	// writes out everything logged so far, from any thread
+	inline void log_flush() {
+		detail::log_drain_all();
+	}
+
+	// stops the flusher thread after draining, also registered with atexit
+	inline void log_shutdown() {
+		detail::log_stop();
+	}
+}
+
+#endif
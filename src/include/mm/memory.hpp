@@ -1,7 +1,12 @@
 #ifndef MM_MEMORY_HPP
 #define MM_MEMORY_HPP
+#include <string.h>
 #include "mm/iterator.hpp"
 #include "mm/limits.hpp"
+#include "mm/atomic.hpp"
+#include "mm/error.hpp"
+#include "mm/optional.hpp"
+#include "mm/expected.hpp"
 
 namespace mm {
 	template <mm::size_t Length,mm::size_t Alignment> 
@@ -68,6 +73,70 @@ namespace mm {
 		}
 	};
 
+	template <class T>
+	constexpr T* to_address(T* p) {
+		return p;
+	}
+
+	namespace detail {
+		template <class Ptr>
+		auto to_address_impl(const Ptr& p,int) -> decltype(mm::pointer_traits<Ptr>::to_address(p)) {
+			return mm::pointer_traits<Ptr>::to_address(p);
+		}
+
+		template <class Ptr>
+		auto to_address_impl(const Ptr& p,...) -> decltype(mm::to_address(p.operator->())) {
+			return mm::to_address(p.operator->());
+		}
+	}
+
+	// raw address held by a fancy pointer or contiguous iterator, through
+	// pointer_traits<Ptr>::to_address when it is provided, else operator->
+	template <class Ptr>
+	auto to_address(const Ptr& p) -> decltype(detail::to_address_impl(p,0)) {
+		return detail::to_address_impl(p,0);
+	}
+
+	namespace detail {
+		template <class InputIter,class OutputIter>
+		OutputIter copy_impl(InputIter first,InputIter last,OutputIter out,mm::false_t) {
+			for (; first != last; ++first, ++out) {
+				*out = *first;
+			}
+
+			return out;
+		}
+
+		template <class InputIter,class OutputIter>
+		OutputIter copy_impl(InputIter first,InputIter last,OutputIter out,mm::true_t) {
+			mm::ptrdiff_t n = last - first;
+
+			if (n > 0) {
+				memmove(mm::to_address(out),mm::to_address(first),static_cast<mm::size_t>(n) * sizeof(*mm::to_address(first)));
+			}
+
+			return out + n;
+		}
+
+		template <class InputIter,class OutputIter>
+		using copy_is_memmove = mm::integral_constant<bool,
+			mm::is_contiguous_iterator<InputIter>::value
+		     && mm::is_contiguous_iterator<OutputIter>::value
+		     && mm::is_same<
+				mm::remove_cv_t<typename mm::iterator_traits<InputIter>::value_type>,
+				mm::remove_cv_t<typename mm::iterator_traits<OutputIter>::value_type>
+			>::value
+		     && mm::is_trivially_copyable<typename mm::iterator_traits<InputIter>::value_type>::value
+		>;
+	}
+
+	// contiguous ranges of trivially copyable elements are copied as bytes,
+	// whatever container the iterators come from
+	template <class InputIter,class OutputIter>
+	OutputIter copy(InputIter first,InputIter last,OutputIter out) {
+		return detail::copy_impl(first,last,out,detail::copy_is_memmove<InputIter,OutputIter>());
+	}
+
 	namespace detail {
 		template <class Alloc> typename Alloc::pointer alloc_traits_pointer(int);
 		template <class Alloc> typename Alloc::value_type* alloc_traits_pointer(...);
@@ -93,6 +162,9 @@ namespace mm {
 		template <class Alloc> typename Alloc::propagate_on_container_move_assignment alloc_traits_pocma(int);
 		template <class Alloc> mm::false_t alloc_traits_pocma(...);
 
+		template <class Alloc> typename Alloc::propagate_on_container_swap alloc_traits_pocs(int);
+		template <class Alloc> mm::false_t alloc_traits_pocs(...);
+
 		template <class Alloc> typename Alloc::is_always_equal alloc_traits_is_always_equal(int);
 		template <class Alloc> typename mm::is_empty<Alloc>::type alloc_traits_is_always_equal(...);
 
@@ -148,6 +220,17 @@ namespace mm {
 		auto alloc_traits_soccc(const Alloc& a) -> Alloc {
 			return a;
 		}
+
+		// allocators that expose counters() are tracked per instance
+		template <class Alloc>
+		auto alloc_traits_counters(const Alloc& a,int) -> decltype(a.counters()) {
+			return a.counters();
+		}
+
+		template <class Alloc>
+		mm::alloc_counters* alloc_traits_counters(const Alloc&,...) {
+			return nullptr;
+		}
 	}
 
 	template <class Alloc>
@@ -162,20 +245,34 @@ namespace mm {
 		using size_type = decltype(detail::alloc_traits_size_type<Alloc,pointer,difference_type>(0));
 		using propagate_on_container_copy_assignment = decltype(detail::alloc_traits_pocca<Alloc>(0));
 		using propagate_on_container_move_assignment = decltype(detail::alloc_traits_pocma<Alloc>(0));
+		using propagate_on_container_swap = decltype(detail::alloc_traits_pocs<Alloc>(0));
 		using is_always_equal = decltype(detail::alloc_traits_is_always_equal<Alloc>(0));
 		
 		template <class T> using rebind_alloc = decltype(detail::alloc_traits_rebind_alloc<Alloc,T>(0));
 		template <class T> using rebind_traits = mm::allocator_traits< rebind_alloc<T> >;
 
 		static pointer allocate(Alloc& a,size_type n) {
-			return a.allocate(n);
+			pointer p = a.allocate(n);
+
+			if (p) {
+				detail::track_allocate(detail::alloc_traits_counters(a,0),sizeof(value_type) * n);
+			}
+
+			return p;
 		}
 
 		static pointer allocate(Alloc& a,size_type n,const_void_pointer hint) {
-			return detail::alloc_traits_allocate<Alloc,pointer,const_void_pointer,size_type>(a,n,hint);
+			pointer p = detail::alloc_traits_allocate<Alloc,pointer,const_void_pointer,size_type>(a,n,hint);
+
+			if (p) {
+				detail::track_allocate(detail::alloc_traits_counters(a,0),sizeof(value_type) * n);
+			}
+
+			return p;
 		}
 
 		static void deallocate(Alloc& a,pointer p,size_type n) {
+			detail::track_deallocate(detail::alloc_traits_counters(a,0),sizeof(value_type) * n);
 			a.deallocate(p,n);
 		}
 
@@ -223,11 +320,11 @@ namespace mm {
 		default_allocator& operator=(const default_allocator<U>&) {}
 
 		T* allocate(mm::size_t n) {
-			return static_cast<T*>(malloc(sizeof(T) * n));
+			return static_cast<T*>(detail::tracked_malloc(sizeof(T) * n,mm::ALLOC_SOURCE_DEFAULT_ALLOCATOR));
 		}
 
-		void deallocate(T* p,mm::size_t n) { printf("free %p\n",p);
-			free(static_cast<void*>(p));
+		void deallocate(T* p,mm::size_t) {
+			detail::tracked_free(static_cast<void*>(p),mm::ALLOC_SOURCE_DEFAULT_ALLOCATOR);
 		}
 	};
 	
@@ -236,6 +333,165 @@ namespace mm {
 		return true;
 	}
 
+	namespace detail {
+		// malloc already gives 16, anything stricter over allocates and keeps
+		// the pointer malloc returned just below the aligned block
+		inline void* aligned_malloc(mm::size_t bytes,mm::size_t alignment) {
+			if (alignment <= 16) {
+				return detail::tracked_malloc(bytes,mm::ALLOC_SOURCE_ALIGNED_ALLOCATOR);
+			}
+
+			if (bytes > mm::numeric_limits<mm::size_t>::max - alignment) {
+				return nullptr;
+			}
+
+			void* raw = detail::tracked_malloc(bytes + alignment,mm::ALLOC_SOURCE_ALIGNED_ALLOCATOR);
+
+			if (!raw) {
+				return nullptr;
+			}
+
+			void* aligned = reinterpret_cast<void*>((reinterpret_cast<uintptr_t>(raw) + alignment) & ~(alignment - 1));
+			static_cast<void**>(aligned)[-1] = raw;
+			return aligned;
+		}
+
+		inline void aligned_free(void* ptr,mm::size_t alignment) {
+			if (ptr && alignment > 16) {
+				ptr = static_cast<void**>(ptr)[-1];
+			}
+
+			detail::tracked_free(ptr,mm::ALLOC_SOURCE_ALIGNED_ALLOCATOR);
+		}
+	}
+
+	// allocates blocks aligned to Align (and at least alignof(T)), for simd
+	// buffers and arrays of cache line sized elements
+	template <class T,mm::size_t Align = mm::hardware_destructive_interference_size>
+	class aligned_allocator {
+	public:
+		using value_type = T;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using propagate_on_container_move_assignment = mm::true_t;
+		using is_always_equal = mm::true_t;
+
+		static constexpr mm::size_t alignment = Align > alignof(T) ? Align : alignof(T);
+
+		STATIC_ASSERT(Align && !(Align & (Align - 1)),"aligned_allocator alignment must be a power of two");
+
+		template <class U>
+		struct rebind {
+			using other = mm::aligned_allocator<U,Align>;
+		};
+
+		aligned_allocator() = default;
+		aligned_allocator(const aligned_allocator&) = default;
+		aligned_allocator& operator=(const aligned_allocator&) = default;
+
+		template <class U>
+		aligned_allocator(const aligned_allocator<U,Align>&) {}
+
+		T* allocate(mm::size_t n) {
+			if (n > mm::numeric_limits<mm::size_t>::max / sizeof(T)) {
+				return nullptr;
+			}
+
+			return static_cast<T*>(detail::aligned_malloc(sizeof(T) * n,alignment));
+		}
+
+		void deallocate(T* p,mm::size_t) {
+			detail::aligned_free(static_cast<void*>(p),alignment);
+		}
+	};
+
+	template <class T,mm::size_t Align>
+	constexpr mm::size_t mm::aligned_allocator<T,Align>::alignment;
+
+	template <class T1,class T2,mm::size_t Align>
+	bool operator==(const mm::aligned_allocator<T1,Align>&,const mm::aligned_allocator<T2,Align>&) {
+		return true;
+	}
+
+	template <class T1,class T2,mm::size_t Align>
+	bool operator!=(const mm::aligned_allocator<T1,Align>&,const mm::aligned_allocator<T2,Align>&) {
+		return false;
+	}
+
+	// gives T a cache line, or several, to itself so per thread counters and
+	// queue indices written by different threads never share one
+	template <class T>
+	struct alignas(mm::hardware_destructive_interference_size) cache_padded {
+		T value;
+
+		cache_padded() : value() {}
+
+		template <class U,mm::enable_if_t<!mm::is_same<mm::remove_cvref_t<U>,cache_padded>::value> = nullptr>
+		explicit cache_padded(U&& u) : value(mm::forward<U>(u)) {}
+
+		template <class... Args>
+		explicit cache_padded(mm::in_place_t,Args&&... args) : value(mm::forward<Args>(args)...) {}
+
+		T& get() { return value; }
+		const T& get() const { return value; }
+		T& operator*() { return value; }
+		const T& operator*() const { return value; }
+		T* operator->() { return mm::address_of(value); }
+		const T* operator->() const { return mm::address_of(value); }
+	};
+
+	// forwards to Alloc and reports every allocation made through
+	// allocator_traits to the counters it was given, which rebound copies
+	// share. only counts when built with TRACK_ALLOCATIONS
+	template <class T,class Alloc = mm::default_allocator<T>>
+	class counted_allocator {
+	public:
+		using value_type = T;
+		using size_type = typename mm::allocator_traits<Alloc>::size_type;
+		using difference_type = typename mm::allocator_traits<Alloc>::difference_type;
+		using propagate_on_container_move_assignment = mm::true_t;
+		using is_always_equal = mm::false_t;
+
+		template <class U>
+		struct rebind {
+			using other = mm::counted_allocator<U,typename mm::allocator_traits<Alloc>::template rebind_alloc<U>>;
+		};
+
+	private:
+		template <class U,class A> friend class counted_allocator;
+
+		Alloc m_alloc;
+		mm::alloc_counters* m_counters;
+
+	public:
+		explicit counted_allocator(mm::alloc_counters& counters,const Alloc& alloc = Alloc()) : m_alloc(alloc), m_counters(mm::address_of(counters)) {}
+
+		template <class U,class A>
+		counted_allocator(const counted_allocator<U,A>& other) : m_alloc(other.m_alloc), m_counters(other.m_counters) {}
+
+		T* allocate(mm::size_t n) {
+			return m_alloc.allocate(n);
+		}
+
+		void deallocate(T* p,mm::size_t n) {
+			m_alloc.deallocate(p,n);
+		}
+
+		mm::alloc_counters* counters() const {
+			return m_counters;
+		}
+
+		template <class U,class A>
+		bool operator==(const counted_allocator<U,A>& other) const {
+			return m_counters == other.m_counters;
+		}
+
+		template <class U,class A>
+		bool operator!=(const counted_allocator<U,A>& other) const {
+			return m_counters != other.m_counters;
+		}
+	};
+
 	// tag to mark container constructors that accept allocators
 	struct allocator_arg_t {};
 	constexpr allocator_arg_t allocator_arg;
@@ -291,45 +547,44 @@ namespace mm {
 		using deleter_type = Deleter;
 
 	private:
-		pointer m_ptr;
-		deleter_type m_del;
+		mm::compressed_pair<pointer,deleter_type> m_pair;
 
 	public:
 		unique_ptr(const unique_ptr&) = delete;
 		unique_ptr& operator=(const unique_ptr&) = delete;
 
-		constexpr unique_ptr() : m_ptr(), m_del() {}
-		constexpr unique_ptr(mm::nullptr_t) : m_ptr(), m_del() {}
-		explicit unique_ptr(pointer ptr) : m_ptr(ptr), m_del() {}
+		constexpr unique_ptr() : m_pair() {}
+		constexpr unique_ptr(mm::nullptr_t) : m_pair() {}
+		explicit unique_ptr(pointer ptr) : m_pair(ptr) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 			mm::is_copy_constructible<D>::value
 		    && !mm::is_reference<D>::value
 		> = nullptr>
-		unique_ptr(pointer ptr,const deleter_type& del) : m_ptr(ptr), m_del(mm::forward<decltype(del)>(del)) {}
+		unique_ptr(pointer ptr,const deleter_type& del) : m_pair(ptr,mm::forward<decltype(del)>(del)) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 			mm::is_move_constructible<D>::value
 		    && !mm::is_reference<D>::value
 		> = nullptr>
-		unique_ptr(pointer ptr,deleter_type&& del) : m_ptr(ptr), m_del(mm::forward<decltype(del)>(del)) {}
+		unique_ptr(pointer ptr,deleter_type&& del) : m_pair(ptr,mm::forward<decltype(del)>(del)) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 			mm::is_lvalue_reference<D>::value
 		    && !mm::is_const<D>::value
 		> = nullptr>
-		unique_ptr(pointer ptr,deleter_type& del) : m_ptr(ptr), m_del(mm::forward<decltype(del)>(del)) {}
+		unique_ptr(pointer ptr,deleter_type& del) : m_pair(ptr,mm::forward<decltype(del)>(del)) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 		       mm::is_lvalue_reference<D>::value
 		    && mm::is_const<D>::value
 		> = nullptr>
-		unique_ptr(pointer ptr,const deleter_type& del) : m_ptr(ptr), m_del(mm::forward<decltype(del)>(del)) {}
+		unique_ptr(pointer ptr,const deleter_type& del) : m_pair(ptr,mm::forward<decltype(del)>(del)) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 			mm::is_move_constructible<D>::value
 		> = nullptr>
-		unique_ptr(unique_ptr&& other) : m_ptr(other.release()), m_del(mm::move(other.get_deleter())) {}
+		unique_ptr(unique_ptr&& other) : m_pair(other.release(),mm::move(other.get_deleter())) {}
 
 		template <class U,class E,mm::enable_if_t<
 			mm::is_convertible<typename unique_ptr<U,E>::pointer,pointer>::value
@@ -337,11 +592,11 @@ namespace mm {
 		    && ((mm::is_reference<deleter_type>::value && mm::is_same<deleter_type,E>::value)
 		    || (!mm::is_reference<deleter_type>::value && mm::is_convertible<E,deleter_type>::value))
 		> = nullptr>
-		unique_ptr(unique_ptr<U,E>&& other) : m_ptr(other.release()), m_del(mm::forward<E>(other.get_deleter())) {}
+		unique_ptr(unique_ptr<U,E>&& other) : m_pair(other.release(),mm::forward<E>(other.get_deleter())) {}
 
 		~unique_ptr() {
-			if (m_ptr) {
-				m_del(m_ptr);
+			if (m_pair.first()) {
+				m_pair.second()(m_pair.first());
 			}
 		}
 
@@ -349,7 +604,7 @@ namespace mm {
 			mm::is_move_assignable<D>::value
 		>>
 		unique_ptr& operator=(unique_ptr&& other) {
-			unique_ptr(other).swap(*this);
+			unique_ptr(mm::move(other)).swap(*this);
 			return *this;
 		}
 
@@ -359,7 +614,7 @@ namespace mm {
 		      && mm::is_assignable<deleter_type,E&&>::value
 		>>
 		unique_ptr& operator=(unique_ptr<U,E>&& other) {
-			unique_ptr(other).swap(*this);
+			unique_ptr(mm::move(other)).swap(*this);
 			return *this;
 		}
 
@@ -369,47 +624,46 @@ namespace mm {
 		}
 
 		pointer release() {
-			pointer ptr = m_ptr;
-			m_ptr = pointer();
+			pointer ptr = m_pair.first();
+			m_pair.first() = pointer();
 			return ptr;
 		}
 
 		void reset(pointer ptr = pointer()) {
-			pointer old = m_ptr;
-			m_ptr = ptr;
+			pointer old = m_pair.first();
+			m_pair.first() = ptr;
 			
 			if (old) {
-				m_del(old);
+				m_pair.second()(old);
 			}
 		}
 	
 		void swap(unique_ptr& other) {
-			mm::swap(this->m_ptr,other.m_ptr);
-			mm::swap(this->m_del,other.m_del);
+			m_pair.swap(other.m_pair);
 		}
 
 		pointer get() const {
-			return m_ptr;
+			return m_pair.first();
 		}
 
 		deleter_type& get_deleter() {
-			return m_del;
+			return m_pair.second();
 		}
 
 		const deleter_type& get_deleter() const {
-			return m_del;
+			return m_pair.second();
 		}
 
 		explicit operator bool() const {
-			return m_ptr != nullptr;
+			return m_pair.first() != nullptr;
 		}
 
 		mm::add_lvalue_reference_t<T> operator*() const {
-			return *m_ptr;
+			return *m_pair.first();
 		}
 
 		pointer operator->() const {
-			return m_ptr;
+			return m_pair.first();
 		}
 	};
 
@@ -421,52 +675,51 @@ namespace mm {
 		using deleter_type = Deleter;
 	
 	private:
-		pointer m_ptr;
-		deleter_type m_del;
+		mm::compressed_pair<pointer,deleter_type> m_pair;
 
 	public:
 		unique_ptr(const unique_ptr&) = delete;
 		unique_ptr& operator=(const unique_ptr&) = delete;
 
-		constexpr unique_ptr() : m_ptr(), m_del() {}
-		constexpr unique_ptr(mm::nullptr_t) : m_ptr(), m_del() {}
-		explicit unique_ptr(pointer ptr) : m_ptr(ptr), m_del() {}
+		constexpr unique_ptr() : m_pair() {}
+		constexpr unique_ptr(mm::nullptr_t) : m_pair() {}
+		explicit unique_ptr(pointer ptr) : m_pair(ptr) {}
 
 		template <class U>
-		explicit unique_ptr(U ptr) : m_ptr(ptr), m_del() {}
+		explicit unique_ptr(U ptr) : m_pair(ptr) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 			mm::is_copy_constructible<D>::value
 		    && !mm::is_reference<D>::value
 		> = nullptr>
-		unique_ptr(pointer ptr,const deleter_type& del) : m_ptr(ptr), m_del(mm::forward<decltype(del)>(del)) {}
+		unique_ptr(pointer ptr,const deleter_type& del) : m_pair(ptr,mm::forward<decltype(del)>(del)) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 			mm::is_move_constructible<D>::value
 		    && !mm::is_reference<D>::value
 		> = nullptr>
-		unique_ptr(pointer ptr,deleter_type&& del) : m_ptr(ptr), m_del(mm::forward<decltype(del)>(del)) {}
+		unique_ptr(pointer ptr,deleter_type&& del) : m_pair(ptr,mm::forward<decltype(del)>(del)) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 			mm::is_lvalue_reference<D>::value
 		    && !mm::is_const<D>::value
 		> = nullptr>
-		unique_ptr(pointer ptr,deleter_type& del) : m_ptr(ptr), m_del(mm::forward<decltype(del)>(del)) {}
+		unique_ptr(pointer ptr,deleter_type& del) : m_pair(ptr,mm::forward<decltype(del)>(del)) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 		       mm::is_lvalue_reference<D>::value
 		    && mm::is_const<D>::value
 		> = nullptr>
-		unique_ptr(pointer ptr,const deleter_type& del) : m_ptr(ptr), m_del(mm::forward<decltype(del)>(del)) {}
+		unique_ptr(pointer ptr,const deleter_type& del) : m_pair(ptr,mm::forward<decltype(del)>(del)) {}
 
 		template <class D = deleter_type,mm::enable_if_t<
 			mm::is_move_constructible<D>::value
 		> = nullptr>
-		unique_ptr(unique_ptr&& other) : m_ptr(other.release()), m_del(mm::move(other.get_deleter())) {}
+		unique_ptr(unique_ptr&& other) : m_pair(other.release(),mm::move(other.get_deleter())) {}
 
 		~unique_ptr() {
-			if (m_ptr) {
-				m_del(m_ptr);
+			if (m_pair.first()) {
+				m_pair.second()(m_pair.first());
 			}
 		}
 
@@ -474,7 +727,7 @@ namespace mm {
 			mm::is_move_assignable<D>::value
 		>>
 		unique_ptr& operator=(unique_ptr&& other) {
-			unique_ptr(other).swap(*this);
+			unique_ptr(mm::move(other)).swap(*this);
 			return *this;
 		}
 
@@ -484,7 +737,7 @@ namespace mm {
 		      && mm::is_assignable<deleter_type,E&&>::value
 		>>
 		unique_ptr& operator=(unique_ptr<U,E>&& other) {
-			unique_ptr(other).swap(*this);
+			unique_ptr(mm::move(other)).swap(*this);
 			return *this;
 		}
 
@@ -494,17 +747,17 @@ namespace mm {
 		}
 
 		pointer release() {
-			pointer ptr = m_ptr;
-			m_ptr = pointer();
+			pointer ptr = m_pair.first();
+			m_pair.first() = pointer();
 			return ptr;
 		}
 
 		void reset(pointer ptr = pointer()) {
-			pointer old = m_ptr;
-			m_ptr = ptr;
+			pointer old = m_pair.first();
+			m_pair.first() = ptr;
 			
 			if (old) {
-				m_del(old);
+				m_pair.second()(old);
 			}
 		}
 
@@ -516,28 +769,27 @@ namespace mm {
 		}
 	
 		void swap(unique_ptr& other) {
-			mm::swap(this->m_ptr,other.m_ptr);
-			mm::swap(this->m_del,other.m_del);
+			m_pair.swap(other.m_pair);
 		}
 
 		pointer get() const {
-			return m_ptr;
+			return m_pair.first();
 		}
 
 		deleter_type& get_deleter() {
-			return m_del;
+			return m_pair.second();
 		}
 
 		const deleter_type& get_deleter() const {
-			return m_del;
+			return m_pair.second();
 		}
 
 		explicit operator bool() const {
-			return m_ptr != nullptr;
+			return m_pair.first() != nullptr;
 		}
 
 		element_type& operator[](mm::size_t i) {
-			return m_ptr[i];
+			return m_pair.first()[i];
 		}
 	};
 
@@ -631,99 +883,225 @@ namespace mm {
 		return nullptr >= ptr.get();
 	}
 
-	template <class T,class... Args>
+	namespace detail {
+		// an optional unique_ptr is disengaged when null
+		template <class T,class D>
+		struct optional_niche< mm::unique_ptr<T,D> > : mm::true_t {
+			static bool engaged(const mm::unique_ptr<T,D>& value) { return bool(value); }
+			static void reset(mm::unique_ptr<T,D>& value) { value.reset(); }
+		};
+	}
+
+	template <class T,class... Args,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
 	mm::unique_ptr<T> make_unique(Args&&... args) {
 		return mm::unique_ptr<T>(new T(mm::forward<Args>(args)...));
 	}
 
+	// value initialised, so trivial element types are zeroed
+	template <class T,mm::enable_if_t<
+		mm::is_unbounded_array<T>::value
+	> = nullptr>
+	mm::unique_ptr<T> make_unique(mm::size_t n) {
+		return mm::unique_ptr<T>(new mm::remove_extent_t<T>[n]());
+	}
+
+	template <class T,class... Args,mm::enable_if_t<
+		mm::is_bounded_array<T>::value
+	> = nullptr>
+	void make_unique(Args&&...) = delete;
+
+	// the _for_overwrite variants default initialise, trivial types are left
+	// indeterminate instead of being zeroed only to be overwritten by the caller
+	template <class T,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::unique_ptr<T> make_unique_for_overwrite() {
+		return mm::unique_ptr<T>(new T);
+	}
+
+	template <class T,mm::enable_if_t<
+		mm::is_unbounded_array<T>::value
+	> = nullptr>
+	mm::unique_ptr<T> make_unique_for_overwrite(mm::size_t n) {
+		return mm::unique_ptr<T>(new mm::remove_extent_t<T>[n]);
+	}
+
+	template <class T,class... Args,mm::enable_if_t<
+		mm::is_bounded_array<T>::value
+	> = nullptr>
+	void make_unique_for_overwrite(Args&&...) = delete;
+
 	template <class T,class D>
 	void swap(mm::unique_ptr<T,D>& lhs,mm::unique_ptr<T,D>& rhs) {
 		lhs.swap(rhs);
 	}
 
+	namespace detail {
+		// a unique_ptr's pointer and deleter with the types erased, so reclamation
+		// schemes can queue deletions of any type and run them later. stateless
+		// deleters are rebuilt on reclaim, anything else is moved to the heap
+		struct deferred_delete {
+			void* object;
+			void* context;
+			void (*reclaim)(void*,void*);
+
+			void operator()() const {
+				reclaim(object,context);
+			}
+		};
+
+		template <class Ptr,class Deleter>
+		void deferred_delete_stateless(void* object,void*) {
+			Deleter()(static_cast<Ptr>(object));
+		}
+
+		template <class Ptr,class Deleter>
+		void deferred_delete_stateful(void* object,void* context) {
+			Deleter* del = static_cast<Deleter*>(context);
+			(*del)(static_cast<Ptr>(object));
+			delete del;
+		}
+
+		template <class Ptr,class Deleter>
+		detail::deferred_delete make_deferred_delete(Ptr ptr,Deleter&&,mm::true_t) {
+			return { const_cast<void*>(static_cast<const volatile void*>(ptr)), nullptr, &detail::deferred_delete_stateless<Ptr,mm::remove_reference_t<Deleter>> };
+		}
+
+		template <class Ptr,class Deleter>
+		detail::deferred_delete make_deferred_delete(Ptr ptr,Deleter&& del,mm::false_t) {
+			using deleter_type = mm::remove_reference_t<Deleter>;
+			return { const_cast<void*>(static_cast<const volatile void*>(ptr)), new deleter_type(mm::move(del)), &detail::deferred_delete_stateful<Ptr,deleter_type> };
+		}
+
+		// ptr must not be null
+		template <class T,class Deleter>
+		detail::deferred_delete make_deferred_delete(mm::unique_ptr<T,Deleter>&& ptr) {
+			using pointer = typename mm::unique_ptr<T,Deleter>::pointer;
+			using deleter_type = mm::remove_reference_t<Deleter>;
+
+			STATIC_ASSERT(mm::is_pointer<pointer>::value,"only unique_ptrs holding raw pointers can be deferred");
+
+			pointer raw = ptr.release();
+
+			return detail::make_deferred_delete(raw,mm::move(ptr.get_deleter()),mm::integral_constant<bool,
+				mm::is_empty<deleter_type>::value
+			     && mm::is_default_constructible<deleter_type>::value
+			>());
+		}
+	}
+
 	// mm::hash<mm::unique_ptr>
 
 	template <class T>
 	class weak_ptr;
 
 	template <class T>
-	class shared_ptr {
-	public:
-		using element_type = T;
-		using weak_type = mm::weak_ptr<T>;
+	class local_shared_ptr;
 
-	private:
-		class control_block {
+	namespace detail {
+		// stand-in for mm::atomic with the part of its interface the control
+		// blocks use, for reference counts that never leave one thread
+		template <class T>
+		class plain_count {
+		private:
+			T m_value;
+
+		public:
+			constexpr plain_count(T value) : m_value(value) {}
+
+			plain_count(const plain_count&) = delete;
+			plain_count& operator=(const plain_count&) = delete;
+
+			T load(mm::memory_order = mm::memory_order_seq_cst) const {
+				return m_value;
+			}
+
+			T fetch_add(T n,mm::memory_order = mm::memory_order_seq_cst) {
+				T old = m_value;
+				m_value += n;
+				return old;
+			}
+
+			T fetch_sub(T n,mm::memory_order = mm::memory_order_seq_cst) {
+				T old = m_value;
+				m_value -= n;
+				return old;
+			}
+		};
+
+		// shared between every shared_ptr<U> that aliases the same owned object,
+		// which is why it lives outside of shared_ptr and is not templated on T.
+		// the strong references collectively hold a single weak reference, so
+		// copying a shared_ptr only touches m_ref_count
+		template <class Count>
+		class basic_control_block {
 		protected:
-			mm::i32 m_ref_count;
-			mm::i32 m_weak_count;
+			Count m_ref_count;
+			Count m_weak_count;
 		
 		public:
-			control_block() : m_ref_count(1), m_weak_count(1) {}
+			basic_control_block() : m_ref_count(1), m_weak_count(1) {}
 
-			control_block(const control_block&) = delete;
-			control_block(control_block&&) = delete;
+			basic_control_block(const basic_control_block&) = delete;
+			basic_control_block(basic_control_block&&) = delete;
 
 			mm::i32 ref_count() const {
-				return m_ref_count;
+				return m_ref_count.load(mm::memory_order_relaxed);
 			}
 
+			// new references are always taken through an existing one, so no ordering is needed
 			void inc_reference() {
-				++m_ref_count;
-				++m_weak_count;
+				m_ref_count.fetch_add(1,mm::memory_order_relaxed);
 			}
 
 			void inc_weak_reference() {
-				++m_weak_count;
+				m_weak_count.fetch_add(1,mm::memory_order_relaxed);
 			}
 
 			virtual void free_element() = 0;
 			virtual void free_control_block() = 0;
 
 			void release_reference() {
-				if (--m_ref_count > 0) {
-					--m_weak_count;
-				} else {
+				if (m_ref_count.fetch_sub(1,mm::memory_order_acq_rel) == 1) {
 					free_element();
-
-					if (m_weak_count == 0) {
-						free_control_block();
-					}
+					release_weak_reference();
 				}
 			}
 
 			void release_weak_reference() {
-				if (--m_weak_count == 0) {
+				if (m_weak_count.fetch_sub(1,mm::memory_order_acq_rel) == 1) {
 					free_control_block();
 				}
 			}
 		};
 
-		template <class Alloc,class Deleter>
-		class control_block_ptr : public control_block {
+		using control_block = detail::basic_control_block<mm::atomic<mm::i32>>;
+		using local_control_block = detail::basic_control_block<detail::plain_count<mm::i32>>;
+
+		template <class T,class Alloc,class Deleter,class Base = detail::control_block>
+		class control_block_ptr : public Base {
 		private:
 			using element_type = T*;
 			using allocator_type = Alloc;
 			using deleter_type = Deleter;
 
-			element_type m_element;
-			allocator_type m_alloc;
-			deleter_type m_del;
+			// (element, (allocator, deleter)), stateless allocators and deleters take no space
+			mm::compressed_pair<element_type,mm::compressed_pair<allocator_type,deleter_type>> m_storage;
 	
 		public:
 			control_block_ptr(element_type element,allocator_type alloc,deleter_type del) : 
-				control_block(),
-				m_element(element),
-				m_alloc(mm::move(alloc)),
-				m_del(del)
+				Base(),
+				m_storage(element,mm::compressed_pair<allocator_type,deleter_type>(mm::move(alloc),mm::move(del)))
 			{}
 
 			virtual void free_element() override {
-				m_del(m_element);
+				m_storage.second().second()(m_storage.first());
 			}
 
 			virtual void free_control_block() override {
-				allocator_type alloc(m_alloc);
+				allocator_type alloc(m_storage.second().first());
 				mm::destroy_at(this);
 
 				mm::allocator_traits<allocator_type>::deallocate(
@@ -734,51 +1112,63 @@ namespace mm {
 			}
 		};
 
-		template <class Alloc>
-		class control_block_inline : public control_block {
+		// selects default rather than value initialisation of the inline element
+		struct default_init_t {};
+
+		template <class T,class Alloc,class Base = detail::control_block>
+		class control_block_inline : public Base {
 		private:
 			using element_type = T;
 			using allocator_type = Alloc;
 			using storage_type = mm::aligned_storage_t<sizeof(element_type),mm::alignment_of<T>::value>;
 			
-			storage_type m_memory;
-			allocator_type m_alloc;
-
-			element_type* get_ptr() {
-				return static_cast<element_type*>(
-					static_cast<void*>(
-						mm::address_of(m_memory)
-					)
-				);
-			}
+			mm::compressed_pair<allocator_type,storage_type> m_storage;
 
 		public:
 			template <class... Args>
 			control_block_inline(allocator_type alloc,Args&&... args) :
-				control_block(),
-				m_alloc(mm::move(alloc))
+				Base(),
+				m_storage(mm::move(alloc))
 			{
 				mm::construct_at(get_ptr(),mm::forward<Args>(args)...);
 			}
 
+			control_block_inline(allocator_type alloc,detail::default_init_t) :
+				Base(),
+				m_storage(mm::move(alloc))
+			{
+				new(static_cast<void*>(get_ptr())) element_type;
+			}
+
+			element_type* get_ptr() {
+				return static_cast<element_type*>(
+					static_cast<void*>(
+						mm::address_of(m_storage.second())
+					)
+				);
+			}
+
 			virtual void free_element() override {
 				mm::destroy_at(get_ptr());
 			}
 
 			virtual void free_control_block() override {
-				allocator_type alloc(m_alloc);
+				allocator_type alloc(m_storage.first());
 				mm::destroy_at(this);
-				mm::allocator_traits<allocator_type>::deallocate(alloc,this,sizeof(*this));
+				mm::allocator_traits<allocator_type>::deallocate(
+					alloc,
+					reinterpret_cast<mm::u8*>(this),
+					sizeof(*this)
+				);
 			}
 		};
-		
-		control_block *m_control;
-		element_type *m_element;
 
-		template <class U,class Alloc,class Deleter>
-		void allocate_control_block_with_ptr(U* ptr,Alloc alloc,Deleter del) {
+		// the pointer is owned either way, if the control block cannot be
+		// allocated it is handed to the deleter before the error is returned
+		template <class Base,class U,class Alloc,class Deleter>
+		mm::expected<Base*,mm::error> allocate_control_block_with_ptr(U* ptr,Alloc alloc,Deleter del) {
 			using allocator_type = typename mm::allocator_traits<Alloc>::template rebind_alloc<mm::u8>;
-			using control_block_type = control_block_ptr<allocator_type,Deleter>;
+			using control_block_type = detail::control_block_ptr<U,allocator_type,Deleter,Base>;
 
 			allocator_type internal_alloc(alloc);
 			
@@ -787,20 +1177,83 @@ namespace mm {
 				sizeof(control_block_type)
 			);
 
-			if (memory) {
-				m_control = mm::construct_at(
-					static_cast<control_block_type*>(memory),
-					ptr,
-					internal_alloc,
-					del
-				);
+			if (__builtin_expect(!memory,0)) {
+				del(ptr);
+				return mm::make_unexpected(mm::ERROR_FAILED_ALLOC);
+			}
+
+			return static_cast<Base*>(mm::construct_at(
+				static_cast<control_block_type*>(memory),
+				ptr,
+				internal_alloc,
+				del
+			));
+		}
+
+		template <class T,class Base,class Alloc>
+		using control_block_inline_for = detail::control_block_inline<T,typename mm::allocator_traits<Alloc>::template rebind_alloc<mm::u8>,Base>;
+
+		// the element lives inside the control block, one allocation instead of two
+		template <class T,class Base,class Alloc,class... Args>
+		mm::expected<detail::control_block_inline_for<T,Base,Alloc>*,mm::error> allocate_control_block_inline(const Alloc& alloc,Args&&... args) {
+			using allocator_type = typename mm::allocator_traits<Alloc>::template rebind_alloc<mm::u8>;
+			using control_block_type = detail::control_block_inline<T,allocator_type,Base>;
+
+			allocator_type internal_alloc(alloc);
+
+			void* memory = mm::allocator_traits<allocator_type>::allocate(
+				internal_alloc,
+				sizeof(control_block_type)
+			);
+
+			if (__builtin_expect(!memory,0)) {
+				return mm::make_unexpected(mm::ERROR_FAILED_ALLOC);
+			}
+
+			return mm::construct_at(
+				static_cast<control_block_type*>(memory),
+				internal_alloc,
+				mm::forward<Args>(args)...
+			);
+		}
+
+		// lets the make_ functions adopt a freshly built control block
+		struct shared_ptr_access {
+			template <class Ptr,class Control,class Element>
+			static Ptr adopt(Control* control,Element* element) {
+				return Ptr(control,element);
+			}
+		};
+	}
+
+	template <class T>
+	class shared_ptr {
+	public:
+		using element_type = T;
+		using weak_type = mm::weak_ptr<T>;
+
+	private:
+		template <class U> friend class shared_ptr;
+		friend struct detail::shared_ptr_access;
+
+		detail::control_block *m_control;
+		element_type *m_element;
 
+		shared_ptr(detail::control_block* control,element_type* element) : m_control(control), m_element(element) {}
+
+		// stays empty if the control block cannot be allocated, ptr is deleted
+		template <class U,class Alloc,class Deleter>
+		void allocate_control_block_with_ptr(U* ptr,Alloc alloc,Deleter del) {
+			mm::expected<detail::control_block*,mm::error> control = detail::allocate_control_block_with_ptr<detail::control_block>(ptr,alloc,del);
+
+			if (control) {
+				m_control = *control;
 				m_element = ptr;
 			}
 		}
 
 	public:
-		constexpr shared_ptr() = default;
+		constexpr shared_ptr() : m_control(), m_element() {}
 		constexpr shared_ptr(mm::nullptr_t) : m_control(), m_element() {}
 
 		template <class U,mm::enable_if_t<
@@ -810,7 +1263,7 @@ namespace mm {
 			allocate_control_block_with_ptr(
 				ptr,
 				mm::default_allocator<mm::u8>(),
-				mm::default_delete<T>()
+				mm::default_delete<U>()
 			);
 		}
 
@@ -819,7 +1272,7 @@ namespace mm {
 		     && mm::is_copy_constructible<Deleter>::value
 		> = nullptr>
 		shared_ptr(U* ptr,Deleter del) : m_control(), m_element() {
-			alloc_control_block_with_ptr(
+			allocate_control_block_with_ptr(
 				ptr,
 				mm::default_allocator<mm::u8>(),
 				del
@@ -830,8 +1283,8 @@ namespace mm {
 			mm::is_copy_constructible<Deleter>::value
 		> = nullptr>
 		shared_ptr(mm::nullptr_t,Deleter del) : m_control(), m_element() {
-			alloc_control_block_with_ptr(
-				nullptr,
+			allocate_control_block_with_ptr(
+				static_cast<element_type*>(nullptr),
 				mm::default_allocator<mm::u8>(),
 				del
 			);
@@ -842,22 +1295,756 @@ namespace mm {
 		     && mm::is_copy_constructible<Deleter>::value
 		> = nullptr>
 		shared_ptr(U* ptr,Alloc alloc,Deleter del) : m_control(), m_element() {
-			alloc_control_block_with_ptr(
+			allocate_control_block_with_ptr(
 				ptr,
 				alloc,
 				del
 			);
 		}
 
-		~shared_ptr() {
-			m_control->release_reference();
+		shared_ptr(const shared_ptr& other) : m_control(other.m_control), m_element(other.m_element) {
+			if (m_control) {
+				m_control->inc_reference();
+			}
 		}
 
-		void swap(shared_ptr& other) {
-			mm::swap(m_control,other.m_control);
-			mm::swap(m_element,other.m_element);
+		shared_ptr(shared_ptr&& other) : m_control(other.m_control), m_element(other.m_element) {
+			other.m_control = nullptr;
+			other.m_element = nullptr;
 		}
-	};
+
+		template <class U,mm::enable_if_t<
+			mm::is_convertible<U*,element_type*>::value
+		> = nullptr>
+		shared_ptr(const shared_ptr<U>& other) : m_control(other.m_control), m_element(other.m_element) {
+			if (m_control) {
+				m_control->inc_reference();
+			}
+		}
+
+		template <class U,mm::enable_if_t<
+			mm::is_convertible<U*,element_type*>::value
+		> = nullptr>
+		shared_ptr(shared_ptr<U>&& other) : m_control(other.m_control), m_element(other.m_element) {
+			other.m_control = nullptr;
+			other.m_element = nullptr;
+		}
+
+		// aliasing constructors, share ownership with other but point at ptr
+		// (usually a member of, or a cast of, the object owned by other)
+		template <class U>
+		shared_ptr(const shared_ptr<U>& other,element_type* ptr) : m_control(other.m_control), m_element(ptr) {
+			if (m_control) {
+				m_control->inc_reference();
+			}
+		}
+
+		// steals the reference held by other instead of an increment/decrement pair
+		template <class U>
+		shared_ptr(shared_ptr<U>&& other,element_type* ptr) : m_control(other.m_control), m_element(ptr) {
+			other.m_control = nullptr;
+			other.m_element = nullptr;
+		}
+
+		// see local_shared_ptr::share(), stays empty when share() fails
+		template <class U,mm::enable_if_t<
+			mm::is_convertible<U*,element_type*>::value
+		> = nullptr>
+		explicit shared_ptr(mm::local_shared_ptr<U>&& other) : shared_ptr(mm::move(other).share().value_or(nullptr)) {}
+
+		~shared_ptr() {
+			if (m_control) {
+				m_control->release_reference();
+			}
+		}
+
+		shared_ptr& operator=(const shared_ptr& other) {
+			shared_ptr(other).swap(*this);
+			return *this;
+		}
+
+		shared_ptr& operator=(shared_ptr&& other) {
+			shared_ptr(mm::move(other)).swap(*this);
+			return *this;
+		}
+
+		template <class U>
+		shared_ptr& operator=(const shared_ptr<U>& other) {
+			shared_ptr(other).swap(*this);
+			return *this;
+		}
+
+		template <class U>
+		shared_ptr& operator=(shared_ptr<U>&& other) {
+			shared_ptr(mm::move(other)).swap(*this);
+			return *this;
+		}
+
+		void reset() {
+			shared_ptr().swap(*this);
+		}
+
+		template <class U>
+		void reset(U* ptr) {
+			shared_ptr(ptr).swap(*this);
+		}
+
+		void swap(shared_ptr& other) {
+			mm::swap(m_control,other.m_control);
+			mm::swap(m_element,other.m_element);
+		}
+
+		element_type* get() const {
+			return m_element;
+		}
+
+		mm::add_lvalue_reference_t<element_type> operator*() const {
+			return *m_element;
+		}
+
+		element_type* operator->() const {
+			return m_element;
+		}
+
+		mm::i32 use_count() const {
+			return m_control ? m_control->ref_count() : 0;
+		}
+
+		explicit operator bool() const {
+			return m_element != nullptr;
+		}
+
+		template <class U>
+		bool owner_before(const shared_ptr<U>& other) const {
+			return m_control < other.m_control;
+		}
+	};
+
+	template <class T1,class T2>
+	bool operator==(const mm::shared_ptr<T1>& lhs,const mm::shared_ptr<T2>& rhs) {
+		return lhs.get() == rhs.get();
+	}
+
+	template <class T1,class T2>
+	bool operator!=(const mm::shared_ptr<T1>& lhs,const mm::shared_ptr<T2>& rhs) {
+		return lhs.get() != rhs.get();
+	}
+
+	template <class T>
+	bool operator==(const mm::shared_ptr<T>& ptr,mm::nullptr_t) {
+		return !bool(ptr);
+	}
+
+	template <class T>
+	bool operator==(mm::nullptr_t,const mm::shared_ptr<T>& ptr) {
+		return !bool(ptr);
+	}
+
+	template <class T>
+	bool operator!=(const mm::shared_ptr<T>& ptr,mm::nullptr_t) {
+		return bool(ptr);
+	}
+
+	template <class T>
+	bool operator!=(mm::nullptr_t,const mm::shared_ptr<T>& ptr) {
+		return bool(ptr);
+	}
+
+	template <class T>
+	void swap(mm::shared_ptr<T>& lhs,mm::shared_ptr<T>& rhs) {
+		lhs.swap(rhs);
+	}
+
+	// the rvalue overloads move the reference out of ptr rather than taking a new one
+
+	template <class T,class U>
+	mm::shared_ptr<T> static_pointer_cast(const mm::shared_ptr<U>& ptr) {
+		return mm::shared_ptr<T>(ptr,static_cast<T*>(ptr.get()));
+	}
+
+	template <class T,class U>
+	mm::shared_ptr<T> static_pointer_cast(mm::shared_ptr<U>&& ptr) {
+		T* element = static_cast<T*>(ptr.get());
+		return mm::shared_ptr<T>(mm::move(ptr),element);
+	}
+
+	template <class T,class U>
+	mm::shared_ptr<T> const_pointer_cast(const mm::shared_ptr<U>& ptr) {
+		return mm::shared_ptr<T>(ptr,const_cast<T*>(ptr.get()));
+	}
+
+	template <class T,class U>
+	mm::shared_ptr<T> const_pointer_cast(mm::shared_ptr<U>&& ptr) {
+		T* element = const_cast<T*>(ptr.get());
+		return mm::shared_ptr<T>(mm::move(ptr),element);
+	}
+
+	template <class T,class U>
+	mm::shared_ptr<T> reinterpret_pointer_cast(const mm::shared_ptr<U>& ptr) {
+		return mm::shared_ptr<T>(ptr,reinterpret_cast<T*>(ptr.get()));
+	}
+
+	template <class T,class U>
+	mm::shared_ptr<T> reinterpret_pointer_cast(mm::shared_ptr<U>&& ptr) {
+		T* element = reinterpret_cast<T*>(ptr.get());
+		return mm::shared_ptr<T>(mm::move(ptr),element);
+	}
+
+	// dynamic_cast is unavailable when built with -fno-rtti
+	#ifdef __GXX_RTTI
+	template <class T,class U>
+	mm::shared_ptr<T> dynamic_pointer_cast(const mm::shared_ptr<U>& ptr) {
+		T* element = dynamic_cast<T*>(ptr.get());
+		return element ? mm::shared_ptr<T>(ptr,element) : mm::shared_ptr<T>();
+	}
+
+	// ptr keeps its reference if the cast fails
+	template <class T,class U>
+	mm::shared_ptr<T> dynamic_pointer_cast(mm::shared_ptr<U>&& ptr) {
+		T* element = dynamic_cast<T*>(ptr.get());
+		return element ? mm::shared_ptr<T>(mm::move(ptr),element) : mm::shared_ptr<T>();
+	}
+	#endif
+
+	namespace detail {
+		// immutable snapshot published by atomic_shared_ptr. m_count only holds
+		// the references that loaders have handed back after the node was
+		// unpublished, so it runs negative until the writer transfers the
+		// outstanding local count from the cell
+		template <class T>
+		struct atomic_shared_node {
+			mm::shared_ptr<T> m_value;
+			mm::atomic<mm::i64> m_count;
+
+			atomic_shared_node(mm::shared_ptr<T>&& value) : m_value(mm::move(value)), m_count(0) {}
+
+			void release(mm::i64 n) {
+				if (m_count.fetch_add(n,mm::memory_order_acq_rel) == -n) {
+					delete this;
+				}
+			}
+		};
+	}
+
+	// lock-free cell for publishing shared_ptr snapshots. the cell packs the node
+	// pointer together with a count of loaders currently inside load() (split
+	// reference counting), so a load is one fetch_add and one compare exchange
+	// on the cell plus the reference taken on the snapshot itself, and never
+	// allocates. every store allocates a node. at most 2^16 - 1 loads may be in
+	// flight on a single cell at once
+	template <class T>
+	class atomic_shared_ptr {
+	public:
+		using value_type = mm::shared_ptr<T>;
+
+	private:
+		using node_type = detail::atomic_shared_node<T>;
+
+		static constexpr mm::u64 local_shift = 48;
+		static constexpr mm::u64 local_one = mm::u64(1) << local_shift;
+		static constexpr mm::u64 pointer_mask = local_one - 1;
+
+		STATIC_ASSERT(sizeof(void*) <= 8,"atomic_shared_ptr packs pointers into 48 bits");
+
+		mm::atomic<mm::u64> m_word;
+
+		static mm::u64 pack(node_type* node) {
+			return static_cast<mm::u64>(reinterpret_cast<uintptr_t>(node));
+		}
+
+		static node_type* node_of(mm::u64 word) {
+			return reinterpret_cast<node_type*>(static_cast<uintptr_t>(word & pointer_mask));
+		}
+
+		static mm::i64 local_count(mm::u64 word) {
+			return static_cast<mm::i64>(word >> local_shift);
+		}
+
+		static node_type* make_node(value_type&& value) {
+			return value ? new node_type(mm::move(value)) : nullptr;
+		}
+
+		// pins the published node so it cannot be freed until unpin()
+		node_type* pin() const {
+			mm::atomic<mm::u64>& word = const_cast<mm::atomic<mm::u64>&>(m_word);
+			return node_of(word.fetch_add(local_one,mm::memory_order_acquire));
+		}
+
+		void unpin(node_type* node) const {
+			mm::atomic<mm::u64>& word = const_cast<mm::atomic<mm::u64>&>(m_word);
+			mm::u64 current = word.load(mm::memory_order_relaxed);
+
+			while (node_of(current) == node) {
+				if (word.compare_exchange_weak(current,current - local_one,mm::memory_order_release,mm::memory_order_relaxed)) {
+					return;
+				}
+			}
+
+			// the node was replaced while pinned, the writer moved our local
+			// reference onto the node itself
+			if (node) {
+				node->release(-1);
+			}
+		}
+
+		// takes ownership of a node that has just been unpublished
+		static value_type retire(mm::u64 word) {
+			node_type* node = node_of(word);
+
+			if (!node) {
+				return value_type();
+			}
+
+			// hold on to the node ourselves while copying the value out
+			mm::i64 local = local_count(word);
+
+			if (node->m_count.fetch_add(local + 1,mm::memory_order_acq_rel) == -local) {
+				value_type value(mm::move(node->m_value));
+				delete node;
+				return value;
+			}
+
+			value_type value(node->m_value);
+			node->release(-1);
+			return value;
+		}
+
+		static void discard(mm::u64 word) {
+			node_type* node = node_of(word);
+
+			if (node) {
+				node->release(local_count(word));
+			}
+		}
+
+	public:
+		constexpr atomic_shared_ptr() : m_word(0) {}
+		atomic_shared_ptr(value_type value) : m_word(pack(make_node(mm::move(value)))) {}
+
+		atomic_shared_ptr(const atomic_shared_ptr&) = delete;
+		atomic_shared_ptr& operator=(const atomic_shared_ptr&) = delete;
+
+		~atomic_shared_ptr() {
+			discard(m_word.load(mm::memory_order_acquire));
+		}
+
+		static constexpr bool is_lock_free() {
+			return true;
+		}
+
+		value_type load() const {
+			node_type* node = pin();
+			value_type value(node ? node->m_value : value_type());
+			unpin(node);
+			return value;
+		}
+
+		void store(value_type value) {
+			discard(m_word.exchange(pack(make_node(mm::move(value))),mm::memory_order_acq_rel));
+		}
+
+		value_type exchange(value_type value) {
+			return retire(m_word.exchange(pack(make_node(mm::move(value))),mm::memory_order_acq_rel));
+		}
+
+		// succeeds if the published value shares both ownership and pointer with
+		// expected, otherwise expected is updated with the published value
+		bool compare_exchange_strong(value_type& expected,value_type desired) {
+			node_type* replacement = make_node(mm::move(desired));
+
+			for (;;) {
+				node_type* node = pin();
+				mm::u64 current = m_word.load(mm::memory_order_relaxed);
+
+				bool matches = node
+					? (node->m_value.get() == expected.get() && !node->m_value.owner_before(expected) && !expected.owner_before(node->m_value))
+					: !expected;
+
+				if (!matches) {
+					expected = node ? node->m_value : value_type();
+					unpin(node);
+					delete replacement;
+					return false;
+				}
+
+				while (node_of(current) == node) {
+					if (m_word.compare_exchange_weak(current,pack(replacement),mm::memory_order_acq_rel,mm::memory_order_relaxed)) {
+						// our own pin is part of the local count we hand over
+						if (node) {
+							node->release(local_count(current) - 1);
+						}
+
+						return true;
+					}
+				}
+
+				unpin(node);
+			}
+		}
+
+		// a spurious failure buys nothing here, the loop is already in strong
+		bool compare_exchange_weak(value_type& expected,value_type desired) {
+			return compare_exchange_strong(expected,mm::move(desired));
+		}
+
+		operator value_type() const {
+			return load();
+		}
+
+		atomic_shared_ptr& operator=(value_type value) {
+			store(mm::move(value));
+			return *this;
+		}
+	};
+
+	template <class T>
+	class atomic<mm::shared_ptr<T>> : public mm::atomic_shared_ptr<T> {
+	public:
+		using mm::atomic_shared_ptr<T>::atomic_shared_ptr;
+		using mm::atomic_shared_ptr<T>::operator=;
+	};
+
+	namespace detail {
+		// deleter of the atomic control block made by local_shared_ptr::share(),
+		// drops the single local reference that was handed over
+		struct local_control_block_release {
+			detail::local_control_block* m_control;
+
+			template <class T>
+			void operator()(T*) const {
+				m_control->release_reference();
+			}
+		};
+	}
+
+	// shared_ptr for ownership that stays on the thread that created it.
+	// uses the same control blocks as shared_ptr but with plain counts, so a
+	// copy is an ordinary increment. keeping every copy on one thread is up to
+	// the caller: it does not convert to shared_ptr implicitly and mm::atomic
+	// refuses it, but nothing stops a copy being passed to another thread by
+	// hand. share() is the way to hand the object over
+	template <class T>
+	class local_shared_ptr {
+	public:
+		using element_type = T;
+
+	private:
+		template <class U> friend class local_shared_ptr;
+		friend struct detail::shared_ptr_access;
+
+		detail::local_control_block *m_control;
+		element_type *m_element;
+
+		local_shared_ptr(detail::local_control_block* control,element_type* element) : m_control(control), m_element(element) {}
+
+		// stays empty if the control block cannot be allocated, ptr is deleted
+		template <class U,class Alloc,class Deleter>
+		void allocate_control_block_with_ptr(U* ptr,Alloc alloc,Deleter del) {
+			mm::expected<detail::local_control_block*,mm::error> control = detail::allocate_control_block_with_ptr<detail::local_control_block>(ptr,alloc,del);
+
+			if (control) {
+				m_control = *control;
+				m_element = ptr;
+			}
+		}
+
+	public:
+		constexpr local_shared_ptr() : m_control(), m_element() {}
+		constexpr local_shared_ptr(mm::nullptr_t) : m_control(), m_element() {}
+
+		template <class U,mm::enable_if_t<
+			mm::is_convertible<U*,element_type*>::value
+		> = nullptr>
+		explicit local_shared_ptr(U* ptr) : m_control(), m_element() {
+			allocate_control_block_with_ptr(
+				ptr,
+				mm::default_allocator<mm::u8>(),
+				mm::default_delete<U>()
+			);
+		}
+
+		template <class U,class Deleter,mm::enable_if_t<
+			mm::is_convertible<U*,element_type*>::value
+		     && mm::is_copy_constructible<Deleter>::value
+		> = nullptr>
+		local_shared_ptr(U* ptr,Deleter del) : m_control(), m_element() {
+			allocate_control_block_with_ptr(
+				ptr,
+				mm::default_allocator<mm::u8>(),
+				del
+			);
+		}
+
+		template <class U,class Alloc,class Deleter,mm::enable_if_t<
+			mm::is_convertible<U*,element_type*>::value
+		     && mm::is_copy_constructible<Deleter>::value
+		> = nullptr>
+		local_shared_ptr(U* ptr,Alloc alloc,Deleter del) : m_control(), m_element() {
+			allocate_control_block_with_ptr(
+				ptr,
+				alloc,
+				del
+			);
+		}
+
+		local_shared_ptr(const local_shared_ptr& other) : m_control(other.m_control), m_element(other.m_element) {
+			if (m_control) {
+				m_control->inc_reference();
+			}
+		}
+
+		local_shared_ptr(local_shared_ptr&& other) : m_control(other.m_control), m_element(other.m_element) {
+			other.m_control = nullptr;
+			other.m_element = nullptr;
+		}
+
+		template <class U,mm::enable_if_t<
+			mm::is_convertible<U*,element_type*>::value
+		> = nullptr>
+		local_shared_ptr(const local_shared_ptr<U>& other) : m_control(other.m_control), m_element(other.m_element) {
+			if (m_control) {
+				m_control->inc_reference();
+			}
+		}
+
+		template <class U,mm::enable_if_t<
+			mm::is_convertible<U*,element_type*>::value
+		> = nullptr>
+		local_shared_ptr(local_shared_ptr<U>&& other) : m_control(other.m_control), m_element(other.m_element) {
+			other.m_control = nullptr;
+			other.m_element = nullptr;
+		}
+
+		template <class U>
+		local_shared_ptr(const local_shared_ptr<U>& other,element_type* ptr) : m_control(other.m_control), m_element(ptr) {
+			if (m_control) {
+				m_control->inc_reference();
+			}
+		}
+
+		template <class U>
+		local_shared_ptr(local_shared_ptr<U>&& other,element_type* ptr) : m_control(other.m_control), m_element(ptr) {
+			other.m_control = nullptr;
+			other.m_element = nullptr;
+		}
+
+		~local_shared_ptr() {
+			if (m_control) {
+				m_control->release_reference();
+			}
+		}
+
+		local_shared_ptr& operator=(const local_shared_ptr& other) {
+			local_shared_ptr(other).swap(*this);
+			return *this;
+		}
+
+		local_shared_ptr& operator=(local_shared_ptr&& other) {
+			local_shared_ptr(mm::move(other)).swap(*this);
+			return *this;
+		}
+
+		template <class U>
+		local_shared_ptr& operator=(const local_shared_ptr<U>& other) {
+			local_shared_ptr(other).swap(*this);
+			return *this;
+		}
+
+		template <class U>
+		local_shared_ptr& operator=(local_shared_ptr<U>&& other) {
+			local_shared_ptr(mm::move(other)).swap(*this);
+			return *this;
+		}
+
+		void reset() {
+			local_shared_ptr().swap(*this);
+		}
+
+		template <class U>
+		void reset(U* ptr) {
+			local_shared_ptr(ptr).swap(*this);
+		}
+
+		void swap(local_shared_ptr& other) {
+			mm::swap(m_control,other.m_control);
+			mm::swap(m_element,other.m_element);
+		}
+
+		element_type* get() const {
+			return m_element;
+		}
+
+		mm::add_lvalue_reference_t<element_type> operator*() const {
+			return *m_element;
+		}
+
+		element_type* operator->() const {
+			return m_element;
+		}
+
+		mm::i32 use_count() const {
+			return m_control ? m_control->ref_count() : 0;
+		}
+
+		explicit operator bool() const {
+			return m_element != nullptr;
+		}
+
+		// one way hand over to a thread safe shared_ptr. the object stays where
+		// it is, the last local reference moves into a new atomic control block
+		// which releases it once the shared_ptrs are gone. no other local copy
+		// may exist, since its count would then be touched from two threads, so
+		// with copies left this is untouched and ERROR_GENERAL is returned. on
+		// ERROR_FAILED_ALLOC the reference has already been released
+		mm::expected<mm::shared_ptr<T>,mm::error> share() && {
+			if (!m_control) {
+				return mm::shared_ptr<T>();
+			}
+
+			if (m_control->ref_count() != 1) {
+				return mm::make_unexpected(mm::ERROR_GENERAL);
+			}
+
+			// the local reference belongs to release from here on, even when the
+			// control block cannot be allocated and release runs straight away
+			detail::local_control_block_release release = { m_control };
+			element_type* element = m_element;
+			m_control = nullptr;
+			m_element = nullptr;
+
+			mm::expected<detail::control_block*,mm::error> control = detail::allocate_control_block_with_ptr<detail::control_block>(
+				element,
+				mm::default_allocator<mm::u8>(),
+				release
+			);
+
+			if (!control) {
+				return mm::make_unexpected(control.error());
+			}
+
+			return detail::shared_ptr_access::adopt< mm::shared_ptr<T> >(*control,element);
+		}
+	};
+
+	template <class T1,class T2>
+	bool operator==(const mm::local_shared_ptr<T1>& lhs,const mm::local_shared_ptr<T2>& rhs) {
+		return lhs.get() == rhs.get();
+	}
+
+	template <class T1,class T2>
+	bool operator!=(const mm::local_shared_ptr<T1>& lhs,const mm::local_shared_ptr<T2>& rhs) {
+		return lhs.get() != rhs.get();
+	}
+
+	template <class T>
+	bool operator==(const mm::local_shared_ptr<T>& ptr,mm::nullptr_t) {
+		return !bool(ptr);
+	}
+
+	template <class T>
+	bool operator==(mm::nullptr_t,const mm::local_shared_ptr<T>& ptr) {
+		return !bool(ptr);
+	}
+
+	template <class T>
+	bool operator!=(const mm::local_shared_ptr<T>& ptr,mm::nullptr_t) {
+		return bool(ptr);
+	}
+
+	template <class T>
+	bool operator!=(mm::nullptr_t,const mm::local_shared_ptr<T>& ptr) {
+		return bool(ptr);
+	}
+
+	template <class T>
+	void swap(mm::local_shared_ptr<T>& lhs,mm::local_shared_ptr<T>& rhs) {
+		lhs.swap(rhs);
+	}
+
+	template <class T>
+	class atomic<mm::local_shared_ptr<T>> {
+		STATIC_ASSERT(mm::deduced_false_t<T>::value,"local_shared_ptr cannot be shared between threads, convert it with share()");
+	};
+
+	namespace detail {
+		template <class Ptr,class Base,class T,class Alloc>
+		struct adopt_control_block_inline {
+			Ptr operator()(detail::control_block_inline_for<T,Base,Alloc>* control) const {
+				return detail::shared_ptr_access::adopt<Ptr>(static_cast<Base*>(control),control->get_ptr());
+			}
+		};
+
+		template <class Ptr,class Base,class T,class Alloc,class... Args>
+		mm::expected<Ptr,mm::error> allocate_shared_inline(const Alloc& alloc,Args&&... args) {
+			return detail::allocate_control_block_inline<T,Base>(alloc,mm::forward<Args>(args)...).map(
+				detail::adopt_control_block_inline<Ptr,Base,T,Alloc>()
+			);
+		}
+	}
+
+	// the try_ variants report allocation failure, the others return an empty pointer
+	template <class T,class Alloc,class... Args,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::expected<mm::shared_ptr<T>,mm::error> try_allocate_shared(const Alloc& alloc,Args&&... args) {
+		return detail::allocate_shared_inline<mm::shared_ptr<T>,detail::control_block,T>(alloc,mm::forward<Args>(args)...);
+	}
+
+	template <class T,class... Args,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::expected<mm::shared_ptr<T>,mm::error> try_make_shared(Args&&... args) {
+		return mm::try_allocate_shared<T>(mm::default_allocator<mm::u8>(),mm::forward<Args>(args)...);
+	}
+
+	template <class T,class Alloc,class... Args,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::shared_ptr<T> allocate_shared(const Alloc& alloc,Args&&... args) {
+		return mm::try_allocate_shared<T>(alloc,mm::forward<Args>(args)...).value_or(nullptr);
+	}
+
+	template <class T,class... Args,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::shared_ptr<T> make_shared(Args&&... args) {
+		return mm::allocate_shared<T>(mm::default_allocator<mm::u8>(),mm::forward<Args>(args)...);
+	}
+
+	template <class T,class Alloc,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::shared_ptr<T> allocate_shared_for_overwrite(const Alloc& alloc) {
+		return detail::allocate_shared_inline<mm::shared_ptr<T>,detail::control_block,T>(alloc,detail::default_init_t()).value_or(nullptr);
+	}
+
+	template <class T,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::shared_ptr<T> make_shared_for_overwrite() {
+		return mm::allocate_shared_for_overwrite<T>(mm::default_allocator<mm::u8>());
+	}
+
+	template <class T,class... Args,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::expected<mm::local_shared_ptr<T>,mm::error> try_make_local_shared(Args&&... args) {
+		return detail::allocate_shared_inline<mm::local_shared_ptr<T>,detail::local_control_block,T>(mm::default_allocator<mm::u8>(),mm::forward<Args>(args)...);
+	}
+
+	template <class T,class... Args,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::local_shared_ptr<T> make_local_shared(Args&&... args) {
+		return mm::try_make_local_shared<T>(mm::forward<Args>(args)...).value_or(nullptr);
+	}
+
+	template <class T,mm::enable_if_t<
+		!mm::is_array<T>::value
+	> = nullptr>
+	mm::local_shared_ptr<T> make_local_shared_for_overwrite() {
+		return detail::allocate_shared_inline<mm::local_shared_ptr<T>,detail::local_control_block,T>(mm::default_allocator<mm::u8>(),detail::default_init_t()).value_or(nullptr);
+	}
 
 	// mm::hash<mm::shared_ptr>
 }
@@ -0,0 +1,284 @@
+#ifndef MM_MMAP_ALLOCATOR_HPP
+#define MM_MMAP_ALLOCATOR_HPP
+#include <sys/mman.h>
+#include <unistd.h>
+#include "mm/memory.hpp"
+
+namespace mm {
+	enum mmap_flags {
+		MMAP_NONE = 0,
+		MMAP_POPULATE = 1 << 0, // fault every page in up front
+		MMAP_HUGEPAGE = 1 << 1, // huge page aligned and madvise(MADV_HUGEPAGE)
+		MMAP_HUGETLB = 1 << 2 // MAP_HUGETLB from the reserved pool, MMAP_HUGEPAGE when the pool is empty
+	};
+
+	// the default huge page size on x86-64 and most arm64 kernels, and the
+	// size MAP_HUGETLB uses when no size is encoded in the flags
+	constexpr mm::size_t mmap_huge_page_size = mm::size_t(1) << 21;
+
+	// requests below this are left to malloc
+	constexpr mm::size_t mmap_default_threshold = mm::size_t(1) << 20;
+
+	namespace detail {
+		// zero until the first call, and zero initialised so it needs no guard
+		inline mm::size_t& mmap_page_size_cache() {
+			static mm::size_t cache;
+			return cache;
+		}
+
+		inline mm::size_t mmap_page_size() {
+			mm::size_t size = __atomic_load_n(&detail::mmap_page_size_cache(),__ATOMIC_RELAXED);
+
+			if (!size) {
+				size = static_cast<mm::size_t>(sysconf(_SC_PAGESIZE));
+				__atomic_store_n(&detail::mmap_page_size_cache(),size,__ATOMIC_RELAXED);
+			}
+
+			return size;
+		}
+
+		// huge pages only make sense for mappings of at least one
+		inline bool mmap_uses_huge_pages(mm::size_t bytes,mm::u32 flags) {
+			return (flags & (mm::MMAP_HUGEPAGE | mm::MMAP_HUGETLB)) && bytes >= mm::mmap_huge_page_size;
+		}
+
+		// depends only on bytes and flags, so unmapping gets the same length
+		// whether or not MAP_HUGETLB fell back
+		inline mm::size_t mmap_length(mm::size_t bytes,mm::u32 flags) {
+			mm::size_t granule = detail::mmap_uses_huge_pages(bytes,flags) ? mm::mmap_huge_page_size : detail::mmap_page_size();
+			return (bytes + granule - 1) & ~(granule - 1);
+		}
+
+		// MAP_POPULATE on a mapping that is only advised afterwards would fault
+		// it in as small pages, so advised mappings are touched once per page
+		inline void mmap_prefault(void* ptr,mm::size_t length) {
+		#if defined(MADV_POPULATE_WRITE)
+			if (madvise(ptr,length,MADV_POPULATE_WRITE) == 0) {
+				return;
+			}
+		#endif
+
+			volatile mm::u8* bytes = static_cast<volatile mm::u8*>(ptr);
+			mm::size_t page = detail::mmap_page_size();
+
+			for (mm::size_t i = 0; i < length; i += page) {
+				bytes[i] = 0;
+			}
+		}
+
+		// THP only backs huge page aligned ranges, so over map by one huge page
+		// and cut the aligned range out of the middle
+		inline void* mmap_map_aligned(mm::size_t length,mm::u32 flags) {
+			void* raw = mmap(nullptr,length + mm::mmap_huge_page_size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+
+			if (raw == MAP_FAILED) {
+				return nullptr;
+			}
+
+			uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+			uintptr_t aligned = (start + mm::mmap_huge_page_size - 1) & ~(uintptr_t(mm::mmap_huge_page_size) - 1);
+			mm::size_t head = static_cast<mm::size_t>(aligned - start);
+
+			if (head) {
+				munmap(raw,head);
+			}
+
+			if (mm::mmap_huge_page_size - head) {
+				munmap(reinterpret_cast<void*>(aligned + length),mm::mmap_huge_page_size - head);
+			}
+
+			void* ptr = reinterpret_cast<void*>(aligned);
+
+		#if defined(MADV_HUGEPAGE)
+			madvise(ptr,length,MADV_HUGEPAGE);
+		#endif
+
+			if (flags & mm::MMAP_POPULATE) {
+				detail::mmap_prefault(ptr,length);
+			}
+
+			return ptr;
+		}
+
+		// counted under source, once per mapping
+		inline void* mmap_allocate(mm::size_t bytes,mm::u32 flags,mm::alloc_source source = mm::ALLOC_SOURCE_MMAP_ALLOCATOR) {
+			// rounding up to the granule must not wrap
+			if (bytes > mm::numeric_limits<mm::size_t>::max - mm::mmap_huge_page_size) {
+				return nullptr;
+			}
+
+			mm::size_t length = detail::mmap_length(bytes,flags);
+			void* ptr = nullptr;
+
+			if (detail::mmap_uses_huge_pages(bytes,flags)) {
+			#if defined(MAP_HUGETLB)
+				if (flags & mm::MMAP_HUGETLB) {
+					int map_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+
+				#if defined(MAP_POPULATE)
+					if (flags & mm::MMAP_POPULATE) {
+						map_flags |= MAP_POPULATE;
+					}
+				#endif
+
+					ptr = mmap(nullptr,length,PROT_READ | PROT_WRITE,map_flags,-1,0);
+					ptr = ptr == MAP_FAILED ? nullptr : ptr;
+				}
+			#endif
+
+				if (!ptr) {
+					ptr = detail::mmap_map_aligned(length,flags);
+				}
+			} else {
+				int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+			#if defined(MAP_POPULATE)
+				if (flags & mm::MMAP_POPULATE) {
+					map_flags |= MAP_POPULATE;
+				}
+			#endif
+
+				ptr = mmap(nullptr,length,PROT_READ | PROT_WRITE,map_flags,-1,0);
+				ptr = ptr == MAP_FAILED ? nullptr : ptr;
+			}
+
+			if (ptr) {
+				detail::track_allocate(&mm::alloc_source_counters(source),length);
+			}
+
+			return ptr;
+		}
+
+		inline void mmap_deallocate(void* ptr,mm::size_t bytes,mm::u32 flags,mm::alloc_source source = mm::ALLOC_SOURCE_MMAP_ALLOCATOR) {
+			mm::size_t length = detail::mmap_length(bytes,flags);
+			munmap(ptr,length);
+			detail::track_deallocate(&mm::alloc_source_counters(source),length);
+		}
+	}
+
+	// maps requests of at least threshold bytes straight from the kernel,
+	// smaller ones go to malloc. mapped memory starts zeroed and page aligned.
+	// both the flags and the threshold decide how a block is freed, so only
+	// allocators that agree on them compare equal
+	template <class T>
+	class mmap_allocator {
+	public:
+		using value_type = T;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using propagate_on_container_move_assignment = mm::true_t;
+		using is_always_equal = mm::false_t;
+
+		STATIC_ASSERT(alignof(T) <= 16,"mmap_allocator falls back to malloc, which only aligns to 16");
+
+	private:
+		template <class U> friend class mmap_allocator;
+
+		mm::u32 m_flags;
+		mm::size_t m_threshold;
+
+	public:
+		explicit mmap_allocator(mm::u32 flags = mm::MMAP_HUGEPAGE,mm::size_t threshold = mm::mmap_default_threshold) : m_flags(flags), m_threshold(threshold) {}
+
+		template <class U>
+		mmap_allocator(const mmap_allocator<U>& other) : m_flags(other.m_flags), m_threshold(other.m_threshold) {}
+
+		mm::u32 flags() const { return m_flags; }
+		mm::size_t threshold() const { return m_threshold; }
+
+		// whether n elements are mapped, and so start zeroed
+		bool maps(mm::size_t n) const {
+			return sizeof(T) * n >= m_threshold;
+		}
+
+		T* allocate(mm::size_t n) {
+			if (n > mm::numeric_limits<mm::size_t>::max / sizeof(T)) {
+				return nullptr;
+			}
+
+			if (maps(n)) {
+				return static_cast<T*>(detail::mmap_allocate(sizeof(T) * n,m_flags));
+			}
+
+			return static_cast<T*>(detail::tracked_malloc(sizeof(T) * n,mm::ALLOC_SOURCE_MMAP_ALLOCATOR));
+		}
+
+		void deallocate(T* p,mm::size_t n) {
+			if (maps(n)) {
+				detail::mmap_deallocate(static_cast<void*>(p),sizeof(T) * n,m_flags);
+			} else {
+				detail::tracked_free(static_cast<void*>(p),mm::ALLOC_SOURCE_MMAP_ALLOCATOR);
+			}
+		}
+
+		template <class U>
+		bool operator==(const mmap_allocator<U>& other) const {
+			return m_flags == other.m_flags && m_threshold == other.m_threshold;
+		}
+
+		template <class U>
+		bool operator!=(const mmap_allocator<U>& other) const {
+			return !(*this == other);
+		}
+	};
+
+	template <class T>
+	class mmap_delete;
+
+	// remembers the element count and allocator the array came from
+	template <class T>
+	class mmap_delete<T[]> {
+	private:
+		mm::size_t m_count;
+		mm::mmap_allocator<T> m_alloc;
+
+	public:
+		mmap_delete() : m_count(0) {}
+		mmap_delete(mm::size_t count,const mm::mmap_allocator<T>& alloc) : m_count(count), m_alloc(alloc) {}
+
+		mm::size_t count() const {
+			return m_count;
+		}
+
+		void operator()(T* p) const {
+			if (!mm::is_trivially_destructible<T>::value) {
+				for (mm::size_t i = m_count; i > 0; --i) {
+					mm::destroy_at(p + i - 1);
+				}
+			}
+
+			mm::mmap_allocator<T> alloc(m_alloc);
+			alloc.deallocate(p,m_count);
+		}
+	};
+
+	template <class T>
+	using mmap_unique_ptr = mm::unique_ptr<T,mm::mmap_delete<T>>;
+
+	// value initialised like make_unique, but trivial elements of a mapped
+	// array are left alone since the kernel already zeroed them, which keeps
+	// pages that are never touched unbacked. empty on allocation failure
+	template <class T,mm::enable_if_t<
+		mm::is_unbounded_array<T>::value
+	> = nullptr>
+	mm::mmap_unique_ptr<T> make_mmap_unique(mm::size_t n,const mm::mmap_allocator<mm::remove_extent_t<T>>& alloc = mm::mmap_allocator<mm::remove_extent_t<T>>()) {
+		using element = mm::remove_extent_t<T>;
+
+		mm::mmap_allocator<element> a(alloc);
+		element* p = a.allocate(n);
+
+		if (!p) {
+			return mm::mmap_unique_ptr<T>();
+		}
+
+		if (!(mm::is_trivially_default_constructible<element>::value && a.maps(n))) {
+			for (mm::size_t i = 0; i < n; ++i) {
+				mm::construct_at(p + i);
+			}
+		}
+
+		return mm::mmap_unique_ptr<T>(p,mm::mmap_delete<T>(n,alloc));
+	}
+}
+
+#endif
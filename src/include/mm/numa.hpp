@@ -0,0 +1,380 @@
+#ifndef MM_NUMA_HPP
+#define MM_NUMA_HPP
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include "mm/mmap_allocator.hpp"
+#include "mm/functional.hpp"
+#include "mm/bit.hpp"
+
+// per node arenas for dual socket and larger machines. nodes and their cpus
+// are read from sysfs, each arena maps its chunks with mmap and binds them to
+// its node with mbind before they are touched, and allocations are served
+// from the arena of the node the calling thread is running on. without
+// sysfs, or on a machine with one node, there is a single arena and no
+// policy syscalls are made. libnuma is not needed, the syscalls are made
+// directly. with TRACK_ALLOCATIONS the mappings, whole chunks and large
+// blocks, are counted under ALLOC_SOURCE_NUMA_RESOURCE, not every block
+
+namespace mm {
+	// node ids at or above this are ignored, the node masks are one word
+	constexpr mm::size_t numa_max_nodes = 64;
+	constexpr mm::size_t numa_max_cpus = 4096;
+
+	// power of two classes from 16 bytes to 64KB, larger blocks get their own mapping
+	constexpr mm::size_t numa_min_class_shift = 4;
+	constexpr mm::size_t numa_max_class_shift = 16;
+	constexpr mm::size_t numa_class_count = numa_max_class_shift - numa_min_class_shift + 1;
+
+	// chunks are one huge page, and aligned to it, so a block finds its
+	// chunk header and node by masking its address
+	constexpr mm::size_t numa_chunk_size = mm::mmap_huge_page_size;
+
+	namespace detail {
+		// from linux/mempolicy.h, which is not always installed
+		constexpr int numa_mpol_default = 0;
+		constexpr int numa_mpol_preferred = 1;
+
+		inline long numa_mbind(void* addr,mm::size_t length,int mode,mm::u64 mask) {
+		#if defined(SYS_mbind)
+			unsigned long nodes = static_cast<unsigned long>(mask);
+			return syscall(SYS_mbind,addr,length,mode,mask ? &nodes : nullptr,mask ? numa_max_nodes + 1 : 0,0);
+		#else
+			return -1;
+		#endif
+		}
+
+		inline long numa_set_mempolicy(int mode,mm::u64 mask) {
+		#if defined(SYS_set_mempolicy)
+			unsigned long nodes = static_cast<unsigned long>(mask);
+			return syscall(SYS_set_mempolicy,mode,mask ? &nodes : nullptr,mask ? numa_max_nodes + 1 : 0);
+		#else
+			return -1;
+		#endif
+		}
+
+		// visits every number in a sysfs list such as "0-3,8,10-11"
+		inline bool numa_read_list(const char* path,mm::function_ref<void(mm::size_t)> visit) {
+			FILE* file = fopen(path,"r");
+
+			if (!file) {
+				return false;
+			}
+
+			char buffer[4096];
+			mm::size_t length = fread(buffer,1,sizeof(buffer) - 1,file);
+			fclose(file);
+			buffer[length] = '\0';
+
+			bool any = false;
+			char* s = buffer;
+
+			while (*s) {
+				if (*s < '0' || *s > '9') {
+					++s;
+					continue;
+				}
+
+				mm::size_t first = strtoul(s,&s,10);
+				mm::size_t last = first;
+
+				if (*s == '-') {
+					last = strtoul(s + 1,&s,10);
+				}
+
+				for (mm::size_t i = first; i <= last; ++i) {
+					visit(i);
+				}
+
+				any = true;
+			}
+
+			return any;
+		}
+
+		struct numa_chunk {
+			numa_chunk* next;
+			mm::size_t arena;
+		};
+
+		struct alignas(mm::hardware_destructive_interference_size) numa_arena {
+			pthread_mutex_t lock;
+			void* free_lists[numa_class_count];
+			mm::u8* bump;
+			mm::u8* end;
+			numa_chunk* chunks;
+			mm::size_t node;
+		};
+	}
+
+	// prefers node for every later page the calling thread faults in, from
+	// any allocator. false when the kernel refused or has no numa support
+	inline bool numa_prefer_node(mm::size_t node) {
+		return node < numa_max_nodes && detail::numa_set_mempolicy(detail::numa_mpol_preferred,mm::u64(1) << node) == 0;
+	}
+
+	inline bool numa_reset_policy() {
+		return detail::numa_set_mempolicy(detail::numa_mpol_default,0) == 0;
+	}
+
+	class numa_resource {
+	private:
+		detail::numa_arena m_arenas[numa_max_nodes];
+		mm::size_t m_arena_count;
+		bool m_numa;
+		mm::u8 m_cpu_arena[numa_max_cpus];
+
+		static mm::size_t class_index(mm::size_t bytes,mm::size_t alignment) {
+			mm::size_t size = bytes > alignment ? bytes : alignment;
+			size = size > (mm::size_t(1) << numa_min_class_shift) ? size : (mm::size_t(1) << numa_min_class_shift);
+			return static_cast<mm::size_t>(mm::bit_width(size - 1)) - numa_min_class_shift;
+		}
+
+		// blocks that get their own mapping are page aligned, or huge page
+		// aligned once they are a huge page, so a larger alignment maps one
+		static mm::size_t mapped_size(mm::size_t bytes,mm::size_t alignment) {
+			return alignment > detail::mmap_page_size() && bytes < numa_chunk_size ? numa_chunk_size : bytes;
+		}
+
+		static detail::numa_chunk* chunk_of(void* p) {
+			return reinterpret_cast<detail::numa_chunk*>(reinterpret_cast<uintptr_t>(p) & ~(uintptr_t(numa_chunk_size) - 1));
+		}
+
+		// binding before anything touches the pages makes them fault in on node
+		void* map_on(mm::size_t arena,mm::size_t bytes) {
+			void* p = detail::mmap_allocate(bytes,mm::MMAP_HUGEPAGE,mm::ALLOC_SOURCE_NUMA_RESOURCE);
+
+			if (p && m_numa) {
+				detail::numa_mbind(p,detail::mmap_length(bytes,mm::MMAP_HUGEPAGE),detail::numa_mpol_preferred,mm::u64(1) << m_arenas[arena].node);
+			}
+
+			return p;
+		}
+
+		// with the arena locked
+		void* carve(detail::numa_arena& arena,mm::size_t size) {
+			mm::u8* p = reinterpret_cast<mm::u8*>((reinterpret_cast<uintptr_t>(arena.bump) + size - 1) & ~(uintptr_t(size) - 1));
+
+			if (!arena.bump || p + size > arena.end) {
+				mm::size_t arena_index = static_cast<mm::size_t>(&arena - m_arenas);
+				detail::numa_chunk* chunk = static_cast<detail::numa_chunk*>(map_on(arena_index,numa_chunk_size));
+
+				if (!chunk) {
+					return nullptr;
+				}
+
+				chunk->next = arena.chunks;
+				chunk->arena = arena_index;
+				arena.chunks = chunk;
+				arena.bump = reinterpret_cast<mm::u8*>(chunk) + mm::hardware_destructive_interference_size;
+				arena.end = reinterpret_cast<mm::u8*>(chunk) + numa_chunk_size;
+				p = reinterpret_cast<mm::u8*>((reinterpret_cast<uintptr_t>(arena.bump) + size - 1) & ~(uintptr_t(size) - 1));
+			}
+
+			arena.bump = p + size;
+			return p;
+		}
+
+		void discover(const char* root) {
+			char path[256];
+			mm::u64 nodes = 0;
+
+			snprintf(path,sizeof(path),"%s/has_memory",root);
+
+			auto add_node = [&nodes](mm::size_t node) {
+				if (node < numa_max_nodes) {
+					nodes |= mm::u64(1) << node;
+				}
+			};
+
+			if (!detail::numa_read_list(path,add_node)) {
+				snprintf(path,sizeof(path),"%s/online",root);
+				detail::numa_read_list(path,add_node);
+			}
+
+			m_arena_count = 0;
+
+			for (mm::u64 rest = nodes; rest; rest &= rest - 1) {
+				mm::size_t node = static_cast<mm::size_t>(mm::countr_zero(rest));
+				mm::size_t arena = m_arena_count++;
+				m_arenas[arena].node = node;
+
+				auto add_cpu = [this,arena](mm::size_t cpu) {
+					if (cpu < numa_max_cpus) {
+						m_cpu_arena[cpu] = static_cast<mm::u8>(arena);
+					}
+				};
+
+				snprintf(path,sizeof(path),"%s/node%zu/cpulist",root,node);
+				detail::numa_read_list(path,add_cpu);
+			}
+
+			m_numa = m_arena_count > 1;
+
+			if (m_arena_count == 0) {
+				m_arena_count = 1;
+				m_arenas[0].node = 0;
+			}
+		}
+
+	public:
+		explicit numa_resource(const char* sysfs_root = "/sys/devices/system/node") : m_arena_count(0), m_numa(false) {
+			memset(m_cpu_arena,0,sizeof(m_cpu_arena));
+
+			for (detail::numa_arena& arena : m_arenas) {
+				pthread_mutex_init(&arena.lock,nullptr);
+				memset(arena.free_lists,0,sizeof(arena.free_lists));
+				arena.bump = nullptr;
+				arena.end = nullptr;
+				arena.chunks = nullptr;
+				arena.node = 0;
+			}
+
+			discover(sysfs_root);
+		}
+
+		numa_resource(const numa_resource&) = delete;
+		numa_resource& operator=(const numa_resource&) = delete;
+
+		// blocks over 64KB that were never deallocated are left mapped
+		~numa_resource() {
+			for (detail::numa_arena& arena : m_arenas) {
+				while (arena.chunks) {
+					detail::numa_chunk* next = arena.chunks->next;
+					detail::mmap_deallocate(arena.chunks,numa_chunk_size,mm::MMAP_HUGEPAGE,mm::ALLOC_SOURCE_NUMA_RESOURCE);
+					arena.chunks = next;
+				}
+
+				pthread_mutex_destroy(&arena.lock);
+			}
+		}
+
+		// false when there is a single arena and no binding is done
+		bool is_numa() const {
+			return m_numa;
+		}
+
+		mm::size_t arena_count() const {
+			return m_arena_count;
+		}
+
+		// os node id behind an arena
+		mm::size_t node_of(mm::size_t arena) const {
+			return m_arenas[arena].node;
+		}
+
+		// arena of the node the calling thread is running on right now
+		mm::size_t current_arena() const {
+			int cpu = sched_getcpu();
+			return cpu >= 0 && static_cast<mm::size_t>(cpu) < numa_max_cpus ? m_cpu_arena[cpu] : 0;
+		}
+
+		// makes the calling thread's other allocations prefer its current node too
+		bool bind_current_thread() const {
+			return m_numa && mm::numa_prefer_node(m_arenas[current_arena()].node);
+		}
+
+		// alignment is honoured up to the huge page size, nullptr above it
+		void* allocate_on(mm::size_t arena,mm::size_t bytes,mm::size_t alignment = 16) {
+			if (alignment > numa_chunk_size) {
+				return nullptr;
+			}
+
+			mm::size_t index = class_index(bytes,alignment);
+
+			if (index >= numa_class_count) {
+				return map_on(arena,mapped_size(bytes,alignment));
+			}
+
+			detail::numa_arena& a = m_arenas[arena];
+			void* p;
+
+			pthread_mutex_lock(&a.lock);
+
+			if (a.free_lists[index]) {
+				p = a.free_lists[index];
+				memcpy(&a.free_lists[index],p,sizeof(void*));
+			} else {
+				p = carve(a,mm::size_t(1) << (index + numa_min_class_shift));
+			}
+
+			pthread_mutex_unlock(&a.lock);
+			return p;
+		}
+
+		void* allocate(mm::size_t bytes,mm::size_t alignment = 16) {
+			return allocate_on(current_arena(),bytes,alignment);
+		}
+
+		// blocks go back to the arena they came from, whichever thread frees them
+		void deallocate(void* p,mm::size_t bytes,mm::size_t alignment = 16) {
+			if (!p) {
+				return;
+			}
+
+			mm::size_t index = class_index(bytes,alignment);
+
+			if (index >= numa_class_count) {
+				detail::mmap_deallocate(p,mapped_size(bytes,alignment),mm::MMAP_HUGEPAGE,mm::ALLOC_SOURCE_NUMA_RESOURCE);
+				return;
+			}
+
+			detail::numa_arena& a = m_arenas[chunk_of(p)->arena];
+
+			pthread_mutex_lock(&a.lock);
+			memcpy(p,&a.free_lists[index],sizeof(void*));
+			a.free_lists[index] = p;
+			pthread_mutex_unlock(&a.lock);
+		}
+	};
+
+	// allocator_traits adaptor over a numa_resource, which must outlive it
+	template <class T>
+	class numa_allocator {
+	public:
+		using value_type = T;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using propagate_on_container_move_assignment = mm::true_t;
+		using is_always_equal = mm::false_t;
+
+	private:
+		template <class U> friend class numa_allocator;
+
+		mm::numa_resource* m_resource;
+
+	public:
+		explicit numa_allocator(mm::numa_resource& resource) : m_resource(mm::address_of(resource)) {}
+
+		template <class U>
+		numa_allocator(const numa_allocator<U>& other) : m_resource(other.m_resource) {}
+
+		mm::numa_resource* resource() const {
+			return m_resource;
+		}
+
+		T* allocate(mm::size_t n) {
+			if (n > mm::numeric_limits<mm::size_t>::max / sizeof(T)) {
+				return nullptr;
+			}
+
+			return static_cast<T*>(m_resource->allocate(sizeof(T) * n,alignof(T)));
+		}
+
+		void deallocate(T* p,mm::size_t n) {
+			m_resource->deallocate(static_cast<void*>(p),sizeof(T) * n,alignof(T));
+		}
+
+		template <class U>
+		bool operator==(const numa_allocator<U>& other) const {
+			return m_resource == other.m_resource;
+		}
+
+		template <class U>
+		bool operator!=(const numa_allocator<U>& other) const {
+			return m_resource != other.m_resource;
+		}
+	};
+}
+
+#endif
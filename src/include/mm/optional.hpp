@@ -0,0 +1,372 @@
+#ifndef MM_OPTIONAL_HPP
+#define MM_OPTIONAL_HPP
+#include "mm/utility.hpp"
+#include "mm/error.hpp"
+
+namespace mm {
+	struct nullopt_t {
+		struct tag {};
+		constexpr explicit nullopt_t(tag) {}
+	};
+
+	constexpr nullopt_t nullopt { nullopt_t::tag() };
+
+	template <class T> class optional;
+
+	namespace detail {
+		// types with a spare value that can stand for the disengaged state, an
+		// optional of one is the same size as the type itself. specialisations
+		// provide engaged() and reset()
+		template <class T>
+		struct optional_niche : mm::false_t {};
+
+		template <class T>
+		struct optional_niche<T*> : mm::true_t {
+			static bool engaged(T* const& value) { return value != nullptr; }
+			static void reset(T*& value) { value = nullptr; }
+		};
+
+		// 0 is not an error code, expected<void,mm::error> relies on this
+		template <>
+		struct optional_niche<mm::error> : mm::true_t {
+			static bool engaged(const mm::error& value) { return value != mm::error(); }
+			static void reset(mm::error& value) { value = mm::error(); }
+		};
+
+		template <class T,bool = mm::is_trivially_destructible<T>::value>
+		struct optional_storage {
+			union {
+				char m_empty;
+				T m_value;
+			};
+
+			bool m_engaged;
+
+			constexpr optional_storage() : m_empty(), m_engaged(false) {}
+
+			template <class... Args>
+			constexpr explicit optional_storage(mm::in_place_t,Args&&... args) : m_value(mm::forward<Args>(args)...), m_engaged(true) {}
+
+			bool engaged() const { return m_engaged; }
+
+			template <class... Args>
+			void construct(Args&&... args) {
+				mm::construct_at(mm::address_of(m_value),mm::forward<Args>(args)...);
+				m_engaged = true;
+			}
+
+			void reset() {
+				m_engaged = false;
+			}
+		};
+
+		template <class T>
+		struct optional_storage<T,false> {
+			union {
+				char m_empty;
+				T m_value;
+			};
+
+			bool m_engaged;
+
+			constexpr optional_storage() : m_empty(), m_engaged(false) {}
+
+			template <class... Args>
+			constexpr explicit optional_storage(mm::in_place_t,Args&&... args) : m_value(mm::forward<Args>(args)...), m_engaged(true) {}
+
+			~optional_storage() {
+				if (m_engaged) {
+					mm::destroy_at(mm::address_of(m_value));
+				}
+			}
+
+			bool engaged() const { return m_engaged; }
+
+			template <class... Args>
+			void construct(Args&&... args) {
+				mm::construct_at(mm::address_of(m_value),mm::forward<Args>(args)...);
+				m_engaged = true;
+			}
+
+			void reset() {
+				if (m_engaged) {
+					mm::destroy_at(mm::address_of(m_value));
+					m_engaged = false;
+				}
+			}
+		};
+
+		// trivially copyable types keep the implicit copies of the union, so the
+		// optional stays trivially copyable too
+		template <class T,bool =
+			mm::is_trivially_copy_constructible<T>::value
+		     && mm::is_trivially_copy_assignable<T>::value
+		     && mm::is_trivially_destructible<T>::value
+		>
+		struct optional_copy_base : optional_storage<T> {
+			using optional_storage<T>::optional_storage;
+		};
+
+		template <class T>
+		struct optional_copy_base<T,false> : optional_storage<T> {
+			using optional_storage<T>::optional_storage;
+
+			optional_copy_base() = default;
+
+			optional_copy_base(const optional_copy_base& other) : optional_storage<T>() {
+				if (other.m_engaged) {
+					this->construct(other.m_value);
+				}
+			}
+
+			optional_copy_base(optional_copy_base&& other) : optional_storage<T>() {
+				if (other.m_engaged) {
+					this->construct(mm::move(other.m_value));
+				}
+			}
+
+			optional_copy_base& operator=(const optional_copy_base& other) {
+				if (this->m_engaged && other.m_engaged) {
+					this->m_value = other.m_value;
+				} else if (other.m_engaged) {
+					this->construct(other.m_value);
+				} else {
+					this->reset();
+				}
+
+				return *this;
+			}
+
+			optional_copy_base& operator=(optional_copy_base&& other) {
+				if (this->m_engaged && other.m_engaged) {
+					this->m_value = mm::move(other.m_value);
+				} else if (other.m_engaged) {
+					this->construct(mm::move(other.m_value));
+				} else {
+					this->reset();
+				}
+
+				return *this;
+			}
+		};
+
+		// the niche value is the disengaged state, so there is no flag. copies
+		// and moves are the type's own
+		template <class T>
+		struct optional_niche_storage {
+			T m_value;
+
+			constexpr optional_niche_storage() : m_value() {}
+
+			template <class... Args>
+			constexpr explicit optional_niche_storage(mm::in_place_t,Args&&... args) : m_value(mm::forward<Args>(args)...) {}
+
+			bool engaged() const { return detail::optional_niche<T>::engaged(m_value); }
+
+			template <class... Args>
+			void construct(Args&&... args) {
+				m_value = T(mm::forward<Args>(args)...);
+			}
+
+			void reset() {
+				detail::optional_niche<T>::reset(m_value);
+			}
+		};
+
+		template <class T>
+		using optional_base = mm::condition_t<
+			detail::optional_niche<T>::value,
+			detail::optional_niche_storage<T>,
+			detail::optional_copy_base<T>
+		>;
+
+		template <class T> struct is_optional : mm::false_t {};
+		template <class T> struct is_optional< mm::optional<T> > : mm::true_t {};
+	}
+
+	// an optional of a trivially copyable type is trivially copyable and
+	// destructible itself. pointers, unique_ptrs and mm::error use null (0) as
+	// the disengaged state and add no space, so for those an engaged null is not
+	// representable
+	template <class T>
+	class optional : private detail::optional_base<T> {
+	private:
+		using base = detail::optional_base<T>;
+
+		STATIC_ASSERT(!mm::is_reference<T>::value,"optional of a reference is not supported");
+
+	public:
+		using value_type = T;
+
+		constexpr optional() : base() {}
+		constexpr optional(mm::nullopt_t) : base() {}
+
+		optional(const optional&) = default;
+		optional(optional&&) = default;
+
+		template <class... Args>
+		constexpr explicit optional(mm::in_place_t,Args&&... args) : base(mm::in_place,mm::forward<Args>(args)...) {}
+
+		template <class U = T,mm::enable_if_t<
+			mm::is_constructible<T,U&&>::value
+		     && !mm::is_same<mm::remove_cvref_t<U>,mm::in_place_t>::value
+		     && !detail::is_optional<mm::remove_cvref_t<U>>::value
+		> = nullptr>
+		constexpr optional(U&& value) : base(mm::in_place,mm::forward<U>(value)) {}
+
+		optional& operator=(const optional&) = default;
+		optional& operator=(optional&&) = default;
+
+		optional& operator=(mm::nullopt_t) {
+			reset();
+			return *this;
+		}
+
+		template <class U = T,mm::enable_if_t<
+			mm::is_constructible<T,U&&>::value
+		     && !detail::is_optional<mm::remove_cvref_t<U>>::value
+		> = nullptr>
+		optional& operator=(U&& value) {
+			if (has_value()) {
+				this->m_value = mm::forward<U>(value);
+			} else {
+				this->construct(mm::forward<U>(value));
+			}
+
+			return *this;
+		}
+
+		template <class... Args>
+		T& emplace(Args&&... args) {
+			reset();
+			this->construct(mm::forward<Args>(args)...);
+			return this->m_value;
+		}
+
+		void reset() {
+			base::reset();
+		}
+
+		void swap(optional& other) {
+			if (has_value() && other.has_value()) {
+				mm::swap(this->m_value,other.m_value);
+			} else if (has_value()) {
+				other.construct(mm::move(this->m_value));
+				reset();
+			} else if (other.has_value()) {
+				this->construct(mm::move(other.m_value));
+				other.reset();
+			}
+		}
+
+		bool has_value() const { return this->engaged(); }
+		explicit operator bool() const { return this->engaged(); }
+
+		T& value() & {
+			check();
+			return this->m_value;
+		}
+
+		const T& value() const & {
+			check();
+			return this->m_value;
+		}
+
+		T&& value() && {
+			check();
+			return mm::move(this->m_value);
+		}
+
+		template <class U>
+		T value_or(U&& fallback) const & {
+			return has_value() ? this->m_value : static_cast<T>(mm::forward<U>(fallback));
+		}
+
+		template <class U>
+		T value_or(U&& fallback) && {
+			return has_value() ? mm::move(this->m_value) : static_cast<T>(mm::forward<U>(fallback));
+		}
+
+		// unchecked
+		T& operator*() & { return this->m_value; }
+		const T& operator*() const & { return this->m_value; }
+		T&& operator*() && { return mm::move(this->m_value); }
+
+		T* operator->() { return mm::address_of(this->m_value); }
+		const T* operator->() const { return mm::address_of(this->m_value); }
+
+	private:
+		void check() const {
+			if (!has_value()) {
+				ERROR(mm::ERROR_UNITIALIZED_OPTIONAL,"%s",mm::error_msg[mm::ERROR_UNITIALIZED_OPTIONAL]);
+			}
+		}
+	};
+
+	template <class T>
+	mm::optional<mm::remove_cvref_t<T>> make_optional(T&& value) {
+		return mm::optional<mm::remove_cvref_t<T>>(mm::forward<T>(value));
+	}
+
+	template <class T,class... Args>
+	mm::optional<T> make_optional(Args&&... args) {
+		return mm::optional<T>(mm::in_place,mm::forward<Args>(args)...);
+	}
+
+	template <class T>
+	void swap(mm::optional<T>& lhs,mm::optional<T>& rhs) {
+		lhs.swap(rhs);
+	}
+
+	template <class T,class U>
+	bool operator==(const mm::optional<T>& lhs,const mm::optional<U>& rhs) {
+		return lhs.has_value() == rhs.has_value() && (!lhs.has_value() || *lhs == *rhs);
+	}
+
+	template <class T,class U>
+	bool operator!=(const mm::optional<T>& lhs,const mm::optional<U>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class T>
+	bool operator==(const mm::optional<T>& lhs,mm::nullopt_t) {
+		return !lhs.has_value();
+	}
+
+	template <class T>
+	bool operator==(mm::nullopt_t,const mm::optional<T>& rhs) {
+		return !rhs.has_value();
+	}
+
+	template <class T>
+	bool operator!=(const mm::optional<T>& lhs,mm::nullopt_t) {
+		return lhs.has_value();
+	}
+
+	template <class T>
+	bool operator!=(mm::nullopt_t,const mm::optional<T>& rhs) {
+		return rhs.has_value();
+	}
+
+	template <class T,class U,mm::enable_if_t<!detail::is_optional<U>::value> = nullptr>
+	bool operator==(const mm::optional<T>& lhs,const U& rhs) {
+		return lhs.has_value() && *lhs == rhs;
+	}
+
+	template <class T,class U,mm::enable_if_t<!detail::is_optional<U>::value> = nullptr>
+	bool operator==(const U& lhs,const mm::optional<T>& rhs) {
+		return rhs.has_value() && lhs == *rhs;
+	}
+
+	template <class T,class U,mm::enable_if_t<!detail::is_optional<U>::value> = nullptr>
+	bool operator!=(const mm::optional<T>& lhs,const U& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class T,class U,mm::enable_if_t<!detail::is_optional<U>::value> = nullptr>
+	bool operator!=(const U& lhs,const mm::optional<T>& rhs) {
+		return !(lhs == rhs);
+	}
+}
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef MM_SPAN_HPP
+#define MM_SPAN_HPP
+#include "mm/memory.hpp"
+
+namespace mm {
+	constexpr mm::size_t dynamic_extent = mm::size_t(-1);
+
+	template <class T,mm::size_t Extent = mm::dynamic_extent> class span;
+
+	namespace detail {
+		// a static extent is part of the type, only the pointer is stored
+		template <class T,mm::size_t Extent>
+		struct span_storage {
+			T* m_data;
+
+			constexpr span_storage(T* data,mm::size_t) : m_data(data) {}
+
+			constexpr mm::size_t size() const { return Extent; }
+		};
+
+		template <class T>
+		struct span_storage<T,mm::dynamic_extent> {
+			T* m_data;
+			mm::size_t m_size;
+
+			constexpr span_storage(T* data,mm::size_t size) : m_data(data), m_size(size) {}
+
+			constexpr mm::size_t size() const { return m_size; }
+		};
+
+		template <class T> struct is_span : mm::false_t {};
+		template <class T,mm::size_t Extent> struct is_span< mm::span<T,Extent> > : mm::true_t {};
+
+		template <class C> auto span_container_data(C& c,int) -> decltype(c.data());
+		template <class C> void span_container_data(C& c,...);
+
+		template <class Data,class T> struct span_compatible_data : mm::false_t {};
+		template <class U,class T> struct span_compatible_data<U*,T> : mm::is_convertible<U(*)[],T(*)[]> {};
+
+		// anything with data() and size() whose elements convert to T without
+		// slicing, mm::string and the other contiguous containers included. a
+		// temporary container only binds to a span of const, as a function
+		// argument, since a mutable span of it would dangle straight away
+		template <class C,class T,class Data = decltype(detail::span_container_data(mm::declval<C&>(),0))>
+		struct span_compatible_container : mm::integral_constant<bool,
+			(mm::is_lvalue_reference<C>::value || mm::is_const<T>::value)
+		     && !detail::is_span<mm::remove_cvref_t<C>>::value
+		     && !mm::is_array<mm::remove_reference_t<C>>::value
+		     && detail::span_compatible_data<Data,T>::value
+		> {};
+
+		template <mm::size_t Extent,mm::size_t Offset,mm::size_t Count>
+		struct subspan_extent : mm::integral_constant<mm::size_t,
+			Count != mm::dynamic_extent ? Count : (Extent != mm::dynamic_extent ? Extent - Offset : mm::dynamic_extent)
+		> {};
+	}
+
+	// non owning view of a contiguous run of T. with a static extent the size
+	// is a compile time constant and the span is a single pointer
+	template <class T,mm::size_t Extent>
+	class span {
+	public:
+		using element_type = T;
+		using value_type = mm::remove_cv_t<T>;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using reference = T&;
+		using const_reference = const T&;
+		using iterator = T*;
+		using reverse_iterator = mm::reverse_iterator<iterator>;
+
+		static constexpr mm::size_t extent = Extent;
+
+	private:
+		detail::span_storage<T,Extent> m_storage;
+
+	public:
+		template <mm::size_t E = Extent,mm::enable_if_t<E == 0 || E == mm::dynamic_extent> = nullptr>
+		constexpr span() : m_storage(nullptr,0) {}
+
+		// with a static extent count must equal Extent, it is not checked
+		template <class Iter,mm::enable_if_t<
+			mm::is_contiguous_iterator<Iter>::value
+		> = nullptr>
+		constexpr span(Iter first,size_type count) : m_storage(mm::to_address(first),count) {}
+
+		template <class Iter,mm::enable_if_t<
+			mm::is_contiguous_iterator<Iter>::value
+		> = nullptr>
+		span(Iter first,Iter last) : m_storage(mm::to_address(first),static_cast<size_type>(last - first)) {}
+
+		template <class U,mm::size_t N,mm::enable_if_t<
+			(Extent == mm::dynamic_extent || Extent == N)
+		     && mm::is_convertible<U(*)[],T(*)[]>::value
+		> = nullptr>
+		constexpr span(U (&array)[N]) : m_storage(array,N) {}
+
+		template <class C,mm::enable_if_t<
+			detail::span_compatible_container<C,T>::value
+		> = nullptr>
+		span(C&& c) : m_storage(c.data(),c.size()) {}
+
+		template <class U,mm::size_t N,mm::enable_if_t<
+			(Extent == mm::dynamic_extent || Extent == N)
+		     && mm::is_convertible<U(*)[],T(*)[]>::value
+		> = nullptr>
+		constexpr span(const mm::span<U,N>& other) : m_storage(other.data(),other.size()) {}
+
+		span(const span&) = default;
+		span& operator=(const span&) = default;
+
+		constexpr iterator begin() const { return m_storage.m_data; }
+		constexpr iterator end() const { return m_storage.m_data + size(); }
+		reverse_iterator rbegin() const { return reverse_iterator(end()); }
+		reverse_iterator rend() const { return reverse_iterator(begin()); }
+
+		constexpr pointer data() const { return m_storage.m_data; }
+		constexpr size_type size() const { return m_storage.size(); }
+		constexpr size_type size_bytes() const { return size() * sizeof(T); }
+		constexpr bool empty() const { return size() == 0; }
+
+		// unchecked
+		constexpr reference operator[](size_type i) const { return m_storage.m_data[i]; }
+		constexpr reference front() const { return m_storage.m_data[0]; }
+		constexpr reference back() const { return m_storage.m_data[size() - 1]; }
+
+		template <mm::size_t Count>
+		constexpr mm::span<T,Count> first() const {
+			return mm::span<T,Count>(data(),Count);
+		}
+
+		template <mm::size_t Count>
+		constexpr mm::span<T,Count> last() const {
+			return mm::span<T,Count>(data() + size() - Count,Count);
+		}
+
+		template <mm::size_t Offset,mm::size_t Count = mm::dynamic_extent>
+		constexpr mm::span<T,detail::subspan_extent<Extent,Offset,Count>::value> subspan() const {
+			return mm::span<T,detail::subspan_extent<Extent,Offset,Count>::value>(
+				data() + Offset,
+				Count == mm::dynamic_extent ? size() - Offset : Count
+			);
+		}
+
+		constexpr mm::span<T> first(size_type count) const {
+			return mm::span<T>(data(),count);
+		}
+
+		constexpr mm::span<T> last(size_type count) const {
+			return mm::span<T>(data() + size() - count,count);
+		}
+
+		constexpr mm::span<T> subspan(size_type offset,size_type count = mm::dynamic_extent) const {
+			return mm::span<T>(data() + offset,count == mm::dynamic_extent ? size() - offset : count);
+		}
+	};
+
+	template <class T,mm::size_t Extent>
+	constexpr mm::size_t mm::span<T,Extent>::extent;
+
+	template <class T,mm::size_t Extent>
+	mm::span<const mm::u8,Extent == mm::dynamic_extent ? mm::dynamic_extent : Extent * sizeof(T)> as_bytes(mm::span<T,Extent> s) {
+		return mm::span<const mm::u8,Extent == mm::dynamic_extent ? mm::dynamic_extent : Extent * sizeof(T)>(
+			reinterpret_cast<const mm::u8*>(s.data()),
+			s.size_bytes()
+		);
+	}
+
+	template <class T,mm::size_t Extent,mm::enable_if_t<!mm::is_const<T>::value> = nullptr>
+	mm::span<mm::u8,Extent == mm::dynamic_extent ? mm::dynamic_extent : Extent * sizeof(T)> as_writable_bytes(mm::span<T,Extent> s) {
+		return mm::span<mm::u8,Extent == mm::dynamic_extent ? mm::dynamic_extent : Extent * sizeof(T)>(
+			reinterpret_cast<mm::u8*>(s.data()),
+			s.size_bytes()
+		);
+	}
+
+	template <class T,mm::size_t N>
+	mm::span<T,N> make_span(T (&array)[N]) {
+		return mm::span<T,N>(array);
+	}
+
+	template <class T>
+	mm::span<T> make_span(T* data,mm::size_t count) {
+		return mm::span<T>(data,count);
+	}
+}
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef MM_STATIC_STRING_HPP
+#define MM_STATIC_STRING_HPP
+#include "mm/string_view.hpp"
+#include "mm/expected.hpp"
+#include "mm/error.hpp"
+
+namespace mm {
+	// null terminated string of at most N characters stored inside the object,
+	// it never allocates and is always trivially copyable. growing past N
+	// returns ERROR_CAPACITY_EXCEEDED and leaves the string unchanged
+	template <mm::size_t N>
+	class static_string {
+	public:
+		using traits_type = mm::char_traits<char>;
+		using value_type = char;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using reference = char&;
+		using const_reference = const char&;
+		using pointer = char*;
+		using const_pointer = const char*;
+		using iterator = char*;
+		using const_iterator = const char*;
+		using reverse_iterator = mm::reverse_iterator<iterator>;
+		using const_reverse_iterator = mm::reverse_iterator<const_iterator>;
+		using view_type = mm::string_view;
+
+		static constexpr size_type npos = size_type(-1);
+		static constexpr size_type static_capacity = N;
+
+	private:
+		char m_data[N + 1];
+		mm::smallest_unsigned_t<N> m_size;
+
+		static mm::expected<void,mm::error> overflow() {
+			return mm::make_unexpected(mm::ERROR_CAPACITY_EXCEEDED);
+		}
+
+		void set_size(size_type n) {
+			m_size = static_cast<mm::smallest_unsigned_t<N>>(n);
+			m_data[n] = '\0';
+		}
+
+	public:
+		static_string() : m_size(0) {
+			m_data[0] = '\0';
+		}
+
+		// literals that do not fit are rejected at compile time
+		template <mm::size_t M,mm::enable_if_t<(M <= N + 1)> = nullptr>
+		static_string(const char (&s)[M]) {
+			size_type n = traits_type::length(s);
+			traits_type::copy(m_data,s,n);
+			set_size(n);
+		}
+
+		static_string(const static_string&) = default;
+		static_string& operator=(const static_string&) = default;
+
+		iterator begin() { return m_data; }
+		const_iterator begin() const { return m_data; }
+		const_iterator cbegin() const { return m_data; }
+		iterator end() { return m_data + m_size; }
+		const_iterator end() const { return m_data + m_size; }
+		const_iterator cend() const { return m_data + m_size; }
+		reverse_iterator rbegin() { return reverse_iterator(end()); }
+		const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+		reverse_iterator rend() { return reverse_iterator(begin()); }
+		const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+		char* data() { return m_data; }
+		const char* data() const { return m_data; }
+		const char* c_str() const { return m_data; }
+
+		size_type size() const { return m_size; }
+		size_type length() const { return m_size; }
+		constexpr size_type capacity() const { return N; }
+		constexpr size_type max_size() const { return N; }
+		bool empty() const { return m_size == 0; }
+		bool full() const { return m_size == N; }
+
+		// unchecked
+		char& operator[](size_type i) { return m_data[i]; }
+		const char& operator[](size_type i) const { return m_data[i]; }
+		char& front() { return m_data[0]; }
+		const char& front() const { return m_data[0]; }
+		char& back() { return m_data[m_size - 1]; }
+		const char& back() const { return m_data[m_size - 1]; }
+
+		operator view_type() const {
+			return view_type(m_data,m_size);
+		}
+
+		// s may point into this string
+		mm::expected<void,mm::error> assign(view_type s) {
+			if (s.size() > N) {
+				return overflow();
+			}
+
+			traits_type::move(m_data,s.data(),s.size());
+			set_size(s.size());
+			return mm::expected<void,mm::error>();
+		}
+
+		mm::expected<void,mm::error> append(view_type s) {
+			if (s.size() > N - m_size) {
+				return overflow();
+			}
+
+			traits_type::move(m_data + m_size,s.data(),s.size());
+			set_size(m_size + s.size());
+			return mm::expected<void,mm::error>();
+		}
+
+		mm::expected<void,mm::error> append(size_type n,char c) {
+			if (n > N - m_size) {
+				return overflow();
+			}
+
+			traits_type::assign(m_data + m_size,n,c);
+			set_size(m_size + n);
+			return mm::expected<void,mm::error>();
+		}
+
+		mm::expected<void,mm::error> push_back(char c) {
+			return append(1,c);
+		}
+
+		void pop_back() {
+			set_size(m_size - 1);
+		}
+
+		void clear() {
+			set_size(0);
+		}
+
+		mm::expected<void,mm::error> resize(size_type n,char c = '\0') {
+			if (n > N) {
+				return overflow();
+			}
+
+			if (n > m_size) {
+				traits_type::assign(m_data + m_size,n - m_size,c);
+			}
+
+			set_size(n);
+			return mm::expected<void,mm::error>();
+		}
+
+		static_string& erase(size_type pos = 0,size_type n = npos) {
+			if (pos >= m_size) {
+				return *this;
+			}
+
+			if (n > m_size - pos) {
+				n = m_size - pos;
+			}
+
+			traits_type::move(m_data + pos,m_data + pos + n,m_size - pos - n);
+			set_size(m_size - n);
+			return *this;
+		}
+
+		view_type substr(size_type pos = 0,size_type n = npos) const { return view_type(*this).substr(pos,n); }
+		int compare(view_type other) const { return view_type(*this).compare(other); }
+		bool starts_with(view_type prefix) const { return view_type(*this).starts_with(prefix); }
+		bool ends_with(view_type suffix) const { return view_type(*this).ends_with(suffix); }
+		bool contains(view_type needle) const { return view_type(*this).contains(needle); }
+		size_type find(view_type needle,size_type pos = 0) const { return view_type(*this).find(needle,pos); }
+		size_type find(char c,size_type pos = 0) const { return view_type(*this).find(c,pos); }
+		size_type rfind(view_type needle,size_type pos = npos) const { return view_type(*this).rfind(needle,pos); }
+		size_type rfind(char c,size_type pos = npos) const { return view_type(*this).rfind(c,pos); }
+	};
+
+	template <mm::size_t N>
+	constexpr typename mm::static_string<N>::size_type mm::static_string<N>::npos;
+
+	template <mm::size_t N>
+	constexpr typename mm::static_string<N>::size_type mm::static_string<N>::static_capacity;
+
+	// for runtime input that may not fit
+	template <mm::size_t N>
+	mm::expected<mm::static_string<N>,mm::error> make_static_string(mm::string_view s) {
+		mm::static_string<N> result;
+
+		if (!result.assign(s)) {
+			return mm::make_unexpected(mm::ERROR_CAPACITY_EXCEEDED);
+		}
+
+		return result;
+	}
+
+	template <mm::size_t N,mm::size_t M>
+	bool operator==(const mm::static_string<N>& lhs,const mm::static_string<M>& rhs) {
+		return mm::string_view(lhs) == mm::string_view(rhs);
+	}
+
+	template <mm::size_t N>
+	bool operator==(const mm::static_string<N>& lhs,mm::string_view rhs) {
+		return mm::string_view(lhs) == rhs;
+	}
+
+	template <mm::size_t N>
+	bool operator==(mm::string_view lhs,const mm::static_string<N>& rhs) {
+		return lhs == mm::string_view(rhs);
+	}
+
+	template <mm::size_t N,mm::size_t M>
+	bool operator!=(const mm::static_string<N>& lhs,const mm::static_string<M>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <mm::size_t N>
+	bool operator!=(const mm::static_string<N>& lhs,mm::string_view rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <mm::size_t N>
+	bool operator!=(mm::string_view lhs,const mm::static_string<N>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <mm::size_t N,mm::size_t M>
+	bool operator<(const mm::static_string<N>& lhs,const mm::static_string<M>& rhs) {
+		return mm::string_view(lhs) < mm::string_view(rhs);
+	}
+}
+
+#endif
@@ -0,0 +1,571 @@
+#ifndef MM_STRING_HPP
+#define MM_STRING_HPP
+#include "mm/memory.hpp"
+#include "mm/string_view.hpp"
+#include "mm/error.hpp"
+
+namespace mm {
+	// owning, null terminated string. short strings live inline in the 24 bytes
+	// that would otherwise hold the heap pointer, size and capacity: 23 narrow
+	// characters (11 for c16, 5 for c32) before the first allocation. the last
+	// inline character holds the unused inline capacity, so a full inline string
+	// ends on a zero that doubles as the terminator. a heap string sets the top
+	// bit of its capacity, which shares the last byte, to tell the two apart
+	template <class CharT,class Alloc = mm::default_allocator<CharT>>
+	class basic_string {
+	public:
+		using traits_type = mm::char_traits<CharT>;
+		using value_type = CharT;
+		using allocator_type = Alloc;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+		using reference = CharT&;
+		using const_reference = const CharT&;
+		using pointer = CharT*;
+		using const_pointer = const CharT*;
+		using iterator = CharT*;
+		using const_iterator = const CharT*;
+		using reverse_iterator = mm::reverse_iterator<iterator>;
+		using const_reverse_iterator = mm::reverse_iterator<const_iterator>;
+		using view_type = mm::basic_string_view<CharT>;
+
+		static constexpr size_type npos = size_type(-1);
+
+	private:
+		using alloc_traits = mm::allocator_traits<Alloc>;
+
+		STATIC_ASSERT((mm::is_same<typename alloc_traits::value_type,CharT>::value),"the allocator must allocate CharT");
+		STATIC_ASSERT(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,"the inline string layout assumes little endian");
+
+		struct long_rep {
+			CharT* data;
+			size_type size;
+			size_type capacity;
+		};
+
+		static constexpr size_type inline_capacity = sizeof(long_rep) / sizeof(CharT) - 1;
+		static constexpr size_type long_flag = size_type(1) << (sizeof(size_type) * 8 - 1);
+
+		struct short_rep {
+			CharT data[inline_capacity + 1];
+		};
+
+		union rep {
+			long_rep l;
+			short_rep s;
+		};
+
+		mm::compressed_pair<rep,Alloc> m_pair;
+
+		rep& get_rep() { return m_pair.first(); }
+		const rep& get_rep() const { return m_pair.first(); }
+		Alloc& get_alloc() { return m_pair.second(); }
+
+		bool is_long() const {
+			return reinterpret_cast<const mm::u8*>(&get_rep())[sizeof(rep) - 1] & 0x80;
+		}
+
+		void set_short_size(size_type n) {
+			get_rep().s.data[inline_capacity] = static_cast<CharT>(inline_capacity - n);
+			get_rep().s.data[n] = CharT();
+		}
+
+		void set_size(size_type n) {
+			if (is_long()) {
+				get_rep().l.size = n;
+				get_rep().l.data[n] = CharT();
+			} else {
+				set_short_size(n);
+			}
+		}
+
+		CharT* allocate(size_type capacity) {
+			CharT* p = alloc_traits::allocate(get_alloc(),capacity + 1);
+
+			if (!p) {
+				ERROR(mm::ERROR_FAILED_ALLOC,"%s",mm::error_msg[mm::ERROR_FAILED_ALLOC]);
+			}
+
+			return p;
+		}
+
+		void release() {
+			if (is_long()) {
+				alloc_traits::deallocate(get_alloc(),get_rep().l.data,capacity() + 1);
+			}
+		}
+
+		void set_long(CharT* p,size_type n,size_type capacity) {
+			get_rep().l.data = p;
+			get_rep().l.size = n;
+			get_rep().l.capacity = capacity | long_flag;
+			p[n] = CharT();
+		}
+
+		void init(const CharT* s,size_type n) {
+			if (n <= inline_capacity) {
+				traits_type::copy(get_rep().s.data,s,n);
+				set_short_size(n);
+			} else {
+				CharT* p = allocate(n);
+				traits_type::copy(p,s,n);
+				set_long(p,n,n);
+			}
+		}
+
+		void init(size_type n,CharT c) {
+			if (n <= inline_capacity) {
+				traits_type::assign(get_rep().s.data,n,c);
+				set_short_size(n);
+			} else {
+				CharT* p = allocate(n);
+				traits_type::assign(p,n,c);
+				set_long(p,n,n);
+			}
+		}
+
+		// moves the contents to a buffer of exactly new_capacity characters
+		void reallocate(size_type new_capacity) {
+			size_type n = size();
+			CharT* p = allocate(new_capacity);
+			traits_type::copy(p,data(),n);
+			release();
+			set_long(p,n,new_capacity);
+		}
+
+		// at least doubles so repeated appends stay amortised constant
+		size_type grown_capacity(size_type required) const {
+			size_type doubled = capacity() * 2;
+			return required > doubled ? required : doubled;
+		}
+
+		void steal(basic_string& other) {
+			get_rep() = other.get_rep();
+			other.set_short_size(0);
+		}
+
+	public:
+		basic_string() : m_pair() {
+			set_short_size(0);
+		}
+
+		explicit basic_string(const Alloc& alloc) : m_pair(rep(),alloc) {
+			set_short_size(0);
+		}
+
+		basic_string(const CharT* s,const Alloc& alloc = Alloc()) : m_pair(rep(),alloc) {
+			init(s,traits_type::length(s));
+		}
+
+		basic_string(const CharT* s,size_type n,const Alloc& alloc = Alloc()) : m_pair(rep(),alloc) {
+			init(s,n);
+		}
+
+		basic_string(size_type n,CharT c,const Alloc& alloc = Alloc()) : m_pair(rep(),alloc) {
+			init(n,c);
+		}
+
+		explicit basic_string(view_type view,const Alloc& alloc = Alloc()) : m_pair(rep(),alloc) {
+			init(view.data(),view.size());
+		}
+
+		basic_string(const basic_string& other) : m_pair(rep(),alloc_traits::select_on_container_copy_construction(other.m_pair.second())) {
+			init(other.data(),other.size());
+		}
+
+		basic_string(const basic_string& other,const Alloc& alloc) : m_pair(rep(),alloc) {
+			init(other.data(),other.size());
+		}
+
+		basic_string(basic_string&& other) : m_pair(rep(),mm::move(other.get_alloc())) {
+			steal(other);
+		}
+
+		~basic_string() {
+			release();
+		}
+
+		basic_string& operator=(const basic_string& other) {
+			if (this != &other) {
+				if (alloc_traits::propagate_on_container_copy_assignment::value && !(get_alloc() == other.m_pair.second())) {
+					release();
+					set_short_size(0);
+					get_alloc() = other.m_pair.second();
+				}
+
+				assign(other.data(),other.size());
+			}
+
+			return *this;
+		}
+
+		basic_string& operator=(basic_string&& other) {
+			if (this == &other) {
+				return *this;
+			}
+
+			if (alloc_traits::propagate_on_container_move_assignment::value) {
+				release();
+				get_alloc() = mm::move(other.get_alloc());
+				steal(other);
+			} else if (alloc_traits::is_always_equal::value || get_alloc() == other.get_alloc()) {
+				release();
+				steal(other);
+			} else {
+				assign(other.data(),other.size());
+			}
+
+			return *this;
+		}
+
+		basic_string& operator=(const CharT* s) {
+			return assign(s,traits_type::length(s));
+		}
+
+		basic_string& operator=(view_type view) {
+			return assign(view.data(),view.size());
+		}
+
+		basic_string& operator=(CharT c) {
+			return assign(&c,1);
+		}
+
+		// s may point into this string
+		basic_string& assign(const CharT* s,size_type n) {
+			if (n > capacity()) {
+				CharT* p = allocate(n);
+				traits_type::copy(p,s,n);
+				release();
+				set_long(p,n,n);
+			} else {
+				traits_type::move(data(),s,n);
+				set_size(n);
+			}
+
+			return *this;
+		}
+
+		basic_string& assign(view_type view) {
+			return assign(view.data(),view.size());
+		}
+
+		basic_string& assign(size_type n,CharT c) {
+			if (n > capacity()) {
+				reallocate(n);
+			}
+
+			traits_type::assign(data(),n,c);
+			set_size(n);
+			return *this;
+		}
+
+		allocator_type get_allocator() const { return m_pair.second(); }
+
+		iterator begin() { return data(); }
+		const_iterator begin() const { return data(); }
+		const_iterator cbegin() const { return data(); }
+		iterator end() { return data() + size(); }
+		const_iterator end() const { return data() + size(); }
+		const_iterator cend() const { return data() + size(); }
+		reverse_iterator rbegin() { return reverse_iterator(end()); }
+		const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+		reverse_iterator rend() { return reverse_iterator(begin()); }
+		const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+		CharT* data() { return is_long() ? get_rep().l.data : get_rep().s.data; }
+		const CharT* data() const { return is_long() ? get_rep().l.data : get_rep().s.data; }
+		const CharT* c_str() const { return data(); }
+
+		size_type size() const {
+			return is_long() ? get_rep().l.size : inline_capacity - static_cast<size_type>(get_rep().s.data[inline_capacity]);
+		}
+
+		size_type length() const { return size(); }
+		bool empty() const { return size() == 0; }
+
+		size_type capacity() const {
+			return is_long() ? get_rep().l.capacity & ~long_flag : inline_capacity;
+		}
+
+		size_type max_size() const {
+			return (long_flag - 1) / sizeof(CharT) - 1;
+		}
+
+		// unchecked
+		CharT& operator[](size_type i) { return data()[i]; }
+		const CharT& operator[](size_type i) const { return data()[i]; }
+		CharT& front() { return data()[0]; }
+		const CharT& front() const { return data()[0]; }
+		CharT& back() { return data()[size() - 1]; }
+		const CharT& back() const { return data()[size() - 1]; }
+
+		operator view_type() const {
+			return view_type(data(),size());
+		}
+
+		void reserve(size_type n) {
+			if (n > capacity()) {
+				reallocate(n);
+			}
+		}
+
+		// moves back inline when the contents fit
+		void shrink_to_fit() {
+			if (!is_long() || capacity() == size()) {
+				return;
+			}
+
+			size_type n = size();
+
+			if (n <= inline_capacity) {
+				CharT* p = get_rep().l.data;
+				size_type old_capacity = capacity();
+				traits_type::copy(get_rep().s.data,p,n);
+				set_short_size(n);
+				alloc_traits::deallocate(get_alloc(),p,old_capacity + 1);
+			} else {
+				reallocate(n);
+			}
+		}
+
+		void clear() {
+			set_size(0);
+		}
+
+		void resize(size_type n,CharT c = CharT()) {
+			size_type current = size();
+
+			if (n > current) {
+				append(n - current,c);
+			} else {
+				set_size(n);
+			}
+		}
+
+		void push_back(CharT c) {
+			size_type n = size();
+
+			if (n == capacity()) {
+				reallocate(grown_capacity(n + 1));
+			}
+
+			data()[n] = c;
+			set_size(n + 1);
+		}
+
+		void pop_back() {
+			set_size(size() - 1);
+		}
+
+		// s may point into this string, the old buffer is only released once
+		// it has been copied from
+		basic_string& append(const CharT* s,size_type n) {
+			size_type current = size();
+
+			if (current + n > capacity()) {
+				size_type new_capacity = grown_capacity(current + n);
+				CharT* p = allocate(new_capacity);
+				traits_type::copy(p,data(),current);
+				traits_type::copy(p + current,s,n);
+				release();
+				set_long(p,current + n,new_capacity);
+			} else {
+				traits_type::move(data() + current,s,n);
+				set_size(current + n);
+			}
+
+			return *this;
+		}
+
+		basic_string& append(const CharT* s) {
+			return append(s,traits_type::length(s));
+		}
+
+		basic_string& append(view_type view) {
+			return append(view.data(),view.size());
+		}
+
+		basic_string& append(size_type n,CharT c) {
+			size_type current = size();
+
+			if (current + n > capacity()) {
+				reallocate(grown_capacity(current + n));
+			}
+
+			traits_type::assign(data() + current,n,c);
+			set_size(current + n);
+			return *this;
+		}
+
+		basic_string& operator+=(view_type view) { return append(view); }
+		basic_string& operator+=(const CharT* s) { return append(s); }
+		basic_string& operator+=(CharT c) { push_back(c); return *this; }
+
+		basic_string& insert(size_type pos,view_type view) {
+			size_type current = size();
+			size_type n = view.size();
+
+			// copy first when the source overlaps, growing or shifting would move it
+			if (view.data() >= data() && view.data() < data() + current) {
+				basic_string copy(view,get_alloc());
+				return insert(pos,view_type(copy));
+			}
+
+			if (current + n > capacity()) {
+				reallocate(grown_capacity(current + n));
+			}
+
+			CharT* p = data();
+			traits_type::move(p + pos + n,p + pos,current - pos);
+			traits_type::copy(p + pos,view.data(),n);
+			set_size(current + n);
+			return *this;
+		}
+
+		basic_string& insert(size_type pos,size_type n,CharT c) {
+			size_type current = size();
+
+			if (current + n > capacity()) {
+				reallocate(grown_capacity(current + n));
+			}
+
+			CharT* p = data();
+			traits_type::move(p + pos + n,p + pos,current - pos);
+			traits_type::assign(p + pos,n,c);
+			set_size(current + n);
+			return *this;
+		}
+
+		basic_string& erase(size_type pos = 0,size_type n = npos) {
+			size_type current = size();
+
+			if (pos >= current) {
+				return *this;
+			}
+
+			if (n > current - pos) {
+				n = current - pos;
+			}
+
+			CharT* p = data();
+			traits_type::move(p + pos,p + pos + n,current - pos - n);
+			set_size(current - n);
+			return *this;
+		}
+
+		void swap(basic_string& other) {
+			mm::swap(get_rep(),other.get_rep());
+
+			if (alloc_traits::propagate_on_container_swap::value) {
+				mm::swap(get_alloc(),other.get_alloc());
+			}
+		}
+
+		basic_string substr(size_type pos = 0,size_type n = npos) const {
+			return basic_string(view_type(*this).substr(pos,n),m_pair.second());
+		}
+
+		int compare(view_type other) const { return view_type(*this).compare(other); }
+		bool starts_with(view_type prefix) const { return view_type(*this).starts_with(prefix); }
+		bool starts_with(CharT c) const { return view_type(*this).starts_with(c); }
+		bool ends_with(view_type suffix) const { return view_type(*this).ends_with(suffix); }
+		bool ends_with(CharT c) const { return view_type(*this).ends_with(c); }
+		bool contains(view_type needle) const { return view_type(*this).contains(needle); }
+		bool contains(CharT c) const { return view_type(*this).contains(c); }
+		size_type find(view_type needle,size_type pos = 0) const { return view_type(*this).find(needle,pos); }
+		size_type find(CharT c,size_type pos = 0) const { return view_type(*this).find(c,pos); }
+		size_type rfind(view_type needle,size_type pos = npos) const { return view_type(*this).rfind(needle,pos); }
+		size_type rfind(CharT c,size_type pos = npos) const { return view_type(*this).rfind(c,pos); }
+	};
+
+	template <class CharT,class Alloc>
+	constexpr typename mm::basic_string<CharT,Alloc>::size_type mm::basic_string<CharT,Alloc>::npos;
+
+	template <class CharT,class Alloc>
+	constexpr typename mm::basic_string<CharT,Alloc>::size_type mm::basic_string<CharT,Alloc>::inline_capacity;
+
+	template <class CharT,class Alloc>
+	constexpr typename mm::basic_string<CharT,Alloc>::size_type mm::basic_string<CharT,Alloc>::long_flag;
+
+	template <class CharT,class Alloc>
+	void swap(mm::basic_string<CharT,Alloc>& lhs,mm::basic_string<CharT,Alloc>& rhs) {
+		lhs.swap(rhs);
+	}
+
+	template <class CharT,class Alloc>
+	mm::basic_string<CharT,Alloc> operator+(const mm::basic_string<CharT,Alloc>& lhs,mm::type_identity_t<mm::basic_string_view<CharT>> rhs) {
+		mm::basic_string<CharT,Alloc> result(lhs);
+		result.append(rhs);
+		return result;
+	}
+
+	template <class CharT,class Alloc>
+	mm::basic_string<CharT,Alloc> operator+(mm::basic_string<CharT,Alloc>&& lhs,mm::type_identity_t<mm::basic_string_view<CharT>> rhs) {
+		lhs.append(rhs);
+		return mm::move(lhs);
+	}
+
+	template <class CharT,class Alloc>
+	mm::basic_string<CharT,Alloc> operator+(mm::basic_string<CharT,Alloc>&& lhs,CharT rhs) {
+		lhs.push_back(rhs);
+		return mm::move(lhs);
+	}
+
+	// strings compare through the view operators, these resolve the cases
+	// where neither side is a view yet
+	template <class CharT,class Alloc>
+	bool operator==(const mm::basic_string<CharT,Alloc>& lhs,const mm::basic_string<CharT,Alloc>& rhs) {
+		return mm::basic_string_view<CharT>(lhs) == mm::basic_string_view<CharT>(rhs);
+	}
+
+	template <class CharT,class Alloc>
+	bool operator==(const mm::basic_string<CharT,Alloc>& lhs,const CharT* rhs) {
+		return mm::basic_string_view<CharT>(lhs) == mm::basic_string_view<CharT>(rhs);
+	}
+
+	template <class CharT,class Alloc>
+	bool operator==(const CharT* lhs,const mm::basic_string<CharT,Alloc>& rhs) {
+		return mm::basic_string_view<CharT>(lhs) == mm::basic_string_view<CharT>(rhs);
+	}
+
+	template <class CharT,class Alloc>
+	bool operator!=(const mm::basic_string<CharT,Alloc>& lhs,const mm::basic_string<CharT,Alloc>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class CharT,class Alloc>
+	bool operator!=(const mm::basic_string<CharT,Alloc>& lhs,const CharT* rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class CharT,class Alloc>
+	bool operator!=(const CharT* lhs,const mm::basic_string<CharT,Alloc>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class CharT,class Alloc>
+	bool operator<(const mm::basic_string<CharT,Alloc>& lhs,const mm::basic_string<CharT,Alloc>& rhs) {
+		return lhs.compare(rhs) < 0;
+	}
+
+	template <class CharT,class Alloc>
+	bool operator>(const mm::basic_string<CharT,Alloc>& lhs,const mm::basic_string<CharT,Alloc>& rhs) {
+		return lhs.compare(rhs) > 0;
+	}
+
+	template <class CharT,class Alloc>
+	bool operator<=(const mm::basic_string<CharT,Alloc>& lhs,const mm::basic_string<CharT,Alloc>& rhs) {
+		return lhs.compare(rhs) <= 0;
+	}
+
+	template <class CharT,class Alloc>
+	bool operator>=(const mm::basic_string<CharT,Alloc>& lhs,const mm::basic_string<CharT,Alloc>& rhs) {
+		return lhs.compare(rhs) >= 0;
+	}
+
+	using string = mm::basic_string<char>;
+	using u16string = mm::basic_string<mm::c16>;
+	using u32string = mm::basic_string<mm::c32>;
+}
+
+#endif
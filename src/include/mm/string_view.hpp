@@ -0,0 +1,343 @@
+#ifndef MM_STRING_VIEW_HPP
+#define MM_STRING_VIEW_HPP
+#include <string.h>
+#include "mm/iterator.hpp"
+
+namespace mm {
+	template <class CharT>
+	struct char_traits {
+		using char_type = CharT;
+
+		static mm::size_t length(const CharT* s) {
+			mm::size_t n = 0;
+
+			while (s[n] != CharT()) {
+				++n;
+			}
+
+			return n;
+		}
+
+		static int compare(const CharT* lhs,const CharT* rhs,mm::size_t n) {
+			for (mm::size_t i = 0; i < n; ++i) {
+				if (lhs[i] != rhs[i]) {
+					return lhs[i] < rhs[i] ? -1 : 1;
+				}
+			}
+
+			return 0;
+		}
+
+		static const CharT* find(const CharT* s,mm::size_t n,CharT c) {
+			for (mm::size_t i = 0; i < n; ++i) {
+				if (s[i] == c) {
+					return s + i;
+				}
+			}
+
+			return nullptr;
+		}
+
+		static CharT* copy(CharT* dst,const CharT* src,mm::size_t n) {
+			return static_cast<CharT*>(memcpy(dst,src,n * sizeof(CharT)));
+		}
+
+		static CharT* move(CharT* dst,const CharT* src,mm::size_t n) {
+			return static_cast<CharT*>(memmove(dst,src,n * sizeof(CharT)));
+		}
+
+		static CharT* assign(CharT* dst,mm::size_t n,CharT c) {
+			for (mm::size_t i = 0; i < n; ++i) {
+				dst[i] = c;
+			}
+
+			return dst;
+		}
+	};
+
+	// narrow characters go through libc
+	template <>
+	struct char_traits<char> {
+		using char_type = char;
+
+		static mm::size_t length(const char* s) {
+			return strlen(s);
+		}
+
+		static int compare(const char* lhs,const char* rhs,mm::size_t n) {
+			return n ? memcmp(lhs,rhs,n) : 0;
+		}
+
+		static const char* find(const char* s,mm::size_t n,char c) {
+			return n ? static_cast<const char*>(memchr(s,c,n)) : nullptr;
+		}
+
+		static char* copy(char* dst,const char* src,mm::size_t n) {
+			return static_cast<char*>(memcpy(dst,src,n));
+		}
+
+		static char* move(char* dst,const char* src,mm::size_t n) {
+			return static_cast<char*>(memmove(dst,src,n));
+		}
+
+		static char* assign(char* dst,mm::size_t n,char c) {
+			return static_cast<char*>(memset(dst,c,n));
+		}
+	};
+
+	// non owning reference to a run of characters, not necessarily null
+	// terminated. parsing into views avoids copying every token
+	template <class CharT,class Traits = mm::char_traits<CharT>>
+	class basic_string_view {
+	public:
+		using traits_type = Traits;
+		using value_type = CharT;
+		using pointer = CharT*;
+		using const_pointer = const CharT*;
+		using reference = CharT&;
+		using const_reference = const CharT&;
+		using iterator = const CharT*;
+		using const_iterator = const CharT*;
+		using reverse_iterator = mm::reverse_iterator<const_iterator>;
+		using const_reverse_iterator = mm::reverse_iterator<const_iterator>;
+		using size_type = mm::size_t;
+		using difference_type = mm::ptrdiff_t;
+
+		static constexpr size_type npos = size_type(-1);
+
+	private:
+		const CharT* m_data;
+		size_type m_size;
+
+	public:
+		constexpr basic_string_view() : m_data(nullptr), m_size(0) {}
+		constexpr basic_string_view(const CharT* s,size_type n) : m_data(s), m_size(n) {}
+		basic_string_view(const CharT* s) : m_data(s), m_size(Traits::length(s)) {}
+
+		basic_string_view(const basic_string_view&) = default;
+		basic_string_view& operator=(const basic_string_view&) = default;
+
+		constexpr const_iterator begin() const { return m_data; }
+		constexpr const_iterator end() const { return m_data + m_size; }
+		constexpr const_iterator cbegin() const { return m_data; }
+		constexpr const_iterator cend() const { return m_data + m_size; }
+		const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+		const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+		constexpr const CharT* data() const { return m_data; }
+		constexpr size_type size() const { return m_size; }
+		constexpr size_type length() const { return m_size; }
+		constexpr bool empty() const { return m_size == 0; }
+
+		// unchecked
+		constexpr const CharT& operator[](size_type i) const { return m_data[i]; }
+		constexpr const CharT& front() const { return m_data[0]; }
+		constexpr const CharT& back() const { return m_data[m_size - 1]; }
+
+		void remove_prefix(size_type n) {
+			m_data += n;
+			m_size -= n;
+		}
+
+		void remove_suffix(size_type n) {
+			m_size -= n;
+		}
+
+		void swap(basic_string_view& other) {
+			mm::swap(m_data,other.m_data);
+			mm::swap(m_size,other.m_size);
+		}
+
+		size_type copy(CharT* dst,size_type n,size_type pos = 0) const {
+			size_type count = clamp(pos,n);
+			Traits::copy(dst,m_data + pos,count);
+			return count;
+		}
+
+		// pos past the end gives an empty view
+		basic_string_view substr(size_type pos = 0,size_type n = npos) const {
+			return pos > m_size ? basic_string_view(m_data + m_size,0) : basic_string_view(m_data + pos,clamp(pos,n));
+		}
+
+		int compare(basic_string_view other) const {
+			size_type n = m_size < other.m_size ? m_size : other.m_size;
+			int result = Traits::compare(m_data,other.m_data,n);
+
+			if (result != 0) {
+				return result;
+			}
+
+			return m_size == other.m_size ? 0 : (m_size < other.m_size ? -1 : 1);
+		}
+
+		bool starts_with(basic_string_view prefix) const {
+			return m_size >= prefix.m_size && Traits::compare(m_data,prefix.m_data,prefix.m_size) == 0;
+		}
+
+		bool starts_with(CharT c) const {
+			return m_size && m_data[0] == c;
+		}
+
+		bool ends_with(basic_string_view suffix) const {
+			return m_size >= suffix.m_size && Traits::compare(m_data + m_size - suffix.m_size,suffix.m_data,suffix.m_size) == 0;
+		}
+
+		bool ends_with(CharT c) const {
+			return m_size && m_data[m_size - 1] == c;
+		}
+
+		size_type find(CharT c,size_type pos = 0) const {
+			if (pos >= m_size) {
+				return npos;
+			}
+
+			const CharT* found = Traits::find(m_data + pos,m_size - pos,c);
+			return found ? static_cast<size_type>(found - m_data) : npos;
+		}
+
+		// scans for the first character then compares the rest
+		size_type find(basic_string_view needle,size_type pos = 0) const {
+			if (needle.m_size == 0) {
+				return pos <= m_size ? pos : npos;
+			}
+
+			while (pos + needle.m_size <= m_size) {
+				const CharT* found = Traits::find(m_data + pos,m_size - pos - needle.m_size + 1,needle.m_data[0]);
+
+				if (!found) {
+					return npos;
+				}
+
+				pos = static_cast<size_type>(found - m_data);
+
+				if (Traits::compare(found + 1,needle.m_data + 1,needle.m_size - 1) == 0) {
+					return pos;
+				}
+
+				++pos;
+			}
+
+			return npos;
+		}
+
+		size_type rfind(CharT c,size_type pos = npos) const {
+			if (m_size == 0) {
+				return npos;
+			}
+
+			for (size_type i = pos < m_size ? pos + 1 : m_size; i-- > 0;) {
+				if (m_data[i] == c) {
+					return i;
+				}
+			}
+
+			return npos;
+		}
+
+		size_type rfind(basic_string_view needle,size_type pos = npos) const {
+			if (needle.m_size > m_size) {
+				return npos;
+			}
+
+			size_type i = m_size - needle.m_size;
+
+			if (pos < i) {
+				i = pos;
+			}
+
+			for (;; --i) {
+				if (Traits::compare(m_data + i,needle.m_data,needle.m_size) == 0) {
+					return i;
+				}
+
+				if (i == 0) {
+					return npos;
+				}
+			}
+		}
+
+		bool contains(basic_string_view needle) const {
+			return find(needle) != npos;
+		}
+
+		bool contains(CharT c) const {
+			return find(c) != npos;
+		}
+
+	private:
+		size_type clamp(size_type pos,size_type n) const {
+			return n < m_size - pos ? n : m_size - pos;
+		}
+	};
+
+	template <class CharT,class Traits>
+	constexpr typename mm::basic_string_view<CharT,Traits>::size_type mm::basic_string_view<CharT,Traits>::npos;
+
+	// the second overload of each operator accepts anything convertible to a
+	// view (strings, string literals) on either side
+	template <class CharT,class Traits>
+	bool operator==(mm::basic_string_view<CharT,Traits> lhs,mm::basic_string_view<CharT,Traits> rhs) {
+		return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+	}
+
+	template <class CharT,class Traits>
+	bool operator==(mm::basic_string_view<CharT,Traits> lhs,mm::type_identity_t<mm::basic_string_view<CharT,Traits>> rhs) {
+		return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+	}
+
+	template <class CharT,class Traits>
+	bool operator==(mm::type_identity_t<mm::basic_string_view<CharT,Traits>> lhs,mm::basic_string_view<CharT,Traits> rhs) {
+		return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+	}
+
+	template <class CharT,class Traits>
+	bool operator!=(mm::basic_string_view<CharT,Traits> lhs,mm::basic_string_view<CharT,Traits> rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class CharT,class Traits>
+	bool operator!=(mm::basic_string_view<CharT,Traits> lhs,mm::type_identity_t<mm::basic_string_view<CharT,Traits>> rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class CharT,class Traits>
+	bool operator!=(mm::type_identity_t<mm::basic_string_view<CharT,Traits>> lhs,mm::basic_string_view<CharT,Traits> rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class CharT,class Traits>
+	bool operator<(mm::basic_string_view<CharT,Traits> lhs,mm::basic_string_view<CharT,Traits> rhs) {
+		return lhs.compare(rhs) < 0;
+	}
+
+	template <class CharT,class Traits>
+	bool operator<(mm::basic_string_view<CharT,Traits> lhs,mm::type_identity_t<mm::basic_string_view<CharT,Traits>> rhs) {
+		return lhs.compare(rhs) < 0;
+	}
+
+	template <class CharT,class Traits>
+	bool operator<(mm::type_identity_t<mm::basic_string_view<CharT,Traits>> lhs,mm::basic_string_view<CharT,Traits> rhs) {
+		return lhs.compare(rhs) < 0;
+	}
+
+	template <class CharT,class Traits>
+	bool operator>(mm::basic_string_view<CharT,Traits> lhs,mm::basic_string_view<CharT,Traits> rhs) {
+		return lhs.compare(rhs) > 0;
+	}
+
+	template <class CharT,class Traits>
+	bool operator<=(mm::basic_string_view<CharT,Traits> lhs,mm::basic_string_view<CharT,Traits> rhs) {
+		return lhs.compare(rhs) <= 0;
+	}
+
+	template <class CharT,class Traits>
+	bool operator>=(mm::basic_string_view<CharT,Traits> lhs,mm::basic_string_view<CharT,Traits> rhs) {
+		return lhs.compare(rhs) >= 0;
+	}
+
+	using string_view = mm::basic_string_view<char>;
+	using u16string_view = mm::basic_string_view<mm::c16>;
+	using u32string_view = mm::basic_string_view<mm::c32>;
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef MM_TIMER_WHEEL_HPP
+#define MM_TIMER_WHEEL_HPP
+#include "mm/intrusive.hpp"
+#include "mm/functional.hpp"
+
+// hierarchical timing wheel. each level has 2^Bits slots and covers Bits more
+// bits of the expiry tick than the one below it, timers are kept in the
+// lowest level whose range reaches their expiry and move down a level each
+// time the level below wraps. scheduling and cancelling are O(1) and never
+// allocate, a tick fires its whole slot at once
+//
+// timers live inside the object they time out and the callback is a
+// function_ref, so the object is usually the callable:
+//
+//	struct connection {
+//		mm::timer idle;
+//		connection() : idle(*this) {}
+//		void operator()(mm::timer&) { close(); }
+//	};
+//
+// destroying a scheduled timer cancels it
+
+namespace mm {
+	template <mm::size_t Levels,mm::size_t Bits> class timer_wheel;
+
+	class timer {
+	private:
+		template <mm::size_t Levels,mm::size_t Bits> friend class timer_wheel;
+
+		mm::list_hook m_hook;
+		mm::u64 m_expiry;
+		mm::function_ref<void(mm::timer&)> m_callback;
+
+	public:
+		explicit timer(mm::function_ref<void(mm::timer&)> callback) : m_expiry(0), m_callback(callback) {}
+
+		timer(const timer&) = delete;
+		timer& operator=(const timer&) = delete;
+
+		bool is_scheduled() const {
+			return m_hook.is_linked();
+		}
+
+		// tick the timer fires on, only meaningful while scheduled
+		mm::u64 expiry() const {
+			return m_expiry;
+		}
+
+		void cancel() {
+			m_hook.unlink();
+		}
+
+		void set_callback(mm::function_ref<void(mm::timer&)> callback) {
+			m_callback = callback;
+		}
+	};
+
+	// 4 levels of 256 slots reach 2^32 ticks ahead, timers further out are
+	// parked in the top level and rescheduled when it comes round
+	template <mm::size_t Levels = 4,mm::size_t Bits = 8>
+	class timer_wheel {
+	private:
+		using hook = mm::member_hook<mm::timer,mm::list_hook,&mm::timer::m_hook>;
+		using slot = mm::intrusive_list<mm::timer,hook>;
+
+		STATIC_ASSERT(Levels > 0 && Bits > 0 && Levels * Bits < 64,"timer_wheel levels do not fit in a 64 bit tick");
+
+		static constexpr mm::size_t slots = mm::size_t(1) << Bits;
+		static constexpr mm::u64 mask = slots - 1;
+		static constexpr mm::u64 max_delay = (mm::u64(1) << (Levels * Bits)) - 1;
+
+		slot m_slots[Levels][slots];
+		mm::u64 m_now;
+
+		void place(mm::timer& t) {
+			// already due, fires with the next tick processed
+			if (t.m_expiry < m_now) {
+				m_slots[0][m_now & mask].push_back(t);
+				return;
+			}
+
+			mm::u64 delay = t.m_expiry - m_now;
+			mm::u64 expiry = t.m_expiry;
+
+			if (delay > max_delay) {
+				delay = max_delay;
+				expiry = m_now + max_delay;
+			}
+
+			mm::size_t level = 0;
+
+			while (level + 1 < Levels && delay >= (mm::u64(1) << ((level + 1) * Bits))) {
+				++level;
+			}
+
+			m_slots[level][(expiry >> (level * Bits)) & mask].push_back(t);
+		}
+
+		// moves the slot of level that is now current down to the levels below
+		void cascade(mm::size_t level) {
+			slot pending;
+			pending.splice(pending.end(),m_slots[level][(m_now >> (level * Bits)) & mask]);
+
+			while (!pending.empty()) {
+				place(pending.front());
+			}
+		}
+
+	public:
+		explicit timer_wheel(mm::u64 now = 0) : m_now(now) {}
+
+		timer_wheel(const timer_wheel&) = delete;
+		timer_wheel& operator=(const timer_wheel&) = delete;
+
+		~timer_wheel() {
+			clear();
+		}
+
+		// next tick to be processed
+		mm::u64 now() const {
+			return m_now;
+		}
+
+		// fires delay ticks from now, a delay of 0 fires on the next tick
+		// processed. a scheduled timer is moved
+		void schedule(mm::timer& t,mm::u64 delay) {
+			schedule_at(t,m_now + delay);
+		}
+
+		void schedule_at(mm::timer& t,mm::u64 expiry) {
+			t.m_expiry = expiry;
+			place(t);
+		}
+
+		// O(1), the wheel is not needed
+		static void cancel(mm::timer& t) {
+			t.cancel();
+		}
+
+		// processes a single tick and returns how many timers fired.
+		// callbacks may schedule or cancel any timer, including their own
+		mm::size_t tick() {
+			mm::size_t index = static_cast<mm::size_t>(m_now & mask);
+
+			for (mm::size_t level = 1; level < Levels && index == 0; ++level) {
+				cascade(level);
+				index = static_cast<mm::size_t>((m_now >> (level * Bits)) & mask);
+			}
+
+			slot expired;
+			expired.splice(expired.end(),m_slots[0][m_now & mask]);
+			++m_now;
+
+			mm::size_t fired = 0;
+
+			while (!expired.empty()) {
+				mm::timer& t = expired.front();
+				expired.pop_front();
+				t.m_callback(t);
+				++fired;
+			}
+
+			return fired;
+		}
+
+		// processes every tick up to and including time
+		mm::size_t advance_to(mm::u64 time) {
+			mm::size_t fired = 0;
+
+			while (m_now <= time) {
+				fired += tick();
+			}
+
+			return fired;
+		}
+
+		mm::size_t advance(mm::u64 ticks) {
+			mm::size_t fired = 0;
+
+			for (; ticks > 0; --ticks) {
+				fired += tick();
+			}
+
+			return fired;
+		}
+
+		// cancels every timer
+		void clear() {
+			for (slot (&level)[slots] : m_slots) {
+				for (slot& s : level) {
+					s.clear();
+				}
+			}
+		}
+	};
+
+	template <mm::size_t Levels,mm::size_t Bits>
+	constexpr mm::size_t mm::timer_wheel<Levels,Bits>::slots;
+
+	template <mm::size_t Levels,mm::size_t Bits>
+	constexpr mm::u64 mm::timer_wheel<Levels,Bits>::mask;
+
+	template <mm::size_t Levels,mm::size_t Bits>
+	constexpr mm::u64 mm::timer_wheel<Levels,Bits>::max_delay;
+}
+
+#endif
@@ -17,6 +17,8 @@ namespace mm {
 		using type = T;
 	};
 
+	template <class T> using type_identity_t = typename mm::type_identity<T>::type;
+
 	template <class...> using void_t = void;
 
 	#if defined(__GNUC__) || defined(__MINGW32__) || defined(__MINGW64__)
@@ -29,8 +31,7 @@ namespace mm {
 	template <class T> struct has_virtual_destructor : mm::integral_constant<bool,__has_virtual_destructor(T)> {};
 	template <class T> struct is_abstract : mm::integral_constant<bool,__is_abstract(T)> {};
 	
-	// is_final
-
+	template <class T> struct is_final : mm::integral_constant<bool,__is_final(T)> {};
 	template <class T> struct is_empty : mm::integral_constant<bool,__is_empty(T)> {};
 	template <class T> struct is_enum : mm::integral_constant<bool,__is_enum(T)> {};
 	
@@ -265,7 +266,7 @@ namespace mm {
 	template <class T> struct is_volatile : mm::false_t {};
 	template <class T> struct is_volatile<volatile T> : mm::true_t {};
 
-	template <class T> struct is_function : mm::integral_constant<bool,!mm::is_const<const T>::value && mm::is_reference<T>::value> {};
+	template <class T> struct is_function : mm::integral_constant<bool,!mm::is_const<const T>::value && !mm::is_reference<T>::value> {};
 
 	namespace detail {
 		template <class T> struct is_member_pointer_impl : mm::false_t {};
@@ -326,7 +327,7 @@ namespace mm {
 	> {};
 
 	namespace detail {
-		template <class T,class U = typename mm::remove_reference<T>::type> struct decay : mm::condition_t<
+		template <class T,class U = typename mm::remove_reference<T>::type> struct decay : mm::type_identity< mm::condition_t<
 			mm::is_array<U>::value,
 			mm::remove_extent_t<U>*,
 			mm::condition_t<
@@ -334,7 +335,7 @@ namespace mm {
 				mm::add_pointer_t<U>,
 				mm::remove_cv_t<U>
 			>
-		>::type {};
+		> > {};
 	}
 
 	template <class T> struct decay : detail::decay<T> {};
@@ -356,7 +357,7 @@ namespace mm {
 	template <class T> struct is_trivially_copy_constructible : mm::is_trivially_constructible<T,const T&> {};
 	
 	template <class T> struct is_move_constructible : mm::is_constructible< T, mm::add_rvalue_reference_t<T> > {};
-	template <class T> struct is_trivially_move_constructible : mm::is_constructible<T,T&&> {};
+	template <class T> struct is_trivially_move_constructible : mm::is_trivially_constructible< T, mm::add_rvalue_reference_t<T> > {};
 
 	namespace detail {
 		template <class T,class U,class = void> struct is_assignable_impl : mm::false_t {};
@@ -366,10 +367,10 @@ namespace mm {
 	template <class T,class U> struct is_assignable : detail::is_assignable_impl<T,U> {};
 
 	template <class T> struct is_copy_assignable : mm::is_assignable< mm::add_lvalue_reference_t<T>, mm::add_lvalue_reference_t<const T> > {};
-	template <class T> struct is_trivially_copy_assignable : mm::is_trivially_assignable<T,const T&> {};
+	template <class T> struct is_trivially_copy_assignable : mm::is_trivially_assignable< mm::add_lvalue_reference_t<T>, mm::add_lvalue_reference_t<const T> > {};
 
 	template <class T> struct is_move_assignable : mm::is_assignable< mm::add_lvalue_reference_t<T>, mm::add_rvalue_reference_t<T> > {};
-	template <class T> struct is_trivially_move_assignable : mm::is_trivially_assignable< T, mm::add_rvalue_reference_t<T> > {};
+	template <class T> struct is_trivially_move_assignable : mm::is_trivially_assignable< mm::add_lvalue_reference_t<T>, mm::add_rvalue_reference_t<T> > {};
 
 	template <class T> struct is_trivial : mm::integral_constant< bool, mm::is_trivially_copyable<T>::value && mm::is_trivially_default_constructible<T>::value > {};
 
@@ -380,6 +381,18 @@ namespace mm {
 	template <class T,class U> struct rebind : type_identity<U> {};
 	template <template <class,class...> class TT,class T,class... Ts,class U> struct rebind<TT<T,Ts...>,U> : mm::type_identity<TT<U,Ts...>> {};
 	template <class T,class U> using rebind_t = typename rebind<T,U>::type;
+
+	// smallest unsigned type that can hold every value up to Max
+	template <mm::u64 Max>
+	using smallest_unsigned_t = mm::condition_t<
+		(Max <= 0xff),
+		mm::u8,
+		mm::condition_t<
+			(Max <= 0xffff),
+			mm::u16,
+			mm::condition_t<(Max <= 0xffffffff),mm::u32,mm::u64>
+		>
+	>;
 }
 
 #endif
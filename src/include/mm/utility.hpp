@@ -60,6 +60,29 @@ namespace mm {
 		return detail::int_seq_max_impl<T,T(0),Ts...>::value;
 	}
 
+	namespace detail {
+		template <mm::size_t N,mm::size_t... Is>
+		struct make_integer_sequence_impl : make_integer_sequence_impl<N - 1,N - 1,Is...> {};
+
+		template <mm::size_t... Is>
+		struct make_integer_sequence_impl<0,Is...> {
+			template <class T>
+			using type = mm::integer_sequence<T,T(Is)...>;
+		};
+	}
+
+	template <class T,T N>
+	using make_integer_sequence = typename detail::make_integer_sequence_impl<mm::size_t(N)>::template type<T>;
+
+	template <mm::size_t... Is>
+	using index_sequence = mm::integer_sequence<mm::size_t,Is...>;
+
+	template <mm::size_t N>
+	using make_index_sequence = mm::make_integer_sequence<mm::size_t,N>;
+
+	template <class... Ts>
+	using index_sequence_for = mm::make_index_sequence<sizeof...(Ts)>;
+
 	template <class T> mm::remove_reference_t<T>&& move(T&& t) { return static_cast<mm::remove_reference_t<T>&&>(t); }
 	
 	template <class T> T&& forward(mm::remove_reference_t<T>& t) { return static_cast<T&&>(t); }
@@ -82,6 +105,67 @@ namespace mm {
 	template <class T> struct in_place_type_t { explicit in_place_type_t() = default; };
 	template <mm::size_t I> struct in_place_index_t { explicit in_place_index_t() = default; };
 
+	namespace detail {
+		// empty, non final types become a base so they take up no space
+		template <class T,mm::size_t I,bool = mm::is_empty<T>::value && !mm::is_final<T>::value>
+		class compressed_pair_element {
+		private:
+			T m_value;
+
+		public:
+			constexpr compressed_pair_element() : m_value() {}
+
+			template <class U>
+			constexpr compressed_pair_element(U&& value) : m_value(mm::forward<U>(value)) {}
+
+			T& get() { return m_value; }
+			const T& get() const { return m_value; }
+		};
+
+		template <class T,mm::size_t I>
+		class compressed_pair_element<T,I,true> : private T {
+		public:
+			constexpr compressed_pair_element() : T() {}
+
+			template <class U>
+			constexpr compressed_pair_element(U&& value) : T(mm::forward<U>(value)) {}
+
+			T& get() { return *this; }
+			const T& get() const { return *this; }
+		};
+	}
+
+	// pair that stores empty members (stateless deleters and allocators) for free
+	template <class T1,class T2>
+	class compressed_pair : private detail::compressed_pair_element<T1,0>, private detail::compressed_pair_element<T2,1> {
+	private:
+		using first_base = detail::compressed_pair_element<T1,0>;
+		using second_base = detail::compressed_pair_element<T2,1>;
+
+	public:
+		using first_type = T1;
+		using second_type = T2;
+
+		constexpr compressed_pair() : first_base(), second_base() {}
+
+		template <class U1>
+		explicit constexpr compressed_pair(U1&& first) : first_base(mm::forward<U1>(first)), second_base() {}
+
+		template <class U1,class U2>
+		constexpr compressed_pair(U1&& first,U2&& second) : first_base(mm::forward<U1>(first)), second_base(mm::forward<U2>(second)) {}
+
+		first_type& first() { return first_base::get(); }
+		const first_type& first() const { return first_base::get(); }
+
+		second_type& second() { return second_base::get(); }
+		const second_type& second() const { return second_base::get(); }
+
+		void swap(compressed_pair& other) {
+			mm::swap(first(),other.first());
+			mm::swap(second(),other.second());
+		}
+	};
+
 }
 
 #endif
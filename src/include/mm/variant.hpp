@@ -0,0 +1,480 @@
+#ifndef MM_VARIANT_HPP
+#define MM_VARIANT_HPP
+#include "mm/memory.hpp"
+#include "mm/functional.hpp"
+#include "mm/error.hpp"
+
+namespace mm {
+	template <class... Ts> class variant;
+
+	template <class T> struct variant_size;
+	template <class... Ts> struct variant_size< mm::variant<Ts...> > : mm::integral_constant<mm::size_t,sizeof...(Ts)> {};
+	template <class T> struct variant_size<const T> : mm::variant_size<T> {};
+
+	template <mm::size_t I,class T> struct variant_alternative;
+	template <mm::size_t I,class T,class... Ts> struct variant_alternative< I,mm::variant<T,Ts...> > : mm::variant_alternative< I - 1,mm::variant<Ts...> > {};
+	template <class T,class... Ts> struct variant_alternative< 0,mm::variant<T,Ts...> > : mm::type_identity<T> {};
+	template <mm::size_t I,class T> struct variant_alternative<I,const T> : mm::type_identity< const typename mm::variant_alternative<I,T>::type > {};
+	template <mm::size_t I,class T> using variant_alternative_t = typename mm::variant_alternative<I,T>::type;
+
+	// an empty alternative, for variants that need a default state
+	struct monostate {};
+
+	constexpr bool operator==(mm::monostate,mm::monostate) { return true; }
+	constexpr bool operator!=(mm::monostate,mm::monostate) { return false; }
+	constexpr bool operator<(mm::monostate,mm::monostate) { return false; }
+
+	namespace detail {
+		// position of T in Ts, sizeof...(Ts) when it is not there
+		template <class T,class... Ts> struct variant_index_of : mm::integral_constant<mm::size_t,0> {};
+		template <class T,class U,class... Ts> struct variant_index_of<T,U,Ts...> : mm::integral_constant<mm::size_t,
+			mm::is_same<T,U>::value ? 0 : 1 + variant_index_of<T,Ts...>::value
+		> {};
+
+		template <class T,class... Ts> struct variant_count_of : mm::integral_constant<mm::size_t,0> {};
+		template <class T,class U,class... Ts> struct variant_count_of<T,U,Ts...> : mm::integral_constant<mm::size_t,
+			(mm::is_same<T,U>::value ? 1 : 0) + variant_count_of<T,Ts...>::value
+		> {};
+
+		template <mm::size_t N>
+		using variant_index_t = mm::smallest_unsigned_t<N>;
+
+		// one test() overload per alternative, overload resolution on the
+		// argument picks the alternative a converting constructor builds
+		template <mm::size_t I,class... Ts>
+		struct variant_overload {
+			static void test();
+		};
+
+		template <mm::size_t I,class T,class... Ts>
+		struct variant_overload<I,T,Ts...> : variant_overload<I + 1,Ts...> {
+			using variant_overload<I + 1,Ts...>::test;
+			static mm::integral_constant<mm::size_t,I> test(T);
+		};
+
+		template <class U,class... Ts>
+		using variant_accepted_index = decltype(variant_overload<0,Ts...>::test(mm::declval<U>()));
+
+		// type erased per alternative operations, the tables are indexed by the
+		// active index and are only instantiated by the operations that use them
+		template <class... Ts>
+		struct variant_ops {
+			template <class T> static void destroy(void* p) { mm::destroy_at(static_cast<T*>(p)); }
+			template <class T> static void copy(void* dst,const void* src) { mm::construct_at(static_cast<T*>(dst),*static_cast<const T*>(src)); }
+			template <class T> static void move(void* dst,void* src) { mm::construct_at(static_cast<T*>(dst),mm::move(*static_cast<T*>(src))); }
+			template <class T> static void copy_assign(void* dst,const void* src) { *static_cast<T*>(dst) = *static_cast<const T*>(src); }
+			template <class T> static void move_assign(void* dst,void* src) { *static_cast<T*>(dst) = mm::move(*static_cast<T*>(src)); }
+			template <class T> static bool equal(const void* lhs,const void* rhs) { return *static_cast<const T*>(lhs) == *static_cast<const T*>(rhs); }
+			template <class T> static bool less(const void* lhs,const void* rhs) { return *static_cast<const T*>(lhs) < *static_cast<const T*>(rhs); }
+
+			static void destroy(mm::size_t index,void* p) {
+				static constexpr void (*table[])(void*) = { &variant_ops::destroy<Ts>... };
+				table[index](p);
+			}
+
+			static void copy(mm::size_t index,void* dst,const void* src) {
+				static constexpr void (*table[])(void*,const void*) = { &variant_ops::copy<Ts>... };
+				table[index](dst,src);
+			}
+
+			static void move(mm::size_t index,void* dst,void* src) {
+				static constexpr void (*table[])(void*,void*) = { &variant_ops::move<Ts>... };
+				table[index](dst,src);
+			}
+
+			static void copy_assign(mm::size_t index,void* dst,const void* src) {
+				static constexpr void (*table[])(void*,const void*) = { &variant_ops::copy_assign<Ts>... };
+				table[index](dst,src);
+			}
+
+			static void move_assign(mm::size_t index,void* dst,void* src) {
+				static constexpr void (*table[])(void*,void*) = { &variant_ops::move_assign<Ts>... };
+				table[index](dst,src);
+			}
+
+			static bool equal(mm::size_t index,const void* lhs,const void* rhs) {
+				static constexpr bool (*table[])(const void*,const void*) = { &variant_ops::equal<Ts>... };
+				return table[index](lhs,rhs);
+			}
+
+			static bool less(mm::size_t index,const void* lhs,const void* rhs) {
+				static constexpr bool (*table[])(const void*,const void*) = { &variant_ops::less<Ts>... };
+				return table[index](lhs,rhs);
+			}
+		};
+
+		template <bool,class... Ts>
+		struct variant_storage {
+			mm::aligned_union_t<0,Ts...> m_data;
+			detail::variant_index_t<sizeof...(Ts)> m_index;
+
+			void destroy() {}
+		};
+
+		template <class... Ts>
+		struct variant_storage<false,Ts...> {
+			mm::aligned_union_t<0,Ts...> m_data;
+			detail::variant_index_t<sizeof...(Ts)> m_index;
+
+			variant_storage() = default;
+			variant_storage(const variant_storage&) = default;
+			variant_storage& operator=(const variant_storage&) = default;
+
+			~variant_storage() {
+				destroy();
+			}
+
+			void destroy() {
+				detail::variant_ops<Ts...>::destroy(m_index,&m_data);
+			}
+		};
+
+		template <class... Ts>
+		struct variant_all_trivially_destructible : mm::true_t {};
+
+		template <class T,class... Ts>
+		struct variant_all_trivially_destructible<T,Ts...> : mm::integral_constant<bool,
+			mm::is_trivially_destructible<T>::value && variant_all_trivially_destructible<Ts...>::value
+		> {};
+
+		template <class... Ts>
+		struct variant_all_trivially_copyable : mm::true_t {};
+
+		template <class T,class... Ts>
+		struct variant_all_trivially_copyable<T,Ts...> : mm::integral_constant<bool,
+			mm::is_trivially_copy_constructible<T>::value
+		     && mm::is_trivially_copy_assignable<T>::value
+		     && mm::is_trivially_destructible<T>::value
+		     && variant_all_trivially_copyable<Ts...>::value
+		> {};
+
+		template <class... Ts>
+		using variant_storage_for = detail::variant_storage<detail::variant_all_trivially_destructible<Ts...>::value,Ts...>;
+
+		// trivially copyable alternatives keep the implicit byte copies
+		template <bool,class... Ts>
+		struct variant_copy_base : detail::variant_storage_for<Ts...> {};
+
+		template <class... Ts>
+		struct variant_copy_base<false,Ts...> : detail::variant_storage_for<Ts...> {
+			using ops = detail::variant_ops<Ts...>;
+
+			variant_copy_base() = default;
+
+			variant_copy_base(const variant_copy_base& other) {
+				ops::copy(other.m_index,&this->m_data,&other.m_data);
+				this->m_index = other.m_index;
+			}
+
+			variant_copy_base(variant_copy_base&& other) {
+				ops::move(other.m_index,&this->m_data,&other.m_data);
+				this->m_index = other.m_index;
+			}
+
+			variant_copy_base& operator=(const variant_copy_base& other) {
+				if (this->m_index == other.m_index) {
+					ops::copy_assign(other.m_index,&this->m_data,&other.m_data);
+				} else {
+					this->destroy();
+					ops::copy(other.m_index,&this->m_data,&other.m_data);
+					this->m_index = other.m_index;
+				}
+
+				return *this;
+			}
+
+			variant_copy_base& operator=(variant_copy_base&& other) {
+				if (this->m_index == other.m_index) {
+					ops::move_assign(other.m_index,&this->m_data,&other.m_data);
+				} else {
+					this->destroy();
+					ops::move(other.m_index,&this->m_data,&other.m_data);
+					this->m_index = other.m_index;
+				}
+
+				return *this;
+			}
+		};
+
+		template <class... Ts>
+		using variant_base = detail::variant_copy_base<detail::variant_all_trivially_copyable<Ts...>::value,Ts...>;
+
+		// unchecked access for get and visit
+		struct variant_access {
+			template <mm::size_t I,class... Ts>
+			static mm::variant_alternative_t<I,mm::variant<Ts...>>& get(mm::variant<Ts...>& v) {
+				return *reinterpret_cast<mm::variant_alternative_t<I,mm::variant<Ts...>>*>(&v.m_data);
+			}
+
+			template <mm::size_t I,class... Ts>
+			static const mm::variant_alternative_t<I,mm::variant<Ts...>>& get(const mm::variant<Ts...>& v) {
+				return *reinterpret_cast<const mm::variant_alternative_t<I,mm::variant<Ts...>>*>(&v.m_data);
+			}
+
+			template <mm::size_t I,class... Ts>
+			static mm::variant_alternative_t<I,mm::variant<Ts...>>&& get(mm::variant<Ts...>&& v) {
+				return mm::move(*reinterpret_cast<mm::variant_alternative_t<I,mm::variant<Ts...>>*>(&v.m_data));
+			}
+
+			template <class... Ts>
+			static const void* data(const mm::variant<Ts...>& v) {
+				return &v.m_data;
+			}
+		};
+
+		inline void variant_bad_access() {
+			ERROR(mm::ERROR_BAD_VARIANT_ACCESS,"%s",mm::error_msg[mm::ERROR_BAD_VARIANT_ACCESS]);
+		}
+	}
+
+	// tagged union that never becomes valueless, the library is built without
+	// exceptions so an alternative's constructor cannot fail half way. the
+	// index is the smallest unsigned type that fits, and a variant of trivially
+	// copyable alternatives is trivially copyable itself
+	template <class... Ts>
+	class variant : private detail::variant_base<Ts...> {
+	private:
+		using base = detail::variant_base<Ts...>;
+
+		friend struct detail::variant_access;
+
+		STATIC_ASSERT(sizeof...(Ts) > 0,"variant needs at least one alternative");
+
+		template <mm::size_t I,class... Args>
+		void construct(Args&&... args) {
+			using type = mm::variant_alternative_t<I,variant>;
+
+			mm::construct_at(reinterpret_cast<type*>(&this->m_data),mm::forward<Args>(args)...);
+			this->m_index = static_cast<detail::variant_index_t<sizeof...(Ts)>>(I);
+		}
+
+	public:
+		template <class T = mm::variant_alternative_t<0,variant>,mm::enable_if_t<
+			mm::is_default_constructible<T>::value
+		> = nullptr>
+		variant() {
+			construct<0>();
+		}
+
+		variant(const variant&) = default;
+		variant(variant&&) = default;
+
+		template <class U,class I = detail::variant_accepted_index<U&&,Ts...>,mm::enable_if_t<
+			!mm::is_same<mm::remove_cvref_t<U>,variant>::value
+		> = nullptr>
+		variant(U&& value) {
+			construct<I::value>(mm::forward<U>(value));
+		}
+
+		template <mm::size_t I,class... Args>
+		explicit variant(mm::in_place_index_t<I>,Args&&... args) {
+			construct<I>(mm::forward<Args>(args)...);
+		}
+
+		template <class T,class... Args>
+		explicit variant(mm::in_place_type_t<T>,Args&&... args) {
+			STATIC_ASSERT((detail::variant_count_of<T,Ts...>::value == 1),"the type must occur exactly once in the variant");
+			construct<detail::variant_index_of<T,Ts...>::value>(mm::forward<Args>(args)...);
+		}
+
+		variant& operator=(const variant&) = default;
+		variant& operator=(variant&&) = default;
+
+		template <class U,class I = detail::variant_accepted_index<U&&,Ts...>,mm::enable_if_t<
+			!mm::is_same<mm::remove_cvref_t<U>,variant>::value
+		> = nullptr>
+		variant& operator=(U&& value) {
+			if (index() == I::value) {
+				detail::variant_access::get<I::value>(*this) = mm::forward<U>(value);
+			} else {
+				emplace<I::value>(mm::forward<U>(value));
+			}
+
+			return *this;
+		}
+
+		template <mm::size_t I,class... Args>
+		mm::variant_alternative_t<I,variant>& emplace(Args&&... args) {
+			this->destroy();
+			construct<I>(mm::forward<Args>(args)...);
+			return detail::variant_access::get<I>(*this);
+		}
+
+		template <class T,class... Args>
+		T& emplace(Args&&... args) {
+			STATIC_ASSERT((detail::variant_count_of<T,Ts...>::value == 1),"the type must occur exactly once in the variant");
+			return emplace<detail::variant_index_of<T,Ts...>::value>(mm::forward<Args>(args)...);
+		}
+
+		mm::size_t index() const {
+			return this->m_index;
+		}
+
+		constexpr bool valueless_by_exception() const {
+			return false;
+		}
+
+		void swap(variant& other) {
+			variant tmp(mm::move(other));
+			other = mm::move(*this);
+			*this = mm::move(tmp);
+		}
+	};
+
+	template <class T,class... Ts>
+	bool holds_alternative(const mm::variant<Ts...>& v) {
+		STATIC_ASSERT((detail::variant_count_of<T,Ts...>::value == 1),"the type must occur exactly once in the variant");
+		return v.index() == detail::variant_index_of<T,Ts...>::value;
+	}
+
+	template <mm::size_t I,class... Ts>
+	mm::variant_alternative_t<I,mm::variant<Ts...>>& get(mm::variant<Ts...>& v) {
+		if (v.index() != I) {
+			detail::variant_bad_access();
+		}
+
+		return detail::variant_access::get<I>(v);
+	}
+
+	template <mm::size_t I,class... Ts>
+	const mm::variant_alternative_t<I,mm::variant<Ts...>>& get(const mm::variant<Ts...>& v) {
+		if (v.index() != I) {
+			detail::variant_bad_access();
+		}
+
+		return detail::variant_access::get<I>(v);
+	}
+
+	template <mm::size_t I,class... Ts>
+	mm::variant_alternative_t<I,mm::variant<Ts...>>&& get(mm::variant<Ts...>&& v) {
+		if (v.index() != I) {
+			detail::variant_bad_access();
+		}
+
+		return detail::variant_access::get<I>(mm::move(v));
+	}
+
+	template <class T,class... Ts>
+	T& get(mm::variant<Ts...>& v) {
+		STATIC_ASSERT((detail::variant_count_of<T,Ts...>::value == 1),"the type must occur exactly once in the variant");
+		return mm::get<detail::variant_index_of<T,Ts...>::value>(v);
+	}
+
+	template <class T,class... Ts>
+	const T& get(const mm::variant<Ts...>& v) {
+		STATIC_ASSERT((detail::variant_count_of<T,Ts...>::value == 1),"the type must occur exactly once in the variant");
+		return mm::get<detail::variant_index_of<T,Ts...>::value>(v);
+	}
+
+	template <class T,class... Ts>
+	T&& get(mm::variant<Ts...>&& v) {
+		STATIC_ASSERT((detail::variant_count_of<T,Ts...>::value == 1),"the type must occur exactly once in the variant");
+		return mm::get<detail::variant_index_of<T,Ts...>::value>(mm::move(v));
+	}
+
+	template <mm::size_t I,class... Ts>
+	mm::variant_alternative_t<I,mm::variant<Ts...>>* get_if(mm::variant<Ts...>* v) {
+		return v && v->index() == I ? mm::address_of(detail::variant_access::get<I>(*v)) : nullptr;
+	}
+
+	template <mm::size_t I,class... Ts>
+	const mm::variant_alternative_t<I,mm::variant<Ts...>>* get_if(const mm::variant<Ts...>* v) {
+		return v && v->index() == I ? mm::address_of(detail::variant_access::get<I>(*v)) : nullptr;
+	}
+
+	template <class T,class... Ts>
+	T* get_if(mm::variant<Ts...>* v) {
+		STATIC_ASSERT((detail::variant_count_of<T,Ts...>::value == 1),"the type must occur exactly once in the variant");
+		return mm::get_if<detail::variant_index_of<T,Ts...>::value>(v);
+	}
+
+	template <class T,class... Ts>
+	const T* get_if(const mm::variant<Ts...>* v) {
+		STATIC_ASSERT((detail::variant_count_of<T,Ts...>::value == 1),"the type must occur exactly once in the variant");
+		return mm::get_if<detail::variant_index_of<T,Ts...>::value>(v);
+	}
+
+	namespace detail {
+		template <class F,class V,class Seq>
+		struct variant_visit_table;
+
+		// one dispatch function per alternative, called through a table indexed
+		// by the active index. every alternative must give the same result type
+		template <class F,class V,mm::size_t... Is>
+		struct variant_visit_table< F,V,mm::index_sequence<Is...> > {
+			using result_type = mm::invoke_result_t<F,decltype(detail::variant_access::get<0>(mm::declval<V>()))>;
+			using dispatch_type = result_type(*)(F&&,V&&);
+
+			template <mm::size_t I>
+			static result_type dispatch(F&& f,V&& v) {
+				return mm::invoke(mm::forward<F>(f),detail::variant_access::get<I>(mm::forward<V>(v)));
+			}
+
+			static result_type visit(F&& f,V&& v) {
+				static constexpr dispatch_type table[] = { &variant_visit_table::dispatch<Is>... };
+				return table[v.index()](mm::forward<F>(f),mm::forward<V>(v));
+			}
+		};
+
+		template <class F,class V>
+		using variant_visit_for = detail::variant_visit_table<
+			F,
+			V,
+			mm::make_index_sequence< mm::variant_size< mm::remove_reference_t<V> >::value >
+		>;
+	}
+
+	template <class F,class V>
+	typename detail::variant_visit_for<F,V>::result_type visit(F&& f,V&& v) {
+		return detail::variant_visit_for<F,V>::visit(mm::forward<F>(f),mm::forward<V>(v));
+	}
+
+	template <class... Ts>
+	bool operator==(const mm::variant<Ts...>& lhs,const mm::variant<Ts...>& rhs) {
+		return lhs.index() == rhs.index() && detail::variant_ops<Ts...>::equal(
+			lhs.index(),
+			detail::variant_access::data(lhs),
+			detail::variant_access::data(rhs)
+		);
+	}
+
+	template <class... Ts>
+	bool operator!=(const mm::variant<Ts...>& lhs,const mm::variant<Ts...>& rhs) {
+		return !(lhs == rhs);
+	}
+
+	template <class... Ts>
+	bool operator<(const mm::variant<Ts...>& lhs,const mm::variant<Ts...>& rhs) {
+		if (lhs.index() != rhs.index()) {
+			return lhs.index() < rhs.index();
+		}
+
+		return detail::variant_ops<Ts...>::less(
+			lhs.index(),
+			detail::variant_access::data(lhs),
+			detail::variant_access::data(rhs)
+		);
+	}
+
+	template <class... Ts>
+	bool operator>(const mm::variant<Ts...>& lhs,const mm::variant<Ts...>& rhs) {
+		return rhs < lhs;
+	}
+
+	template <class... Ts>
+	bool operator<=(const mm::variant<Ts...>& lhs,const mm::variant<Ts...>& rhs) {
+		return !(rhs < lhs);
+	}
+
+	template <class... Ts>
+	bool operator>=(const mm::variant<Ts...>& lhs,const mm::variant<Ts...>& rhs) {
+		return !(lhs < rhs);
+	}
+
+	template <class... Ts>
+	void swap(mm::variant<Ts...>& lhs,mm::variant<Ts...>& rhs) {
+		lhs.swap(rhs);
+	}
+}
+
+#endif
@@ -0,0 +1,606 @@
+#ifndef MM_VIEWS_HPP
+#define MM_VIEWS_HPP
+#include "mm/iterator.hpp"
+#include "mm/functional.hpp"
+#include "mm/limits.hpp"
+
+// lazy, non owning range adaptors. a view holds iterators or a pointer to the
+// range it was built from, never the elements, and produces them one at a time
+// as it is iterated, so chained stages do not materialise anything:
+//
+//	for (int v : values | mm::views::filter(is_even) | mm::views::transform(square) | mm::views::take(4))
+//
+// adaptors keep the strongest category they can, transform, drop and take of a
+// random access range stay random access, filter is at most bidirectional.
+// iterators of transform and filter point back into their view, so a view
+// must outlive its iterators and must not be moved while being iterated
+
+namespace mm {
+	// views derive from this, anything else passed to an adaptor is wrapped in
+	// a ref_view, which requires an lvalue so the range outlives the view
+	struct view_base {};
+
+	template <class T> struct is_view : mm::is_base_of<mm::view_base,T> {};
+
+	namespace detail {
+		template <class R> using range_iterator_t = decltype(mm::declval<R&>().begin());
+		template <class Iter> using iter_reference_t = decltype(*mm::declval<Iter&>());
+		template <class Iter> using iter_difference_t = typename mm::iterator_traits<Iter>::difference_type;
+		template <class Iter> using iter_category_t = typename mm::iterator_traits<Iter>::iterator_category;
+
+		template <class Iter>
+		struct is_random_access_iterator : mm::is_base_of<mm::random_access_iterator_tag,detail::iter_category_t<Iter>> {};
+
+		// the weaker of Category and Cap
+		template <class Category,class Cap>
+		using cap_category = mm::condition_t<mm::is_base_of<Cap,Category>::value,Cap,Category>;
+
+		// the weakest category in Categories
+		template <class... Categories> struct common_category;
+		template <class C> struct common_category<C> : mm::type_identity<C> {};
+		template <class C1,class C2,class... Cs> struct common_category<C1,C2,Cs...> : common_category<
+			mm::condition_t<mm::is_base_of<C1,C2>::value,C1,C2>,
+			Cs...
+		> {};
+	}
+
+	template <class R>
+	class ref_view : public mm::view_base {
+	private:
+		R* m_range;
+
+	public:
+		using iterator = detail::range_iterator_t<R>;
+
+		ref_view(R& r) : m_range(mm::address_of(r)) {}
+
+		iterator begin() const { return m_range->begin(); }
+		iterator end() const { return m_range->end(); }
+	};
+
+	template <class T,mm::size_t N>
+	class ref_view<T[N]> : public mm::view_base {
+	private:
+		T* m_data;
+
+	public:
+		using iterator = T*;
+
+		ref_view(T (&array)[N]) : m_data(array) {}
+
+		iterator begin() const { return m_data; }
+		iterator end() const { return m_data + N; }
+	};
+
+	// a pair of iterators as a view
+	template <class Iter>
+	class subrange : public mm::view_base {
+	private:
+		Iter m_first;
+		Iter m_last;
+
+	public:
+		using iterator = Iter;
+
+		subrange(Iter first,Iter last) : m_first(first), m_last(last) {}
+
+		iterator begin() const { return m_first; }
+		iterator end() const { return m_last; }
+	};
+
+	template <class T>
+	class iota_view : public mm::view_base {
+	public:
+		class iterator {
+		public:
+			using difference_type = mm::ptrdiff_t;
+			using value_type = T;
+			using pointer = void;
+			using reference = T;
+			using iterator_category = mm::random_access_iterator_tag;
+
+		private:
+			T m_value;
+
+		public:
+			iterator() : m_value() {}
+			explicit iterator(T value) : m_value(value) {}
+
+			T operator*() const { return m_value; }
+			T operator[](difference_type n) const { return static_cast<T>(m_value + n); }
+
+			iterator& operator++() { ++m_value; return *this; }
+			iterator& operator--() { --m_value; return *this; }
+			iterator operator++(int) { iterator tmp(*this); ++m_value; return tmp; }
+			iterator operator--(int) { iterator tmp(*this); --m_value; return tmp; }
+			iterator& operator+=(difference_type n) { m_value = static_cast<T>(m_value + n); return *this; }
+			iterator& operator-=(difference_type n) { m_value = static_cast<T>(m_value - n); return *this; }
+			iterator operator+(difference_type n) const { return iterator(static_cast<T>(m_value + n)); }
+			iterator operator-(difference_type n) const { return iterator(static_cast<T>(m_value - n)); }
+
+			difference_type operator-(const iterator& other) const {
+				return static_cast<difference_type>(m_value) - static_cast<difference_type>(other.m_value);
+			}
+
+			bool operator==(const iterator& other) const { return m_value == other.m_value; }
+			bool operator!=(const iterator& other) const { return m_value != other.m_value; }
+			bool operator<(const iterator& other) const { return m_value < other.m_value; }
+			bool operator>(const iterator& other) const { return m_value > other.m_value; }
+			bool operator<=(const iterator& other) const { return m_value <= other.m_value; }
+			bool operator>=(const iterator& other) const { return m_value >= other.m_value; }
+		};
+
+	private:
+		T m_first;
+		T m_last;
+
+	public:
+		iota_view(T first,T last) : m_first(first), m_last(last) {}
+
+		iterator begin() const { return iterator(m_first); }
+		iterator end() const { return iterator(m_last); }
+		mm::size_t size() const { return static_cast<mm::size_t>(m_last - m_first); }
+	};
+
+	namespace detail {
+		template <class R>
+		using all_t = mm::condition_t<
+			mm::is_view<mm::remove_cvref_t<R>>::value,
+			mm::remove_cvref_t<R>,
+			mm::ref_view<mm::remove_reference_t<R>>
+		>;
+	}
+
+	template <class V,class F>
+	class transform_view : public mm::view_base {
+	private:
+		using base_iterator = detail::range_iterator_t<const V>;
+
+		mm::compressed_pair<V,F> m_pair;
+
+	public:
+		class iterator {
+		public:
+			using difference_type = detail::iter_difference_t<base_iterator>;
+			using reference = mm::invoke_result_t<const F&,detail::iter_reference_t<base_iterator>>;
+			using value_type = mm::remove_cvref_t<reference>;
+			using pointer = void;
+			using iterator_category = detail::cap_category<detail::iter_category_t<base_iterator>,mm::random_access_iterator_tag>;
+
+		private:
+			base_iterator m_current;
+			const F* m_fn;
+
+		public:
+			iterator() : m_current(), m_fn(nullptr) {}
+			iterator(base_iterator current,const F* fn) : m_current(current), m_fn(fn) {}
+
+			base_iterator base() const { return m_current; }
+
+			reference operator*() const { return mm::invoke(*m_fn,*m_current); }
+			reference operator[](difference_type n) const { return mm::invoke(*m_fn,m_current[n]); }
+
+			iterator& operator++() { ++m_current; return *this; }
+			iterator& operator--() { --m_current; return *this; }
+			iterator operator++(int) { iterator tmp(*this); ++m_current; return tmp; }
+			iterator operator--(int) { iterator tmp(*this); --m_current; return tmp; }
+			iterator& operator+=(difference_type n) { m_current += n; return *this; }
+			iterator& operator-=(difference_type n) { m_current -= n; return *this; }
+			iterator operator+(difference_type n) const { return iterator(m_current + n,m_fn); }
+			iterator operator-(difference_type n) const { return iterator(m_current - n,m_fn); }
+			difference_type operator-(const iterator& other) const { return m_current - other.m_current; }
+
+			bool operator==(const iterator& other) const { return m_current == other.m_current; }
+			bool operator!=(const iterator& other) const { return m_current != other.m_current; }
+			bool operator<(const iterator& other) const { return m_current < other.m_current; }
+			bool operator>(const iterator& other) const { return m_current > other.m_current; }
+			bool operator<=(const iterator& other) const { return m_current <= other.m_current; }
+			bool operator>=(const iterator& other) const { return m_current >= other.m_current; }
+		};
+
+		transform_view(V base,F fn) : m_pair(mm::move(base),mm::move(fn)) {}
+
+		iterator begin() const { return iterator(m_pair.first().begin(),mm::address_of(m_pair.second())); }
+		iterator end() const { return iterator(m_pair.first().end(),mm::address_of(m_pair.second())); }
+	};
+
+	template <class V,class Pred>
+	class filter_view : public mm::view_base {
+	private:
+		using base_iterator = detail::range_iterator_t<const V>;
+
+		mm::compressed_pair<V,Pred> m_pair;
+
+	public:
+		// decrementing assumes a match exists before the current position,
+		// which holds for any iterator that is not begin()
+		class iterator {
+		public:
+			using difference_type = detail::iter_difference_t<base_iterator>;
+			using reference = detail::iter_reference_t<base_iterator>;
+			using value_type = typename mm::iterator_traits<base_iterator>::value_type;
+			using pointer = typename mm::iterator_traits<base_iterator>::pointer;
+			using iterator_category = detail::cap_category<detail::iter_category_t<base_iterator>,mm::bidirectional_iterator_tag>;
+
+		private:
+			base_iterator m_current;
+			base_iterator m_end;
+			const Pred* m_pred;
+
+			void satisfy() {
+				while (m_current != m_end && !mm::invoke(*m_pred,*m_current)) {
+					++m_current;
+				}
+			}
+
+		public:
+			iterator() : m_current(), m_end(), m_pred(nullptr) {}
+
+			iterator(base_iterator current,base_iterator end,const Pred* pred) : m_current(current), m_end(end), m_pred(pred) {
+				satisfy();
+			}
+
+			base_iterator base() const { return m_current; }
+
+			reference operator*() const { return *m_current; }
+
+			iterator& operator++() {
+				++m_current;
+				satisfy();
+				return *this;
+			}
+
+			iterator& operator--() {
+				do {
+					--m_current;
+				} while (!mm::invoke(*m_pred,*m_current));
+
+				return *this;
+			}
+
+			iterator operator++(int) { iterator tmp(*this); ++*this; return tmp; }
+			iterator operator--(int) { iterator tmp(*this); --*this; return tmp; }
+
+			bool operator==(const iterator& other) const { return m_current == other.m_current; }
+			bool operator!=(const iterator& other) const { return m_current != other.m_current; }
+		};
+
+		filter_view(V base,Pred pred) : m_pair(mm::move(base),mm::move(pred)) {}
+
+		iterator begin() const { return iterator(m_pair.first().begin(),m_pair.first().end(),mm::address_of(m_pair.second())); }
+		iterator end() const { return iterator(m_pair.first().end(),m_pair.first().end(),mm::address_of(m_pair.second())); }
+	};
+
+	namespace detail {
+		// counts down alongside a forward iterator, either reaching zero or
+		// reaching the end of the underlying range makes it compare equal to end
+		template <class Iter>
+		class counted_iterator {
+		public:
+			using difference_type = detail::iter_difference_t<Iter>;
+			using reference = detail::iter_reference_t<Iter>;
+			using value_type = typename mm::iterator_traits<Iter>::value_type;
+			using pointer = typename mm::iterator_traits<Iter>::pointer;
+			using iterator_category = detail::cap_category<detail::iter_category_t<Iter>,mm::forward_iterator_tag>;
+
+		private:
+			Iter m_current;
+			difference_type m_remaining;
+
+		public:
+			counted_iterator() : m_current(), m_remaining(0) {}
+			counted_iterator(Iter current,difference_type remaining) : m_current(current), m_remaining(remaining) {}
+
+			Iter base() const { return m_current; }
+
+			reference operator*() const { return *m_current; }
+
+			counted_iterator& operator++() {
+				++m_current;
+				--m_remaining;
+				return *this;
+			}
+
+			counted_iterator operator++(int) { counted_iterator tmp(*this); ++*this; return tmp; }
+
+			bool operator==(const counted_iterator& other) const { return m_remaining == other.m_remaining || m_current == other.m_current; }
+			bool operator!=(const counted_iterator& other) const { return !(*this == other); }
+		};
+
+		// advances at most n, in constant time for random access
+		template <class Iter>
+		Iter bounded_next(Iter first,Iter last,detail::iter_difference_t<Iter> n,mm::input_iterator_tag) {
+			for (; n > 0 && first != last; --n) {
+				++first;
+			}
+
+			return first;
+		}
+
+		template <class Iter>
+		Iter bounded_next(Iter first,Iter last,detail::iter_difference_t<Iter> n,mm::random_access_iterator_tag) {
+			return last - first < n ? last : first + n;
+		}
+
+		template <class Iter>
+		Iter bounded_next(Iter first,Iter last,detail::iter_difference_t<Iter> n) {
+			return detail::bounded_next(first,last,n,detail::iter_category_t<Iter>());
+		}
+	}
+
+	// random access ranges are cut with plain iterators, anything weaker is
+	// counted down as it is walked
+	template <class V>
+	class take_view : public mm::view_base {
+	private:
+		using base_iterator = detail::range_iterator_t<const V>;
+		using difference_type = detail::iter_difference_t<base_iterator>;
+
+		V m_base;
+		difference_type m_count;
+
+		base_iterator begin_impl(mm::true_t) const { return m_base.begin(); }
+		base_iterator end_impl(mm::true_t) const { return detail::bounded_next(m_base.begin(),m_base.end(),m_count); }
+
+		detail::counted_iterator<base_iterator> begin_impl(mm::false_t) const {
+			return detail::counted_iterator<base_iterator>(m_base.begin(),m_count);
+		}
+
+		detail::counted_iterator<base_iterator> end_impl(mm::false_t) const {
+			return detail::counted_iterator<base_iterator>(m_base.end(),0);
+		}
+
+	public:
+		using iterator = mm::condition_t<
+			detail::is_random_access_iterator<base_iterator>::value,
+			base_iterator,
+			detail::counted_iterator<base_iterator>
+		>;
+
+		take_view(V base,difference_type count) : m_base(mm::move(base)), m_count(count) {}
+
+		iterator begin() const { return begin_impl(detail::is_random_access_iterator<base_iterator>()); }
+		iterator end() const { return end_impl(detail::is_random_access_iterator<base_iterator>()); }
+	};
+
+	template <class V>
+	class drop_view : public mm::view_base {
+	private:
+		using base_iterator = detail::range_iterator_t<const V>;
+		using difference_type = detail::iter_difference_t<base_iterator>;
+
+		V m_base;
+		difference_type m_count;
+
+	public:
+		using iterator = base_iterator;
+
+		drop_view(V base,difference_type count) : m_base(mm::move(base)), m_count(count) {}
+
+		iterator begin() const { return detail::bounded_next(m_base.begin(),m_base.end(),m_count); }
+		iterator end() const { return m_base.end(); }
+	};
+
+	template <class T1,class T2>
+	struct zip_reference {
+		T1 first;
+		T2 second;
+	};
+
+	// walks two ranges in step and stops at the end of the shorter one
+	template <class V1,class V2>
+	class zip_view : public mm::view_base {
+	private:
+		using first_iterator = detail::range_iterator_t<const V1>;
+		using second_iterator = detail::range_iterator_t<const V2>;
+
+		V1 m_first;
+		V2 m_second;
+
+	public:
+		class iterator {
+		public:
+			using difference_type = mm::ptrdiff_t;
+			using reference = mm::zip_reference<detail::iter_reference_t<first_iterator>,detail::iter_reference_t<second_iterator>>;
+			using value_type = reference;
+			using pointer = void;
+			using iterator_category = detail::cap_category<
+				typename detail::common_category<detail::iter_category_t<first_iterator>,detail::iter_category_t<second_iterator>>::type,
+				mm::random_access_iterator_tag
+			>;
+
+		private:
+			first_iterator m_first;
+			second_iterator m_second;
+
+		public:
+			iterator() : m_first(), m_second() {}
+			iterator(first_iterator first,second_iterator second) : m_first(first), m_second(second) {}
+
+			reference operator*() const { return reference{*m_first,*m_second}; }
+			reference operator[](difference_type n) const { return reference{m_first[n],m_second[n]}; }
+
+			iterator& operator++() { ++m_first; ++m_second; return *this; }
+			iterator& operator--() { --m_first; --m_second; return *this; }
+			iterator operator++(int) { iterator tmp(*this); ++*this; return tmp; }
+			iterator operator--(int) { iterator tmp(*this); --*this; return tmp; }
+			iterator& operator+=(difference_type n) { m_first += n; m_second += n; return *this; }
+			iterator& operator-=(difference_type n) { m_first -= n; m_second -= n; return *this; }
+			iterator operator+(difference_type n) const { return iterator(m_first + n,m_second + n); }
+			iterator operator-(difference_type n) const { return iterator(m_first - n,m_second - n); }
+			difference_type operator-(const iterator& other) const { return m_first - other.m_first; }
+
+			// either side reaching its end ends the zip
+			bool operator==(const iterator& other) const { return m_first == other.m_first || m_second == other.m_second; }
+			bool operator!=(const iterator& other) const { return !(*this == other); }
+			bool operator<(const iterator& other) const { return m_first < other.m_first; }
+			bool operator>(const iterator& other) const { return m_first > other.m_first; }
+			bool operator<=(const iterator& other) const { return m_first <= other.m_first; }
+			bool operator>=(const iterator& other) const { return m_first >= other.m_first; }
+		};
+
+	private:
+		iterator end_impl(mm::true_t) const {
+			mm::ptrdiff_t first_size = m_first.end() - m_first.begin();
+			mm::ptrdiff_t second_size = m_second.end() - m_second.begin();
+			mm::ptrdiff_t size = first_size < second_size ? first_size : second_size;
+			return iterator(m_first.begin() + size,m_second.begin() + size);
+		}
+
+		iterator end_impl(mm::false_t) const {
+			return iterator(m_first.end(),m_second.end());
+		}
+
+	public:
+		zip_view(V1 first,V2 second) : m_first(mm::move(first)), m_second(mm::move(second)) {}
+
+		iterator begin() const { return iterator(m_first.begin(),m_second.begin()); }
+
+		// random access ends at the shorter length so iterator differences agree
+		iterator end() const {
+			return end_impl(mm::is_base_of<mm::random_access_iterator_tag,typename iterator::iterator_category>());
+		}
+	};
+
+	namespace detail {
+		// the right hand side of range | adaptor
+		struct view_closure_base {};
+
+		template <class R,class Closure,mm::enable_if_t<
+			mm::is_base_of<detail::view_closure_base,mm::remove_cvref_t<Closure>>::value
+		> = nullptr>
+		auto operator|(R&& r,const Closure& closure) -> decltype(closure(mm::forward<R>(r))) {
+			return closure(mm::forward<R>(r));
+		}
+
+		template <class F>
+		struct transform_closure : detail::view_closure_base {
+			F m_fn;
+
+			explicit transform_closure(F fn) : m_fn(mm::move(fn)) {}
+
+			template <class R>
+			mm::transform_view<detail::all_t<R>,F> operator()(R&& r) const;
+		};
+
+		template <class Pred>
+		struct filter_closure : detail::view_closure_base {
+			Pred m_pred;
+
+			explicit filter_closure(Pred pred) : m_pred(mm::move(pred)) {}
+
+			template <class R>
+			mm::filter_view<detail::all_t<R>,Pred> operator()(R&& r) const;
+		};
+
+		struct take_closure : detail::view_closure_base {
+			mm::ptrdiff_t m_count;
+
+			explicit take_closure(mm::ptrdiff_t count) : m_count(count) {}
+
+			template <class R>
+			mm::take_view<detail::all_t<R>> operator()(R&& r) const;
+		};
+
+		struct drop_closure : detail::view_closure_base {
+			mm::ptrdiff_t m_count;
+
+			explicit drop_closure(mm::ptrdiff_t count) : m_count(count) {}
+
+			template <class R>
+			mm::drop_view<detail::all_t<R>> operator()(R&& r) const;
+		};
+	}
+
+	namespace views {
+		template <class R>
+		detail::all_t<R> all(R&& r) {
+			STATIC_ASSERT(
+				mm::is_view<mm::remove_cvref_t<R>>::value || mm::is_lvalue_reference<R>::value,
+				"views over a temporary container would dangle"
+			);
+
+			return detail::all_t<R>(mm::forward<R>(r));
+		}
+
+		template <class T>
+		mm::iota_view<T> iota(T first,T last) {
+			return mm::iota_view<T>(first,last);
+		}
+
+		// unbounded, in practice bounded by the largest T
+		template <class T>
+		mm::iota_view<T> iota(T first) {
+			return mm::iota_view<T>(first,mm::numeric_limits<T>::max);
+		}
+
+		template <class R,class F>
+		mm::transform_view<detail::all_t<R>,mm::decay_t<F>> transform(R&& r,F&& fn) {
+			return mm::transform_view<detail::all_t<R>,mm::decay_t<F>>(views::all(mm::forward<R>(r)),mm::forward<F>(fn));
+		}
+
+		template <class F>
+		detail::transform_closure<mm::decay_t<F>> transform(F&& fn) {
+			return detail::transform_closure<mm::decay_t<F>>(mm::forward<F>(fn));
+		}
+
+		template <class R,class Pred>
+		mm::filter_view<detail::all_t<R>,mm::decay_t<Pred>> filter(R&& r,Pred&& pred) {
+			return mm::filter_view<detail::all_t<R>,mm::decay_t<Pred>>(views::all(mm::forward<R>(r)),mm::forward<Pred>(pred));
+		}
+
+		template <class Pred>
+		detail::filter_closure<mm::decay_t<Pred>> filter(Pred&& pred) {
+			return detail::filter_closure<mm::decay_t<Pred>>(mm::forward<Pred>(pred));
+		}
+
+		template <class R>
+		mm::take_view<detail::all_t<R>> take(R&& r,mm::ptrdiff_t count) {
+			return mm::take_view<detail::all_t<R>>(views::all(mm::forward<R>(r)),count);
+		}
+
+		inline detail::take_closure take(mm::ptrdiff_t count) {
+			return detail::take_closure(count);
+		}
+
+		template <class R>
+		mm::drop_view<detail::all_t<R>> drop(R&& r,mm::ptrdiff_t count) {
+			return mm::drop_view<detail::all_t<R>>(views::all(mm::forward<R>(r)),count);
+		}
+
+		inline detail::drop_closure drop(mm::ptrdiff_t count) {
+			return detail::drop_closure(count);
+		}
+
+		template <class R1,class R2>
+		mm::zip_view<detail::all_t<R1>,detail::all_t<R2>> zip(R1&& r1,R2&& r2) {
+			return mm::zip_view<detail::all_t<R1>,detail::all_t<R2>>(views::all(mm::forward<R1>(r1)),views::all(mm::forward<R2>(r2)));
+		}
+	}
+
+	namespace detail {
+		template <class F>
+		template <class R>
+		mm::transform_view<detail::all_t<R>,F> transform_closure<F>::operator()(R&& r) const {
+			return mm::views::transform(mm::forward<R>(r),m_fn);
+		}
+
+		template <class Pred>
+		template <class R>
+		mm::filter_view<detail::all_t<R>,Pred> filter_closure<Pred>::operator()(R&& r) const {
+			return mm::views::filter(mm::forward<R>(r),m_pred);
+		}
+
+		template <class R>
+		mm::take_view<detail::all_t<R>> take_closure::operator()(R&& r) const {
+			return mm::views::take(mm::forward<R>(r),m_count);
+		}
+
+		template <class R>
+		mm::drop_view<detail::all_t<R>> drop_closure::operator()(R&& r) const {
+			return mm::views::drop(mm::forward<R>(r),m_count);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,173 @@
+#define ASYNC_LOGGING
+#define LOG_LEVEL LOG_LEVEL_PRINTF
+#include <string.h>
+#include <unistd.h>
+#include "mm/log.hpp"
+#include "mm/inline_vector.hpp"
+#include "mm/numa.hpp"
+#include "mm/span.hpp"
+
+// behaviour checks, one function per check, run by make test
+
+namespace {
+	// runs fn with stdout redirected into a temporary file and reads what it
+	// wrote back into buffer
+	template <class F>
+	bool capture_stdout(F fn,char* buffer,mm::size_t length) {
+		FILE* capture = tmpfile();
+
+		if (!capture) {
+			return false;
+		}
+
+		fflush(stdout);
+		int saved = dup(STDOUT_FILENO);
+		dup2(fileno(capture),STDOUT_FILENO);
+		fn();
+		fflush(stdout);
+		dup2(saved,STDOUT_FILENO);
+		close(saved);
+
+		rewind(capture);
+		mm::size_t read = fread(buffer,1,length - 1,capture);
+		buffer[read] = '\0';
+		fclose(capture);
+		return read > 0;
+	}
+
+	// a char* used to be sized as an 8 byte scalar but written as a string,
+	// so the next record overwrote the end of it
+	bool log_non_const_string() {
+		char text[] = "hello-world-from-a-buffer";
+		char* s = text;
+		char output[256];
+
+		auto log = [s,&text]() {
+			PRINTF("%s",s);
+			PRINTF("%s",text);
+			PRINTF("%d",42);
+			mm::log_flush();
+		};
+
+		return capture_stdout(log,output,sizeof(output)) && strcmp(output,"hello-world-from-a-buffer\nhello-world-from-a-buffer\n42\n") == 0;
+	}
+
+	// gcc -O2 used to fold the copy from the state before emplace shifted
+	bool inline_vector_copy_after_insert() {
+		mm::inline_vector<int,4> v;
+		v.push_back(1);
+		v.push_back(2);
+		v.emplace(v.begin(),0);
+
+		mm::inline_vector<int,4> w = v;
+		return w.size() == 3 && w[0] == 0 && w[1] == 1 && w[2] == 2;
+	}
+
+	// share() used to exit the process when copies were left
+	bool local_shared_ptr_share() {
+		mm::local_shared_ptr<int> a = mm::make_local_shared<int>(7);
+		mm::local_shared_ptr<int> b = a;
+
+		mm::expected<mm::shared_ptr<int>,mm::error> refused = mm::move(a).share();
+
+		if (refused || refused.error() != mm::ERROR_GENERAL || a.use_count() != 2) {
+			return false;
+		}
+
+		b = nullptr;
+		mm::expected<mm::shared_ptr<int>,mm::error> shared = mm::move(a).share();
+		return shared && **shared == 7 && shared->use_count() == 1 && !a;
+	}
+
+	// alignments past the size classes used to come back only page aligned
+	bool numa_large_alignment() {
+		mm::numa_resource resource;
+		mm::size_t alignment = mm::size_t(1) << 17;
+		void* p = resource.allocate(16,alignment);
+
+		if (!p || reinterpret_cast<uintptr_t>(p) % alignment) {
+			return false;
+		}
+
+		resource.deallocate(p,16,alignment);
+		return resource.allocate(16,mm::numa_chunk_size * 2) == nullptr;
+	}
+
+	bool alloc_counters_snapshot_reset() {
+		mm::alloc_counters counters {};
+		counters.on_allocate(100);
+		counters.on_allocate(3000);
+		counters.on_deallocate(100);
+
+		mm::alloc_stats stats = counters.snapshot();
+		mm::alloc_bucket_stats& small = stats.buckets[mm::detail::alloc_bucket(100)];
+
+		if (stats.allocations != 2 || stats.frees != 1 || stats.bytes_live != 3000 || stats.peak_bytes != 3100 || small.allocations != 1 || small.bytes_live != 0) {
+			return false;
+		}
+
+		counters.reset();
+		stats = counters.snapshot();
+		return stats.allocations == 0 && stats.peak_bytes == 0 && stats.buckets[mm::detail::alloc_bucket(3000)].allocations == 0;
+	}
+
+	// a mutable span of a temporary container would dangle straight away
+	STATIC_ASSERT((!mm::is_constructible<mm::span<int>,mm::inline_vector<int,4>&&>::value),"span<int> must not bind a temporary");
+	STATIC_ASSERT((!mm::is_constructible<mm::span<int>,const mm::inline_vector<int,4>&>::value),"span<int> must not bind a const container");
+
+	mm::inline_vector<int,4> span_source() {
+		mm::inline_vector<int,4> v;
+		v.push_back(1);
+		v.push_back(2);
+		return v;
+	}
+
+	int span_sum(mm::span<const int> s) {
+		int total = 0;
+
+		for (int x : s) {
+			total += x;
+		}
+
+		return total;
+	}
+
+	bool span_from_container() {
+		mm::inline_vector<int,4> v = span_source();
+		mm::span<int> s(v);
+		s[0] = 5;
+		return v[0] == 5 && span_sum(span_source()) == 3;
+	}
+
+	bool aligned_allocator_overflow() {
+		mm::aligned_allocator<mm::u64,64> alloc;
+		mm::u64* p = alloc.allocate(16);
+
+		if (!p || reinterpret_cast<uintptr_t>(p) % 64) {
+			return false;
+		}
+
+		alloc.deallocate(p,16);
+		return alloc.allocate(mm::size_t(-1) / 4) == nullptr && mm::detail::aligned_malloc(mm::size_t(-1) - 8,64) == nullptr;
+	}
+
+	int failures = 0;
+
+	void check(const char* name,bool (*fn)()) {
+		bool passed = fn();
+		printf("%s %s\n",passed ? "ok  " : "FAIL",name);
+		failures += passed ? 0 : 1;
+	}
+}
+
+int main() {
+	check("log/non_const_string",&log_non_const_string);
+	check("inline_vector/copy_after_insert",&inline_vector_copy_after_insert);
+	check("local_shared_ptr/share",&local_shared_ptr_share);
+	check("numa_resource/large_alignment",&numa_large_alignment);
+	check("alloc_counters/snapshot_reset",&alloc_counters_snapshot_reset);
+	check("span/from_container",&span_from_container);
+	check("aligned_allocator/overflow",&aligned_allocator_overflow);
+
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}